@@ -159,6 +159,8 @@ CSENSA-----TP29------>|PB0[D16/A2]     ~[D9]PC3|-------TP9--------->|PWMH1A  |
 
 #include <CommandLine.h>
 #include <DLK_L99DZ200G.h>
+#include <DLK_Telemetry.h>
+#include <DLK_Logger.h>
 
 #define TITLE_MSG           "DLK L99DZ200G Library L99DZ200G Driver Testing"
 
@@ -169,6 +171,7 @@ CSENSA-----TP29------>|PB0[D16/A2]     ~[D9]PC3|-------TP9--------->|PWMH1A  |
 #define HEARTBEAT_ON_INTERVAL   50      // mS
 #define HB_OUT                  99
 #define START_TIMEOUT           5000    // mS
+#define SCRUB_BUDGET_US         200     // uS of Control register scrubbing per loop()
 
 // specify pins to use
 #ifdef __AVR__      // this includes Arduino Nano Every MCU
@@ -224,11 +227,25 @@ CommandLine CmdLine(Serial);    // setup CommandLine to use standard Arduino Ser
 
 DLK_L99DZ200G L99dz200g(SPI_CLOCK, L99DZ200G_CS_PIN);
 
+DLK_Telemetry Telem(L99dz200g);     // binary telemetry stream ("tlm" command)
+
+DLK_Logger Logger;                  // status messages, written to Serial from loop() without waiting
+
+// telemetry channels: the motor position inputs (one ADC reading each, not averaged)
+static const uint8_t TelemPins[TELEM_CHANNELS] =
+    { MR200G1_X_POS_PIN, MR200G1_Y_POS_PIN, TK200G1_M_POSA_PIN, TK200G1_M_POSB_PIN };
+
 uint8_t OutHB = 0;                  // OUTn to be used with heartbeat LED
 volatile bool L99DZ200G_IntFlag = false;
 volatile bool L99DZ200G_ResetFlag = false;
 uint8_t HBridgePWM[4];              // 2 for H-Bridge A, 2 for H-Bridge B
 
+uint16_t TelemChannel(uint8_t channel, void * arg)
+{
+    (void)arg;
+    return analogRead(TelemPins[channel]);
+}
+
 void L99DZ200G_Int(void)
 {
     if (digitalRead(L99DZ200G_5V1_PIN) && digitalRead(L99DZ200G_NRST_PIN) && (!L99dz200g.L99DZ200G_WatchdogRunning()))
@@ -258,6 +275,7 @@ void L99DZ200G_Reset(void)
 void setup()
 {
     uint32_t start_time = millis();
+    bool warm = false;
 
     // init heartbeat LED
     pinMode(LED_PIN, OUTPUT);
@@ -294,13 +312,27 @@ void setup()
     pinMode(L99DZ200G_PWMH2B_PIN, OUTPUT);
     digitalWrite(L99DZ200G_PWMH2B_PIN, LOW);
 
+    // L99DZ200G kept running while the MCU restarted - attach to it without touching the outputs
+    if (digitalRead(L99DZ200G_5V1_PIN) && (L99DZ200G_WarmAttach() == L99DZ200G_OK))
+    {
+        warm = true;
+    }
+
     // setup serial port
     Serial.begin(115200);
 
     // generate the sign-on banner
     Serial.println();
 #if defined(TEENSYDUINO)
-    delay(2000);                 // allow time for Arduino's serial window to re-connect
+    // allow time for Arduino's serial window to re-connect
+    if (warm)
+    {
+        L99dz200g.L99DZ200G_Delay(2000);    // keep the watchdog serviced
+    }
+    else
+    {
+        delay(2000);
+    }
     Serial.println("Teensy MCU");
 #elif defined(ARDUINO_AVR_NANO_EVERY)
     Serial.println("Arduino Nano Every MCU");
@@ -312,17 +344,24 @@ void setup()
 
     Serial.println(F(TITLE_MSG));
 
-    delay(50);
+    if (warm)
+    {
+        Serial.println(F("L99DZ200G warm attach"));
+    }
+    else
+    {
+        delay(50);
 
-    PulseWake();    // initiate possible wake-up
+        PulseWake();    // initiate possible wake-up
 
-    while (!digitalRead(L99DZ200G_5V1_PIN))
-    {
-        if ((millis() - start_time) == START_TIMEOUT)
+        while (!digitalRead(L99DZ200G_5V1_PIN))
         {
-            Serial.println(F("MR200G1 5V1 Power On Failed!"));
+            if ((millis() - start_time) == START_TIMEOUT)
+            {
+                Serial.println(F("MR200G1 5V1 Power On Failed!"));
+            }
+            delay(1);
         }
-        delay(1);
     }
 
     // setup for L99DZ200G interrupt
@@ -336,6 +375,13 @@ void setup()
     attachPCINT(digitalPinToPinChangeInterrupt(L99DZ200G_NRST_PIN), L99DZ200G_Reset, RISING);
 #endif
 
+    Telem.Telem_SetChannelHandler(TelemChannel, NULL);
+
+    if (warm)
+    {
+        return;     // already initialized
+    }
+
     delay(5);       // allow power to stabilize in L99DZ200G
 
     // Initialize L99DZ200G
@@ -359,7 +405,9 @@ void loop()
     static uint32_t last_sr4 = 0xff0000;
     static uint32_t last_sr5 = 0xff0000;
     uint8_t gsb;
+    uint8_t repaired;
     uint32_t reg;
+    uint32_t sr[5];
 
     if (new_prompt)
     {
@@ -376,7 +424,7 @@ void loop()
     if (L99dz200g.L99DZ200G_CheckWdogExpired() && L99dz200g.L99DZ200G_WatchdogRunning())  // process watchdog
     {
         gsb = L99dz200g.L99DZ200G_GlobalStatusByte();
-        if (gsb != GSB_GSBN_MASK)
+        if ((gsb != GSB_GSBN_MASK) && !Telem.Telem_Running())   // the telemetry frames carry them
         {
             // Note: In case of a watchdog failure, the Fail Safe mode (GSB.FS)will be entered
             //       and the watchdog trigger time will be reset to 10 mS. In order to exit
@@ -386,51 +434,55 @@ void loop()
             {
 DEBUG_TOGL();
                 last_gsb = gsb;
-                Serial.print("GSB: ");
-                Print0xHexByteln(gsb);
+                LOG_W(Logger, "GSB: 0x%02lX", gsb);
 DEBUG_TOGL();
             }
 
-            reg = L99dz200g.L99DZ200G_ReadRegister(L99DZ200G_SR1) & FULL_REG_MASK;
+            // read SR1 to SR5 in a single SPI session
+            {
+                DLK_L99DZ200G_Session session(L99dz200g);
+
+                for (uint8_t i = 0; i < 5; ++i)
+                {
+                    sr[i] = L99dz200g.L99DZ200G_ReadRegister(L99DZ200G_SR1 + i) & FULL_REG_MASK;
+                }
+            }
+
+            reg = sr[0];
             if ((reg != 0) && (reg != last_sr1))
             {
 DEBUG_TOGL();
                 last_sr1 = reg;
-                Serial.print("SR1: ");
-                Print0xHex24ln(reg);
+                LOG_W(Logger, "SR1: 0x%06lX", reg);
 DEBUG_TOGL();
             }
 
-            reg = L99dz200g.L99DZ200G_ReadRegister(L99DZ200G_SR2) & FULL_REG_MASK;
+            reg = sr[1];
             if ((reg != 0) && (reg != last_sr2))
             {
                 last_sr2 = reg;
-                Serial.print("SR2: ");
-                Print0xHex24ln(reg);
+                LOG_W(Logger, "SR2: 0x%06lX", reg);
             }
 
-            reg = L99dz200g.L99DZ200G_ReadRegister(L99DZ200G_SR3) & FULL_REG_MASK;
+            reg = sr[2];
             if ((reg != 0) && (reg != last_sr3))
             {
                 last_sr3 = reg;
-                Serial.print("SR3: ");
-                Print0xHex24ln(reg);
+                LOG_W(Logger, "SR3: 0x%06lX", reg);
             }
 
-            reg = L99dz200g.L99DZ200G_ReadRegister(L99DZ200G_SR4) & FULL_REG_MASK;
+            reg = sr[3];
             if ((reg != 0) && (reg != last_sr4))
             {
                 last_sr4 = reg;
-                Serial.print("SR4: ");
-                Print0xHex24ln(reg);
+                LOG_W(Logger, "SR4: 0x%06lX", reg);
             }
 
-            reg = L99dz200g.L99DZ200G_ReadRegister(L99DZ200G_SR5) & FULL_REG_MASK;
+            reg = sr[4];
             if ((reg != 0) && (reg != last_sr5))
             {
                 last_sr5 = reg;
-                Serial.print("SR5: ");
-                Print0xHex24ln(reg);
+                LOG_W(Logger, "SR5: 0x%06lX", reg);
             }
         }
     }
@@ -440,16 +492,20 @@ DEBUG_TOGL();
         L99DZ200G_IntFlag = false;
         L99DZ200G_ResetFlag = false;
 
-        // Re-initialize L99DZ200G
-        if (L99DZ200G_Init() != L99DZ200G_OK)
-        {
-            Serial.println(F("L99DZ200G_Init() failed!"));
-            while (1)
-            {
-                yield();    // needed by ESP8266 to prevent Soft WDT reset "rst cause:2, boot mode:(3,6)"
-            }
-        }
-        Serial.println("L99DZ200G Interrupt!");
+        L99dz200g.L99DZ200G_WdogTrigger();
+
+        L99dz200g.L99DZ200G_ClearAllStatusRegisters();
+
+        // Read and clear SR1 (exit from fail safe)
+        L99dz200g.L99DZ200G_ReadClearRegister(L99DZ200G_SR1, FULL_REG_MASK);
+
+        // clear standby mode setting, and service the watchdog again (woken from standby)
+        L99dz200g.L99DZ200G_SetModeControl(ACTIVE_STBY);
+        L99dz200g.L99DZ200G_SetWatchdogRunning(true);
+
+        // repair only the Control registers that differ from what was written (instead of re-initializing)
+        repaired = L99dz200g.L99DZ200G_ScrubTick(0);
+        LOG_W(Logger, "L99DZ200G Interrupt! (%lu register(s) repaired)", repaired);
     }
     else if (L99DZ200G_ResetFlag)
     {
@@ -467,7 +523,24 @@ DEBUG_TOGL();
                 yield();    // needed by ESP8266 to prevent Soft WDT reset "rst cause:2, boot mode:(3,6)"
             }
         }
-        Serial.println("L99DZ200G Reset!");
+        LOG_W(Logger, "L99DZ200G Reset!");
+    }
+
+    // check a Control register or two against what was written to them
+    // If watchdog is not running, assumes L99DZ200G is in a standby mode
+    // and should not be disturbed by SPI communications!
+    if (L99dz200g.L99DZ200G_WatchdogRunning())
+    {
+        L99dz200g.L99DZ200G_ScrubTick(SCRUB_BUDGET_US);
+    }
+
+    // stream telemetry frames (never waits for Serial)
+    Telem.Telem_Tick();
+
+    // write logged messages (never waits for Serial, held while telemetry is streaming)
+    if (!Telem.Telem_Running())
+    {
+        Logger.Log_Drain(Serial);
     }
 
     // do other stuff here
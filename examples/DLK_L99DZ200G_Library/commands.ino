@@ -37,16 +37,21 @@
 #define SHOW_OCR        //
 #define SHOW_OCT        //
 #define SHOW_OLT        //
+#define SHOW_PROFILE
 #define SHOW_PWM        //
 #define SHOW_RDSON      //
+#define SHOW_SCRUB
 #define SHOW_SCT        //
+#define SHOW_SPI
 #define SHOW_STAT       //
 //#define SHOW_STAT_DETAIL
+#define SHOW_TELEM
 #define SHOW_TEMP       //
 #define SHOW_TIMER      //
 #define SHOW_TNINT
 #define SHOW_V1RESET
 #define SHOW_V2         //
+#define SHOW_VERIFY
 #define SHOW_VLED
 #define SHOW_VOLT       //
 //#define SHOW_VS
@@ -120,21 +125,33 @@ int8_t Cmd_outgh(int8_t argc, char * argv[]);
 #ifdef SHOW_MOTOR
 int8_t Cmd_outm(int8_t argc, char * argv[]);
 #endif
+#ifdef SHOW_PROFILE
+int8_t Cmd_prof(int8_t argc, char * argv[]);
+#endif
 #ifdef SHOW_PWM
 int8_t Cmd_pwm(int8_t argc, char * argv[]);
 #endif
 #ifdef SHOW_RDSON
 int8_t Cmd_rdson(int8_t argc, char * argv[]);
 #endif
+#ifdef SHOW_SCRUB
+int8_t Cmd_scrub(int8_t argc, char * argv[]);
+#endif
 #ifdef SHOW_SCT
 int8_t Cmd_sct(int8_t argc, char * argv[]);
 #endif
+#ifdef SHOW_SPI
+int8_t Cmd_spi(int8_t argc, char * argv[]);
+#endif
 #ifdef SHOW_STAT
 int8_t Cmd_stat(int8_t argc, char * argv[]);
 #endif
 #ifdef SHOW_TEMP
 int8_t Cmd_temp(int8_t argc, char * argv[]);
 #endif
+#ifdef SHOW_TELEM
+int8_t Cmd_tlm(int8_t argc, char * argv[]);
+#endif
 #ifdef SHOW_TIMER
 int8_t Cmd_tmr(int8_t argc, char * argv[]);
 #endif
@@ -147,6 +164,9 @@ int8_t Cmd_v1t(int8_t argc, char * argv[]);
 #ifdef SHOW_V2
 int8_t Cmd_v2(int8_t argc, char * argv[]);
 #endif
+#ifdef SHOW_VERIFY
+int8_t Cmd_vfy(int8_t argc, char * argv[]);
+#endif
 #ifdef SHOW_VLED
 int8_t Cmd_vled(int8_t argc, char * argv[]);
 #endif
@@ -251,21 +271,33 @@ const char MenuCmdOutgh[] PROGMEM = "outgh";
 #ifdef SHOW_MOTOR
 const char MenuCmdOutm[] PROGMEM  = "outm";
 #endif
+#ifdef SHOW_PROFILE
+const char MenuCmdProf[] PROGMEM  = "prof";
+#endif
 #ifdef SHOW_PWM
 const char MenuCmdPwm[] PROGMEM   = "pwm";
 #endif
 #ifdef SHOW_RDSON
 const char MenuCmdRdson[] PROGMEM = "rdson";
 #endif
+#ifdef SHOW_SCRUB
+const char MenuCmdScrub[] PROGMEM = "scrub";
+#endif
 #ifdef SHOW_SCT
 const char MenuCmdSct[] PROGMEM   = "sct";
 #endif
+#ifdef SHOW_SPI
+const char MenuCmdSpi[] PROGMEM   = "spi";
+#endif
 #ifdef SHOW_STAT
 const char MenuCmdStat[] PROGMEM  = "stat";
 #endif
 #ifdef SHOW_TEMP
 const char MenuCmdTemp[] PROGMEM  = "temp";
 #endif
+#ifdef SHOW_TELEM
+const char MenuCmdTlm[] PROGMEM   = "tlm";
+#endif
 #ifdef SHOW_TIMER
 const char MenuCmdTmr[] PROGMEM   = "tmr";
 #endif
@@ -278,6 +310,9 @@ const char MenuCmdV1t[] PROGMEM   = "v1t";
 #ifdef SHOW_V2
 const char MenuCmdV2[] PROGMEM    = "v2";
 #endif
+#ifdef SHOW_VERIFY
+const char MenuCmdVfy[] PROGMEM   = "vfy";
+#endif
 #ifdef SHOW_VLED
 const char MenuCmdVled[] PROGMEM  = "vled";
 #endif
@@ -309,7 +344,7 @@ const char MenuHelp2[] PROGMEM     = "                                : alias fo
 const char MenuHelpRreg[] PROGMEM  =    " reg [cnt]                   : Show L99DZ200G register(s) value(s)";
 const char MenuHelpWreg[] PROGMEM  =    " [reg val] | <all>           : Set(reset all) L99DZ200G control register value(s)";
 #ifdef SHOW_RROM
-const char MenuHelpRrom[] PROGMEM  =    " addr [cnt]                  : Show L99DZ200G ROM address(es) value(s)";
+const char MenuHelpRrom[] PROGMEM  =    " [addr [cnt]]                : Show L99DZ200G device info or ROM address(es) value(s)";
 #endif
 const char MenuHelpRclr[] PROGMEM  =    " [reg val] | <all>           : Read/clear L99DZ200G status register(s)";
 #ifdef SHOW_ADC
@@ -371,15 +406,24 @@ const char MenuHelpOutgh[] PROGMEM =     " [off | on]                 : Show[set
 #ifdef SHOW_MOTOR
 const char MenuHelpOutm[] PROGMEM  =    " [n [off | lo | hi]]         : Show[set] L99DZ200G OUTm motor output control";
 #endif
+#ifdef SHOW_PROFILE
+const char MenuHelpProf[] PROGMEM  =    " [read]                      : Restore L99DZ200G bring-up configuration profile";
+#endif
 #ifdef SHOW_PWM
-const char MenuHelpPwm[] PROGMEM   =   " [chan [freq [duty]]]         : Show[set] L99DZ200G PWM settings";
+const char MenuHelpPwm[] PROGMEM   =   " [chan [freq [duty] | lvl n]] : Show[set] L99DZ200G PWM settings";
 #endif
 #ifdef SHOW_RDSON
 const char MenuHelpRdson[] PROGMEM =     " [n [lo | hi]]              : Show[set] L99DZ200G OUTn Rdson output control";
 #endif
+#ifdef SHOW_SCRUB
+const char MenuHelpScrub[] PROGMEM =     " [all | clr]                 : Show L99DZ200G Control register scrubbing (scrub all now)";
+#endif
 #ifdef SHOW_SCT
 const char MenuHelpSct[] PROGMEM   =   " [n [off | on]]               : Show[set] L99DZ200G OUTn short circuit threshold control";
 #endif
+#ifdef SHOW_SPI
+const char MenuHelpSpi[] PROGMEM   =   " [kHz | test kHz | cal [max]]  : Show[set | test | calibrate] L99DZ200G SPI clock";
+#endif
 #ifdef SHOW_STAT
 const char MenuHelpStat[] PROGMEM  =    " [[can | ecv | hb | lin | ms | oc | ocr | ol | sc | spi | tsd | tw | vo | wd | wu] [clr]]"
                                 "\r\n                                 : Show all or specific L99DZ200G status registers";
@@ -387,6 +431,9 @@ const char MenuHelpStat[] PROGMEM  =    " [[can | ecv | hb | lin | ms | oc | ocr
 #ifdef SHOW_TEMP
 const char MenuHelpTemp[] PROGMEM  =    "                             : Show L99DZ200G thermal clusters temperatures";
 #endif
+#ifdef SHOW_TELEM
+const char MenuHelpTlm[] PROGMEM   =   " [off | period]               : Stream[stop] L99DZ200G binary telemetry frames";
+#endif
 #ifdef SHOW_TIMER
 const char MenuHelpTmr[] PROGMEM   =   " [n [per [ton [rst [dir]]]    : Show[set] L99DZ200G Timer settings";
 #endif
@@ -399,6 +446,10 @@ const char MenuHelpV1t[] PROGMEM   =   " [threshold]                  : Show[set
 #ifdef SHOW_V2
 const char MenuHelpV2[] PROGMEM    =  " [[off | act | actv1 | on] [reg | trk]] : Show[set] L99DZ200G V2 regulator mode";
 #endif
+#ifdef SHOW_VERIFY
+const char MenuHelpVfy[] PROGMEM   =   " [[never | always | nth n | crit] [r] | clr]"
+                                "\r\n                                 : Show[set] L99DZ200G register write verification (r = retries)";
+#endif
 #ifdef SHOW_VLED
 const char MenuHelpVled[] PROGMEM  =    " [n [vled] | [off | on]]     : Show[set] L99DZ200G OUTn Vs VLED Compensation control";
 #endif
@@ -501,21 +552,33 @@ const tCmdLineEntry g_sCmdTable[] PROGMEM =
 #ifdef SHOW_MOTOR
     { MenuCmdOutm,    Cmd_outm,    MenuHelpOutm    },
 #endif
+#ifdef SHOW_PROFILE
+    { MenuCmdProf,    Cmd_prof,    MenuHelpProf    },
+#endif
 #ifdef SHOW_PWM
     { MenuCmdPwm,     Cmd_pwm,     MenuHelpPwm     },
 #endif
 #ifdef SHOW_RDSON
     { MenuCmdRdson,   Cmd_rdson,   MenuHelpRdson   },
 #endif
+#ifdef SHOW_SCRUB
+    { MenuCmdScrub,   Cmd_scrub,   MenuHelpScrub   },
+#endif
 #ifdef SHOW_SCT
     { MenuCmdSct,     Cmd_sct,     MenuHelpSct     },
 #endif
+#ifdef SHOW_SPI
+    { MenuCmdSpi,     Cmd_spi,     MenuHelpSpi     },
+#endif
 #ifdef SHOW_STAT
     { MenuCmdStat,    Cmd_stat,    MenuHelpStat    },
 #endif
 #ifdef SHOW_TEMP
     { MenuCmdTemp,    Cmd_temp,    MenuHelpTemp    },
 #endif
+#ifdef SHOW_TELEM
+    { MenuCmdTlm,     Cmd_tlm,     MenuHelpTlm     },
+#endif
 #ifdef SHOW_TIMER
     { MenuCmdTmr,     Cmd_tmr,     MenuHelpTmr     },
 #endif
@@ -528,6 +591,9 @@ const tCmdLineEntry g_sCmdTable[] PROGMEM =
 #ifdef SHOW_V2
     { MenuCmdV2,      Cmd_v2,      MenuHelpV2      },
 #endif
+#ifdef SHOW_VERIFY
+    { MenuCmdVfy,     Cmd_vfy,     MenuHelpVfy     },
+#endif
 #ifdef SHOW_VLED
     { MenuCmdVled,    Cmd_vled,    MenuHelpVled    },
 #endif
@@ -1091,14 +1157,15 @@ DEBUG_TOGL();
  *  char * argv[] = pointer to array of parameters associated with the command
  *
  * WHAT:
- *  Implements the "rrom" command to read and show an L99DZ200G Device Information Register address.
+ *  Implements the "rrom" command to show the L99DZ200G device information or
+ *  Device Information Register address(es).
  *
- *  One required parameter supported.
+ *  Two optional parameters supported.
  *   addr = the Device Information Registers address(es) to read from
- *  One optional parameter supported.
  *   cnt = the number of Device Information Registers address(es) to read from
  *
  *        1   2    3
+ *     "rrom"           - show L99DZ200G device information
  *     "rrom 0x10"      - read L99DZ200G Device Information Registers address 0x10
  *     "rrom 0x02 10"   - read L99DZ200G Device Information Registers addresses 0x02 to 0x0b
  *
@@ -1106,7 +1173,9 @@ DEBUG_TOGL();
  *  int8_t = 0 = command successfully processed
  *
  * SPECIAL CONSIDERATIONS:
- *  None.
+ *  The values come from the device information cached by L99DZ200G_Init() when it
+ *  was read successfully (the ROM does not change), or read here the first time after a
+ *  warm attach.
  */
 int8_t Cmd_rrom(int8_t argc, char * argv[])
 {
@@ -1115,10 +1184,29 @@ int8_t Cmd_rrom(int8_t argc, char * argv[])
     uint8_t romaddr;
     uint8_t romcnt = 1;
     uint8_t romval;
+    const L99DZ200GDeviceInfo * info = L99dz200g.L99DZ200G_GetDeviceInfo();
 
     if (argc < 2)
     {
-        return CMDLINE_TOO_FEW_ARGS;
+        if (!info->valid && (L99dz200g.L99DZ200G_ReadDeviceInfo() != L99DZ200G_OK))
+        {
+            Serial.println(F("L99DZ200G device info not available!"));
+            return 0;
+        }
+        Serial.print(F("ID Header: "));
+        Print0xHexByteln(info->id_header);
+        Serial.print(F("Version: "));
+        Print0xHexByteln(info->version);
+        Serial.print(F("Product Code: "));
+        Print0xHex16ln(info->product_code);
+        Serial.print(F("Silicon Version: "));
+        Print0xHexByteln(info->silicon_version);
+        Serial.print(F("SPI Frame ID: "));
+        Print0xHexByteln(info->spi_frame_id);
+        Serial.print(F("WD Type: "));
+        Print0xHex16ln(info->wd_type);
+        Serial.print(F("WD Bit Position: "));
+        Print0xHex16ln(info->wd_bit_pos);
     }
     else if (argc > 3)
     {
@@ -1126,10 +1214,10 @@ int8_t Cmd_rrom(int8_t argc, char * argv[])
     }
     else
     {
-        // get the Device Information Registers ROM address (0x00 to 0x3f)
+        // get the Device Information Registers ROM address (0x00 to 0x3e, 0x3f would reset the Control registers)
         paramtype = CmdLine.ParseParam(argv[ARG1], &val);
         if ((paramtype == BADPARAM) || (paramtype == STRVAL)  ||
-            (val > L99DZ200G_CFR))
+            (val >= L99DZ200G_CFR))
         {
             return CMDLINE_INVALID_ARG;
         }
@@ -1148,7 +1236,7 @@ int8_t Cmd_rrom(int8_t argc, char * argv[])
 
         for (uint8_t i = 0; i < romcnt; ++i)
         {
-            if ((romaddr + i) > L99DZ200G_CFR)
+            if ((romaddr + i) >= L99DZ200G_CFR)
             {
                 break;      // invalid Device Information Registers ROM address
             }
@@ -1156,7 +1244,14 @@ int8_t Cmd_rrom(int8_t argc, char * argv[])
             Serial.print(F("L99DZ200G Address "));
             Print0xHexByte(romaddr + i);
             Serial.print(F(": "));
-            romval = L99dz200g.L99DZ200G_ReadRomAddress(romaddr + i);
+            if (info->valid && ((romaddr + i) < ROM_SIZE) && (info->rom[romaddr + i] != 0))
+            {
+                romval = info->rom[romaddr + i];    // cached ROM_xxx address (0 = not cached, read it)
+            }
+            else
+            {
+                romval = L99dz200g.L99DZ200G_ReadRomAddress(romaddr + i);
+            }
             Print0xHexByteln(romval);
         }
     }
@@ -1287,6 +1382,50 @@ int8_t Cmd_init(int8_t argc __attribute__((unused)), char * argv[] __attribute__
     return L99DZ200G_Init();
 }
 
+// L99DZ200G bring-up configuration profile (CR1 to CR22, CFR)
+const L99DZ200GProfile InitProfile PROGMEM =
+{{
+    // CR1: V2 on in active mode
+    { CR1_V2_MODE_MASK, ON_ACTIVEMODE },
+    // CR2: 200 mS watchdog
+    { CR2_WD_TIME_MASK, L99DZ200G_PROFILE_FIELD(WDOG_TIME_200MS, CR2_WD_TIME_MASK, CR2_WD_TIME_POS) },
+    L99DZ200G_PROFILE_NONE,                 // CR3
+    L99DZ200G_PROFILE_NONE,                 // CR4
+    L99DZ200G_PROFILE_NONE,                 // CR5
+    L99DZ200G_PROFILE_NONE,                 // CR6
+    // CR7: Overcurrent recovery to protect for overcurrents, DIR input on L99DZ200G CM_DIR pin
+    { CR7_OUT1_OCR_MASK | CR7_OUT2_OCR_MASK | CR7_OUT3_OCR_MASK | CR7_OUT6_OCR_MASK |
+      CR7_OUT7_OCR_MASK | CR7_OUT8_OCR_MASK | CR7_OUT15_OCR_MASK | CR7_CM_DIR_MASK,
+      CR7_OUT1_OCR_MASK | CR7_OUT2_OCR_MASK | CR7_OUT3_OCR_MASK | CR7_OUT6_OCR_MASK |
+      CR7_OUT7_OCR_MASK | CR7_OUT8_OCR_MASK | CR7_OUT15_OCR_MASK |
+      L99DZ200G_PROFILE_FIELD(DIR_ALWAYS, CR7_CM_DIR_MASK, CR7_CM_DIR_POS) },
+    // CR8: OUT1, OUT2, OUT3, OUT6 Overcurrent recovery time and frequency
+    { CR8_OUT1_2_3_6_TIME_MASK | CR8_OUT1_2_3_6_FREQ_MASK,
+      L99DZ200G_PROFILE_FIELD(OCR_TON_64US, CR8_OUT1_2_3_6_TIME_MASK, CR8_OUT1_2_3_6_TIME_POS) |
+      L99DZ200G_PROFILE_FIELD(OCR_FREQ_4_4KHZ, CR8_OUT1_2_3_6_FREQ_MASK, CR8_OUT1_2_3_6_FREQ_POS) },
+    L99DZ200G_PROFILE_NONE,                 // CR9
+    L99DZ200G_PROFILE_NONE,                 // CR10
+    L99DZ200G_PROFILE_NONE,                 // CR11
+    L99DZ200G_PROFILE_NONE,                 // CR12
+    L99DZ200G_PROFILE_NONE,                 // CR13
+    L99DZ200G_PROFILE_NONE,                 // CR14
+    L99DZ200G_PROFILE_NONE,                 // CR15
+    L99DZ200G_PROFILE_NONE,                 // CR16
+    L99DZ200G_PROFILE_NONE,                 // CR17
+    L99DZ200G_PROFILE_NONE,                 // CR18
+    L99DZ200G_PROFILE_NONE,                 // CR19
+    L99DZ200G_PROFILE_NONE,                 // CR20
+    L99DZ200G_PROFILE_NONE,                 // CR21
+    // CR22: V1 load current supervision disabled
+    { CR22_ICMP_MASK, L99DZ200G_PROFILE_FIELD(IC_DISABLE, CR22_ICMP_MASK, CR22_ICMP_POS) },
+    // CFR: Forced FSO outputs disabled, WU pin is wake-up input, V2 as 5V regulator,
+    //      1.5V Electrochromic maximum voltage
+    { CFR_FS_FORCED_MASK | CFR_WU_CFG_MASK | CFR_V2_CFG_MASK | CFR_ECV_HV_MASK,
+      L99DZ200G_PROFILE_FIELD(DISABLE, CFR_FS_FORCED_MASK, CFR_FS_FORCED_POS) |
+      L99DZ200G_PROFILE_FIELD(WU_WU, CFR_WU_CFG_MASK, CFR_WU_CFG_POS) | V2_VREG_TYPE |
+      L99DZ200G_PROFILE_FIELD(ECV_1_5, CFR_ECV_HV_MASK, CFR_ECV_H_POS) },
+}};
+
 // do L99DZ200G initialization
 uint8_t L99DZ200G_Init(void)
 {
@@ -1297,9 +1436,6 @@ uint8_t L99DZ200G_Init(void)
 
     L99dz200g.L99DZ200G_WdogTrigger();
 
-    // Ensure Forced FSO outputs is disabled
-    L99dz200g.L99DZ200G_Set_HB_Forced_LSx_FSO_Control(DISABLE);
-
     L99dz200g.L99DZ200G_ClearAllStatusRegisters();
 
     // Read and clear SR1 (exit from fail safe)
@@ -1309,38 +1445,16 @@ uint8_t L99DZ200G_Init(void)
     // clear standby mode setting
     L99dz200g.L99DZ200G_SetModeControl(ACTIVE_STBY);
 
-    L99dz200g.L99DZ200G_SetWdogTime(WDOG_TIME_200MS);
+    // write only the configuration that differs from what is in the L99DZ200G
+    // (200 mS watchdog, V1 load current supervision off, WU input, OCR, V2 on as 5V regulator,
+    //  DIR input on CM_DIR pin, ECV maximum voltage - see InitProfile)
+    L99dz200g.L99DZ200G_ApplyProfile(&InitProfile, true);
 
     L99dz200g.L99DZ200G_SetWatchdogRunning(true);
 
-#if 1   // for testing
-    // Disable V1 load current supervision
-    L99dz200g.L99DZ200G_Set_ICMP_Control(IC_DISABLE);
-
-    // Set WU pin to wake-up input
-    L99dz200g.L99DZ200G_Set_WU_PinModeConfig(WU_WU);
-#endif
-
-#if 1
-    // Set OCR Overcurrent recovery to protect for overcurrents
-    L99dz200g.L99DZ200G_Set_OCR_AutorecoveryControl(OUT_1, ENABLE);
-    L99dz200g.L99DZ200G_Set_OCR_AutorecoveryControl(OUT_2, ENABLE);
-    L99dz200g.L99DZ200G_Set_OCR_AutorecoveryControl(OUT_3, ENABLE);
-    L99dz200g.L99DZ200G_Set_OCR_AutorecoveryControl(OUT_6, ENABLE);
-    L99dz200g.L99DZ200G_Set_OCR_AutorecoveryControl(OUT_7, ENABLE);
-    L99dz200g.L99DZ200G_Set_OCR_AutorecoveryControl(OUT_8, ENABLE);
-    L99dz200g.L99DZ200G_Set_OCR_AutorecoveryControl(OUT_15, ENABLE);
-
-    L99dz200g.L99DZ200G_Set_OCR_AutorecoveryTime(OUT_1_2_3_6, OCR_TON_64US);
-    L99dz200g.L99DZ200G_Set_OCR_AutorecoveryFrequency(OUT_1_2_3_6, OCR_FREQ_4_4KHZ);
-#endif
-
     // ECV fast discharge activated - this causes -> GSB: 0x08, SR5: 0x000080
 //    L99dz200g.L99DZ200G_Set_ECV_FastDischargeControl(ENABLE);
 
-    // Set V2 on as 5V regulator
-    L99dz200g.L99DZ200G_V2_Config(ON_ACTIVEMODE, V2_VREG_TYPE);
-
     L99dz200g.L99DZ200G_Delay(500);
 
 #if 0
@@ -1350,18 +1464,19 @@ uint8_t L99DZ200G_Init(void)
     L99dz200g.L99DZ200G_SetConstantCurrentModeControl(OUT_8, ENABLE);
 #endif
 
-    // enable DIR input on L99DZ200G CM_DIR pin
-    L99dz200g.L99DZ200G_CM_DIR_Config(DIR_ALWAYS);
-
-    // Setting the Maximum voltage of Electrochromic
-    L99dz200g.L99DZ200G_Set_ECV_MaxVoltage(ECV_1_5);
-
     // Enabling of the Fast Discharge - this causes -> GSB: 0x08, SR5: 0x000080
 //    L99dz200g.L99DZ200G_Set_ECV_FastDischargeControl(ENABLE);
 
     return L99DZ200G_OK;
 }
 
+// attach to a running L99DZ200G after an MCU restart (no outputs touched)
+uint8_t L99DZ200G_WarmAttach(void)
+{
+    // must still be configured as by L99DZ200G_Init() above (reads the live registers only)
+    return L99dz200g.L99DZ200G_WarmAttach(&InitProfile);
+}
+
 #ifdef SHOW_ADC
 /*
  * NAME:
@@ -4986,6 +5101,59 @@ void ShowOutputStateM(uint8_t output)
 }
 #endif
 
+#ifdef SHOW_PROFILE
+/*
+ * NAME:
+ *  int8_t Cmd_prof(int8_t argc, char * argv[])
+ *
+ * PARAMETERS:
+ *  int8_t argc = number of command line arguments for the command
+ *  char * argv[] = pointer to array of parameters associated with the command
+ *
+ * WHAT:
+ *  Implements the "prof" command to restore the L99DZ200G bring-up configuration profile.
+ *
+ *  One optional parameter supported.
+ *   read = diff the profile against the L99DZ200G registers (default is the shadow images)
+ *
+ *       1     2
+ *     "prof"           - write the Control registers that differ from the profile shadow images
+ *     "prof read"      - write the Control registers that differ from the profile L99DZ200G registers
+ *
+ * RETURN VALUES:
+ *  int8_t = 0 = command successfully processed
+ *
+ * SPECIAL CONSIDERATIONS:
+ *  None.
+ */
+int8_t Cmd_prof(int8_t argc, char * argv[])
+{
+    bool read_device = false;
+
+    if (argc > 2)
+    {
+        return CMDLINE_TOO_MANY_ARGS;
+    }
+    else if (argc > 1)
+    {
+        if (strcmp_P(argv[ARG1], PSTR("read")) == 0)
+        {
+            read_device = true;
+        }
+        else
+        {
+            return CMDLINE_INVALID_ARG;
+        }
+    }
+
+    Serial.print(F("Profile register writes: "));
+    Serial.println(L99dz200g.L99DZ200G_ApplyProfile(&InitProfile, read_device));
+
+    // Return success.
+    return 0;
+}
+#endif
+
 #ifdef SHOW_PWM
 /*
  * NAME:
@@ -5000,8 +5168,8 @@ void ShowOutputStateM(uint8_t output)
  *
  *  Three optional parameters supported.
  *   <chan> = the PWM channel to use
- *   <freq> = the PWM frequency to use
- *   <duty> = the PWM duty cycle (%) to use
+ *   <freq> = the PWM frequency to use, or "lvl" = set perceptual brightness level
+ *   <duty> = the PWM duty cycle (%) to use, or the brightness level (0 to 255) after "lvl"
  *
  *        1  2  3  4
  *     "pwm"           - show all channels PWM settings
@@ -5013,6 +5181,8 @@ void ShowOutputStateM(uint8_t output)
  *     "pwm  5 100 50  - set PWM channel 5 to 100 Hz, 50% duty cycle
  *     "pwm  6 200 75  - set PWM channel 6 to 200 Hz, 75% duty cycle
  *     "pwm  7 330 90  - set PWM channel 7 to 330 Hz, 90% duty cycle
+ *     "pwm  1 lvl 64  - set PWM channel 1 to brightness level 64 (gamma corrected duty,
+ *                       frequency selected for the level)
  *
  * RETURN VALUES:
  *  int8_t = 0 = command successfully processed
@@ -5043,7 +5213,22 @@ int8_t Cmd_pwm(int8_t argc, char * argv[])
         }
         pwm_chan = val;
 
-        if (argc > 2)
+        if ((argc > 2) && (strcmp_P(argv[ARG2], PSTR("lvl")) == 0))
+        {
+            // get the perceptual brightness level
+            if (argc < 4)
+            {
+                return CMDLINE_INVALID_ARG;
+            }
+            paramtype = CmdLine.ParseParam(argv[ARG3], &val);
+            if ((paramtype == BADPARAM) || (paramtype == STRVAL) ||
+                (val < 0) || (val > PWM_LEVEL_MAX))
+            {
+                return CMDLINE_INVALID_ARG;
+            }
+            L99dz200g.L99DZ200G_SetPWMBrightness(pwm_chan, val);
+        }
+        else if (argc > 2)
         {
             // get the PWM frequency
             paramtype = CmdLine.ParseParam(argv[ARG2], &val);
@@ -5377,6 +5562,71 @@ void ShowRdsonSetting(uint8_t output)
 }
 #endif
 
+#ifdef SHOW_SCRUB
+/*
+ * NAME:
+ *  int8_t Cmd_scrub(int8_t argc, char * argv[])
+ *
+ * PARAMETERS:
+ *  int8_t argc = number of command line arguments for the command
+ *  char * argv[] = pointer to array of parameters associated with the command
+ *
+ * WHAT:
+ *  Implements the "scrub" command to show the L99DZ200G Control register scrubber statistics.
+ *
+ *  One optional parameter supported.
+ *   all = scrub all shadowed Control registers now
+ *   clr = clear the scrubber statistics
+ *
+ *       1     2
+ *     "scrub"          - show scrubber statistics
+ *     "scrub all"      - scrub all shadowed Control registers now
+ *     "scrub clr"      - clear scrubber statistics
+ *
+ * RETURN VALUES:
+ *  int8_t = 0 = command successfully processed
+ *
+ * SPECIAL CONSIDERATIONS:
+ *  None.
+ */
+int8_t Cmd_scrub(int8_t argc, char * argv[])
+{
+    L99DZ200GScrubStats stats;
+
+    if (argc > 2)
+    {
+        return CMDLINE_TOO_MANY_ARGS;
+    }
+    else if (argc > 1)
+    {
+        if (strcmp_P(argv[ARG1], PSTR("all")) == 0)
+        {
+            Serial.print(F("Repaired: "));
+            Serial.println(L99dz200g.L99DZ200G_ScrubTick(0));
+        }
+        else if (strcmp_P(argv[ARG1], PSTR("clr")) == 0)
+        {
+            L99dz200g.L99DZ200G_ClearScrubStats();
+        }
+        else
+        {
+            return CMDLINE_INVALID_ARG;
+        }
+    }
+
+    L99dz200g.L99DZ200G_GetScrubStats(&stats);
+    Serial.print(F("SCRUB: checked: "));
+    Serial.print(stats.checked);
+    Serial.print(F("  repaired: "));
+    Serial.print(stats.repaired);
+    Serial.print(F("  passes: "));
+    Serial.println(stats.passes);
+
+    // Return success.
+    return 0;
+}
+#endif
+
 #ifdef SHOW_SCT
 /*
  * NAME:
@@ -5517,6 +5767,120 @@ void ShowShortCircuitThresholdSetting(uint8_t output)
 }
 #endif
 
+#ifdef SHOW_SPI
+/*
+ * NAME:
+ *  int8_t Cmd_spi(int8_t argc, char * argv[])
+ *
+ * PARAMETERS:
+ *  int8_t argc = number of command line arguments for the command
+ *  char * argv[] = pointer to array of parameters associated with the command
+ *
+ * WHAT:
+ *  Implements the "spi" command to show/set/test/calibrate the L99DZ200G SPI clock.
+ *
+ *  Two optional parameters supported.
+ *   <kHz> = the SPI clock (kHz) to use
+ *   cal = find and select the fastest reliable SPI clock
+ *   test = test the SPI clock
+ *   <max kHz> = the fastest SPI clock (kHz) to try
+ *
+ *       1    2    3
+ *     "spi"                - show L99DZ200G SPI clock
+ *     "spi 2000"           - set L99DZ200G SPI clock to 2000 kHz
+ *     "spi test 8000"      - test L99DZ200G SPI frames at 8000 kHz
+ *     "spi cal"            - calibrate L99DZ200G SPI clock (up to L99DZ200G_SPI_MAX_CLOCK)
+ *     "spi cal 16000"      - calibrate L99DZ200G SPI clock (up to 16000 kHz)
+ *
+ * RETURN VALUES:
+ *  int8_t = 0 = command successfully processed
+ *
+ * SPECIAL CONSIDERATIONS:
+ *  Calibration clocks faster than L99DZ200G_SPI_MAX_CLOCK are outside of the L99DZ200G
+ *  specification, use them only to check the wiring margin.
+ */
+int8_t Cmd_spi(int8_t argc, char * argv[])
+{
+    int8_t paramtype;
+    int32_t val = L99DZ200G_SPI_MAX_CLOCK / 1000;
+    uint32_t spi_speed;
+
+    if (argc > 3)
+    {
+        return CMDLINE_TOO_MANY_ARGS;
+    }
+    else if (argc > 1)
+    {
+        if (strcmp_P(argv[ARG1], PSTR("cal")) == 0)
+        {
+            if (argc > 2)
+            {
+                // get the fastest SPI clock to try
+                paramtype = CmdLine.ParseParam(argv[ARG2], &val);
+                if ((paramtype == BADPARAM) || (paramtype == STRVAL) || (val <= 0))
+                {
+                    return CMDLINE_INVALID_ARG;
+                }
+            }
+
+            spi_speed = L99dz200g.L99DZ200G_CalibrateSPIClock((uint32_t)val * 1000);
+            if (spi_speed == 0)
+            {
+                Serial.println(F("SPI calibration failed, SPI clock unchanged"));
+            }
+        }
+        else if (strcmp_P(argv[ARG1], PSTR("test")) == 0)
+        {
+            if (argc < 3)
+            {
+                return CMDLINE_INVALID_ARG;
+            }
+
+            // get the SPI clock to test
+            paramtype = CmdLine.ParseParam(argv[ARG2], &val);
+            if ((paramtype == BADPARAM) || (paramtype == STRVAL) || (val <= 0))
+            {
+                return CMDLINE_INVALID_ARG;
+            }
+
+            Serial.print(F("SPI test @ "));
+            Serial.print(val);
+            Serial.print(F(" kHz: "));
+            if (L99dz200g.L99DZ200G_TestSPIClock((uint32_t)val * 1000) == L99DZ200G_OK)
+            {
+                Serial.println(F("OK"));
+            }
+            else
+            {
+                Serial.println(F("FAIL"));
+            }
+        }
+        else
+        {
+            if (argc > 2)
+            {
+                return CMDLINE_TOO_MANY_ARGS;
+            }
+
+            // get the SPI clock to use
+            paramtype = CmdLine.ParseParam(argv[ARG1], &val);
+            if ((paramtype == BADPARAM) || (paramtype == STRVAL) || (val <= 0))
+            {
+                return CMDLINE_INVALID_ARG;
+            }
+            L99dz200g.L99DZ200G_SetSPIClock((uint32_t)val * 1000);
+        }
+    }
+
+    Serial.print(F("SPI clock: "));
+    Serial.print(L99dz200g.L99DZ200G_GetSPIClock() / 1000);
+    Serial.println(F(" kHz"));
+
+    // Return success.
+    return 0;
+}
+#endif
+
 #ifdef SHOW_STAT
 /*
  * NAME:
@@ -6719,6 +7083,77 @@ int8_t Cmd_temp(int8_t argc __attribute__((unused)), char * argv[] __attribute__
 }
 #endif
 
+#ifdef SHOW_TELEM
+/*
+ * NAME:
+ *  int8_t Cmd_tlm(int8_t argc, char * argv[])
+ *
+ * PARAMETERS:
+ *  int8_t argc = number of command line arguments for the command
+ *  char * argv[] = pointer to array of parameters associated with the command
+ *
+ * WHAT:
+ *  Implements the "tlm" command to show/start/stop binary telemetry streaming.
+ *
+ *  One optional parameter supported.
+ *   <period> = start streaming telemetry frames every period mS
+ *      -or-
+ *   <off>    = stop streaming telemetry frames
+ *
+ *       1   2
+ *     "tlm"        - show the telemetry state
+ *     "tlm 20"     - stream a telemetry frame every 20 mS
+ *     "tlm off"    - stop streaming
+ *
+ * RETURN VALUES:
+ *  int8_t = 0 = command successfully processed
+ *
+ * SPECIAL CONSIDERATIONS:
+ *  The frames are binary (decode them with extras/TelemetryDecoder), the status change
+ *  monitor in loop() is quiet while streaming.
+ */
+int8_t Cmd_tlm(int8_t argc, char * argv[])
+{
+    uint32_t period;
+
+    if (argc > 2)
+    {
+        return CMDLINE_TOO_MANY_ARGS;
+    }
+    else if (argc > 1)
+    {
+        if (strcmp_P(argv[ARG1], PSTR("off")) == 0)
+        {
+            Telem.Telem_Stop();
+        }
+        else if (isdigit(argv[ARG1][0]))
+        {
+            period = strtoul(argv[ARG1], NULL, 10);
+            if ((period < TELEM_MIN_PERIOD_MS) || (period > 65535))
+            {
+                return CMDLINE_INVALID_ARG;
+            }
+            Telem.Telem_Start(Serial, period);
+            return 0;       // nothing else on Serial while streaming
+        }
+        else
+        {
+            return CMDLINE_INVALID_ARG;
+        }
+    }
+
+    Serial.print(F("Telemetry: "));
+    Serial.print(Telem.Telem_Running() ? F("on") : F("off"));
+    Serial.print(F("  last frame: "));
+    Serial.print(Telem.Telem_Sequence());
+    Serial.print(F("  dropped: "));
+    Serial.println(Telem.Telem_Dropped());
+
+    // Return success.
+    return 0;
+}
+#endif
+
 #ifdef SHOW_TIMER
 /*
  * NAME:
@@ -7488,6 +7923,158 @@ void Show_V2_RegulatorSettings(void)
 }
 #endif
 
+#ifdef SHOW_VERIFY
+/*
+ * NAME:
+ *  int8_t Cmd_vfy(int8_t argc, char * argv[])
+ *
+ * PARAMETERS:
+ *  int8_t argc = number of command line arguments for the command
+ *  char * argv[] = pointer to array of parameters associated with the command
+ *
+ * WHAT:
+ *  Implements the "vfy" command to show/set the L99DZ200G Control register write verification.
+ *
+ *  Three optional parameters supported.
+ *   <policy> = the verification policy (never, always, nth, crit)
+ *   <n> = verify every nth write (nth only)
+ *   <retries> = the number of rewrites of a mismatched register
+ *   clr = clear the verification statistics
+ *
+ *       1     2     3    4
+ *     "vfy"                    - show verification policy and statistics
+ *     "vfy never"              - no write verification
+ *     "vfy always [r]"         - verify every write, rewrite mismatches up to r times
+ *     "vfy nth n [r]"          - verify every nth write, rewrite mismatches up to r times
+ *     "vfy crit [r]"           - verify CR1, CR2, CR4, CFR writes, rewrite mismatches up to r times
+ *     "vfy clr"                - clear verification statistics
+ *
+ * RETURN VALUES:
+ *  int8_t = 0 = command successfully processed
+ *
+ * SPECIAL CONSIDERATIONS:
+ *  None.
+ */
+int8_t Cmd_vfy(int8_t argc, char * argv[])
+{
+    int8_t paramtype;
+    int32_t val;
+    uint8_t policy;
+    uint8_t nth = 1;
+    uint8_t retries = 0;
+    uint8_t arg = ARG2;
+    L99DZ200GVerifyStats stats;
+
+    if (argc > 4)
+    {
+        return CMDLINE_TOO_MANY_ARGS;
+    }
+    else if (argc > 1)
+    {
+        if (strcmp_P(argv[ARG1], PSTR("clr")) == 0)
+        {
+            if (argc > 2)
+            {
+                return CMDLINE_TOO_MANY_ARGS;
+            }
+            L99dz200g.L99DZ200G_ClearVerifyStats();
+        }
+        else
+        {
+            // get the verification policy
+            if (strcmp_P(argv[ARG1], PSTR("never")) == 0)
+            {
+                policy = L99DZ200G_VERIFY_NEVER;
+            }
+            else if (strcmp_P(argv[ARG1], PSTR("always")) == 0)
+            {
+                policy = L99DZ200G_VERIFY_ALWAYS;
+            }
+            else if (strcmp_P(argv[ARG1], PSTR("nth")) == 0)
+            {
+                policy = L99DZ200G_VERIFY_EVERY_NTH;
+                if (argc < 3)
+                {
+                    return CMDLINE_INVALID_ARG;
+                }
+
+                // get every nth write
+                paramtype = CmdLine.ParseParam(argv[ARG2], &val);
+                if ((paramtype == BADPARAM) || (paramtype == STRVAL) || (val < 1) || (val > 255))
+                {
+                    return CMDLINE_INVALID_ARG;
+                }
+                nth = val;
+                arg = ARG3;
+            }
+            else if (strcmp_P(argv[ARG1], PSTR("crit")) == 0)
+            {
+                policy = L99DZ200G_VERIFY_CRITICAL;
+            }
+            else
+            {
+                return CMDLINE_INVALID_ARG;
+            }
+
+            if (argc > arg + 1)
+            {
+                return CMDLINE_TOO_MANY_ARGS;
+            }
+            else if ((argc > arg) && (policy != L99DZ200G_VERIFY_NEVER))
+            {
+                // get the number of rewrites
+                paramtype = CmdLine.ParseParam(argv[arg], &val);
+                if ((paramtype == BADPARAM) || (paramtype == STRVAL) || (val < 0) || (val > 255))
+                {
+                    return CMDLINE_INVALID_ARG;
+                }
+                retries = val;
+            }
+            else if (argc > arg)
+            {
+                return CMDLINE_TOO_MANY_ARGS;
+            }
+
+            L99dz200g.L99DZ200G_SetVerifyPolicy(policy, nth, retries);
+        }
+    }
+
+    Serial.print(F("VERIFY: "));
+    switch (L99dz200g.L99DZ200G_GetVerifyPolicy())
+    {
+        case L99DZ200G_VERIFY_NEVER:
+            Serial.println(F("never"));
+            break;
+        case L99DZ200G_VERIFY_ALWAYS:
+            Serial.println(F("always"));
+            break;
+        case L99DZ200G_VERIFY_EVERY_NTH:
+            Serial.println(F("every nth"));
+            break;
+        case L99DZ200G_VERIFY_CRITICAL:
+            Serial.println(F("critical (CR1, CR2, CR4, CFR)"));
+            break;
+    }
+
+    L99dz200g.L99DZ200G_GetVerifyStats(&stats);
+    Serial.print(F("  writes: "));
+    Serial.print(stats.writes);
+    Serial.print(F("  verified: "));
+    Serial.print(stats.verified);
+    Serial.print(F("  piggybacked: "));
+    Serial.println(stats.piggybacked);
+    Serial.print(F("  mismatches: "));
+    Serial.print(stats.mismatches);
+    Serial.print(F("  retries: "));
+    Serial.print(stats.retries);
+    Serial.print(F("  failures: "));
+    Serial.println(stats.failures);
+
+    // Return success.
+    return 0;
+}
+#endif
+
 #ifdef SHOW_VLED
 /*
  * NAME:
@@ -0,0 +1,251 @@
+/** \file CANDispatcher.cpp */
+/*
+ * NAME: CANDispatcher.cpp
+ *
+ * WHAT:
+ *  Table-driven CAN command dispatcher and deferred CAN frame log functions.
+ *
+ * SPECIAL CONSIDERATIONS:
+ *  None.
+ *
+ * AUTHOR:
+ *  D.L. Karmann
+ *
+ * MODIFIED:
+ *
+ */
+
+#include <stdio.h>
+#include "CANDispatcher.h"
+
+// CANDispatcher Class members
+
+// Constructor
+CANDispatcher::CANDispatcher(const CanCmdEntry * table, uint8_t count)
+{
+    Table = table;
+    Count = count;
+    BadIndex = 0;
+    UnmatchedCnt = 0;
+}
+
+// check that the dispatch table is sorted
+bool CANDispatcher::CheckTable(void)
+{
+    CanCmdEntry entry;
+
+    for (uint8_t i = 0; i < Count; ++i)
+    {
+        memcpy_P(&entry, &Table[i], sizeof(entry));
+        if ((i > 0) && (CompareEntry(i - 1, entry.can_id, entry.mask, entry.pattern) >= 0))
+        {
+            BadIndex = i;
+            return false;
+        }
+        if ((entry.pattern & ~entry.mask) != 0)
+        {
+            BadIndex = i;   // pattern has bits outside of the mask, can never match
+            return false;
+        }
+    }
+    return true;
+}
+
+// get the index of the first out of order table entry
+uint8_t CANDispatcher::BadEntry(void)
+{
+    return BadIndex;
+}
+
+// find and call the handler for the CAN message
+bool CANDispatcher::Dispatch(uint32_t can_id, uint32_t cmd_data)
+{
+    CanCmdEntry entry;
+    uint8_t lo;
+    uint8_t idx;
+
+    // first entry for this CAN ID (the largest mask sorts first)
+    lo = LowerBound(0, can_id, CAN_FULL_MASK, 0);
+
+    // search each mask group of this CAN ID, largest mask first
+    while (lo < Count)
+    {
+        memcpy_P(&entry, &Table[lo], sizeof(entry));
+        if (entry.can_id != can_id)
+        {
+            break;
+        }
+
+        idx = LowerBound(lo, can_id, entry.mask, cmd_data & entry.mask);
+        if ((idx < Count) && (CompareEntry(idx, can_id, entry.mask, cmd_data & entry.mask) == 0))
+        {
+            memcpy_P(&entry, &Table[idx], sizeof(entry));
+            entry.handler(cmd_data, entry.param);
+            return true;
+        }
+
+        if (entry.mask == 0)
+        {
+            break;      // was the last possible mask group
+        }
+        // start of the next (smaller) mask group
+        lo = LowerBound(lo, can_id, entry.mask - 1, 0);
+    }
+
+    ++UnmatchedCnt;
+    return false;
+}
+
+// get the count of unmatched CAN messages
+uint32_t CANDispatcher::Unmatched(void)
+{
+    return UnmatchedCnt;
+}
+
+// compare table entry key to (can_id, mask, pattern) key: -1 = entry before, 0 = same, 1 = entry after
+int8_t CANDispatcher::CompareEntry(uint8_t idx, uint32_t can_id, uint32_t mask, uint32_t pattern)
+{
+    uint32_t val;
+
+    val = pgm_read_dword(&Table[idx].can_id);
+    if (val != can_id)
+    {
+        return (val < can_id) ? -1 : 1;
+    }
+    val = pgm_read_dword(&Table[idx].mask);
+    if (val != mask)
+    {
+        return (val > mask) ? -1 : 1;     // masks are descending
+    }
+    val = pgm_read_dword(&Table[idx].pattern);
+    if (val != pattern)
+    {
+        return (val < pattern) ? -1 : 1;
+    }
+    return 0;
+}
+
+// get index of first table entry (from lo) that is not before the key
+uint8_t CANDispatcher::LowerBound(uint8_t lo, uint32_t can_id, uint32_t mask, uint32_t pattern)
+{
+    uint8_t hi = Count;
+    uint8_t mid;
+
+    while (lo < hi)
+    {
+        mid = lo + ((hi - lo) / 2);
+        if (CompareEntry(mid, can_id, mask, pattern) < 0)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// CANFrameLog Class members
+
+// Constructor
+CANFrameLog::CANFrameLog(void)
+{
+    Head = 0;
+    Tail = 0;
+    DroppedCnt = 0;
+    ReportedCnt = 0;
+    LinePos = 0;
+    LineLen = 0;
+}
+
+// save a received CAN frame in the log
+void CANFrameLog::Push(uint32_t can_id, const uint8_t * data, uint8_t len)
+{
+    uint8_t next = (Head + 1) & (CAN_LOG_SIZE - 1);
+
+    if (next == Tail)
+    {
+        ++DroppedCnt;   // log full, lose the newest frame
+        return;
+    }
+
+    if (len > 8)
+    {
+        len = 8;
+    }
+    Frames[Head].can_id = can_id;
+    Frames[Head].len = len;
+    memcpy(Frames[Head].data, data, len);
+    Head = next;
+}
+
+// print logged CAN frames, only as much as the output device can take without blocking
+bool CANFrameLog::Drain(Print & out)
+{
+    int avail;
+    uint8_t cnt;
+
+    if (LinePos >= LineLen)
+    {
+        // current line done, get the next one
+        if (DroppedCnt != ReportedCnt)
+        {
+            LineLen = snprintf(Line, sizeof(Line), "CAN log: %lu frame(s) dropped\r\n",
+                               (unsigned long)(DroppedCnt - ReportedCnt));
+            ReportedCnt = DroppedCnt;
+        }
+        else if (Tail != Head)
+        {
+            FormatFrame(&Frames[Tail]);
+            Tail = (Tail + 1) & (CAN_LOG_SIZE - 1);
+        }
+        else
+        {
+            return false;   // nothing to print
+        }
+        if (LineLen >= sizeof(Line))
+        {
+            LineLen = sizeof(Line) - 1;
+        }
+        LinePos = 0;
+    }
+
+    avail = out.availableForWrite();
+    if (avail <= 0)
+    {
+        return true;
+    }
+    cnt = LineLen - LinePos;
+    if (cnt > avail)
+    {
+        cnt = avail;
+    }
+    out.write((const uint8_t *)&Line[LinePos], cnt);
+    LinePos += cnt;
+    return LinePos < LineLen;
+}
+
+// get the count of lost CAN frames
+uint32_t CANFrameLog::Dropped(void)
+{
+    return DroppedCnt;
+}
+
+// format a logged CAN frame the same as the original demo output
+void CANFrameLog::FormatFrame(LogFrame * frame)
+{
+    uint32_t cmd_data = 0;
+    uint8_t len;
+
+    len = snprintf(Line, sizeof(Line), "CAN ID: 0x%lX    Data Length: %u    ",
+                   (unsigned long)frame->can_id, frame->len);
+
+    for (uint8_t i = 0; i < frame->len; ++i)
+    {
+        len += snprintf(&Line[len], sizeof(Line) - len, (i < frame->len - 1) ? "%u," : "%u", frame->data[i]);
+    }
+    memcpy(&cmd_data, frame->data, (frame->len < 4) ? frame->len : 4);
+    len += snprintf(&Line[len], sizeof(Line) - len, " (0x%08lX)\r\n", (unsigned long)cmd_data);
+    LineLen = len;
+}
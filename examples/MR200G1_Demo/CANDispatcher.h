@@ -0,0 +1,185 @@
+/** \file CANDispatcher.h */
+/*
+ * NAME: CANDispatcher.h
+ *
+ * WHAT:
+ *  Header file for the table-driven CAN command dispatcher and the deferred CAN frame log.
+ *
+ *  The dispatcher matches a received (CAN ID, 32-bit payload) against a PROGMEM table of
+ *  (CAN ID, payload mask, payload pattern) -> handler entries using a binary search, so
+ *  command-to-actuation latency does not depend on the table size or on Serial throughput.
+ *
+ *  The frame log copies received frames into a small RAM ring buffer in the receive path
+ *  and prints them later, from loop(), only as fast as the Serial transmit buffer allows.
+ *
+ * SPECIAL CONSIDERATIONS:
+ *  The dispatch table MUST be sorted by CAN ID (ascending), then by mask (descending),
+ *  then by pattern (ascending). Use CANDispatcher::CheckTable() to verify it at startup.
+ *  Since numerically larger masks are searched first, an exact (0xFFFFFFFF) match wins
+ *  over a partial match for the same CAN ID.
+ *
+ * AUTHOR:
+ *  D.L. Karmann
+ *
+ */
+#ifndef __CANDISPATCHER_H__
+#define __CANDISPATCHER_H__
+
+#include "Arduino.h"
+
+#define CAN_FULL_MASK           0xFFFFFFFFUL    // payload must match exactly
+
+#define CAN_LOG_SIZE            8               // frames in the deferred log (power of 2)
+#define CAN_LOG_LINE_SIZE       96              // formatted log line buffer size
+
+/**
+ * CAN command handler.
+ *
+ * \param cmd_data: the received 32-bit CAN payload
+ * \param param: the parameter from the matching dispatch table entry
+ */
+typedef void (*CanCmdHandler)(uint32_t cmd_data, uint8_t param);
+
+/**
+ * CAN command dispatch table entry (placed in PROGMEM).
+ */
+typedef struct
+{
+    uint32_t can_id;            ///< the CAN message ID
+    uint32_t mask;              ///< the payload bits that must match
+    uint32_t pattern;           ///< the payload value (already masked)
+    CanCmdHandler handler;      ///< the function to call on a match
+    uint8_t param;              ///< the value passed to the handler
+} CanCmdEntry;
+
+/**
+ * Table-driven CAN command dispatcher class.
+ */
+class CANDispatcher
+{
+    public:
+        /**
+         *  A constructor that sets up the CAN command dispatcher.
+         *
+         *  \param table: the PROGMEM dispatch table (sorted, see above)
+         *  \param count: the number of entries in the dispatch table
+         *
+         *  \return None.
+         */
+        CANDispatcher(const CanCmdEntry * table, uint8_t count);
+
+        /**
+         * Check that the dispatch table is sorted as required by Dispatch().
+         *
+         * \return   true = the table is sorted
+         * \return   false = the table is out of order (first bad entry from BadEntry())
+         */
+        bool CheckTable(void);
+
+        /**
+         * Get the index of the first out of order table entry found by CheckTable().
+         *
+         * \return   uint8_t = the table entry index
+         */
+        uint8_t BadEntry(void);
+
+        /**
+         * Find and call the handler for the specified CAN message.
+         *
+         * \param can_id: the received CAN message ID
+         * \param cmd_data: the received 32-bit CAN payload
+         *
+         * \return   true = a matching handler was found and called
+         * \return   false = no matching table entry
+         */
+        bool Dispatch(uint32_t can_id, uint32_t cmd_data);
+
+        /**
+         * Get the count of received CAN messages that had no matching table entry.
+         *
+         * \return   uint32_t = the count of unmatched CAN messages
+         */
+        uint32_t Unmatched(void);
+
+    private:
+        /// the PROGMEM dispatch table
+        const CanCmdEntry * Table;
+        /// the number of entries in the dispatch table
+        uint8_t Count;
+        /// the index of the first out of order table entry
+        uint8_t BadIndex;
+        /// the count of received CAN messages that had no matching table entry
+        uint32_t UnmatchedCnt;
+
+        int8_t CompareEntry(uint8_t idx, uint32_t can_id, uint32_t mask, uint32_t pattern);
+        uint8_t LowerBound(uint8_t lo, uint32_t can_id, uint32_t mask, uint32_t pattern);
+};
+
+/**
+ * Deferred CAN frame log class.
+ */
+class CANFrameLog
+{
+    public:
+        /**
+         *  A constructor that sets up the deferred CAN frame log.
+         *
+         *  \return None.
+         */
+        CANFrameLog(void);
+
+        /**
+         * Save a received CAN frame in the log (does no printing).
+         *
+         * \param can_id: the received CAN message ID
+         * \param data: the received CAN data bytes
+         * \param len: the number of received CAN data bytes (0 to 8)
+         *
+         *  \return None.
+         */
+        void Push(uint32_t can_id, const uint8_t * data, uint8_t len);
+
+        /**
+         * Print logged CAN frames without blocking on the output device.
+         *
+         * \param out: the output device (e.g. Serial)
+         *
+         * \return   true = a line is partly printed (do not print other output yet)
+         * \return   false = no line is being printed
+         */
+        bool Drain(Print & out);
+
+        /**
+         * Get the count of CAN frames lost because the log was full.
+         *
+         * \return   uint32_t = the count of lost CAN frames
+         */
+        uint32_t Dropped(void);
+
+    private:
+        /// a logged CAN frame
+        typedef struct
+        {
+            uint32_t can_id;
+            uint8_t len;
+            uint8_t data[8];
+        } LogFrame;
+
+        /// the logged CAN frames
+        LogFrame Frames[CAN_LOG_SIZE];
+        /// the log ring buffer indexes
+        volatile uint8_t Head;
+        volatile uint8_t Tail;
+        /// the count of CAN frames lost because the log was full
+        uint32_t DroppedCnt;
+        /// the count of lost CAN frames already reported
+        uint32_t ReportedCnt;
+        /// the formatted log line being printed
+        char Line[CAN_LOG_LINE_SIZE];
+        uint8_t LinePos;
+        uint8_t LineLen;
+
+        void FormatFrame(LogFrame * frame);
+};
+
+#endif  // __CANDISPATCHER_H__
@@ -155,9 +155,20 @@
 
 #include <CommandLine.h>
 #include <DLK_L99DZ200G.h>
+#include <DLK_EventLog.h>
+#include <DLK_Logger.h>
+#include <DLK_LampAnimator.h>
+#include <DLK_OutputSequencer.h>
+#include <DLK_ECVController.h>
+#include <DLK_HeaterRegulator.h>
+#include <DLK_LoadShedder.h>
+#include <DLK_OCRMonitor.h>
+#include <DLK_DTCManager.h>
+#include <DLK_CurrentCapture.h>
 #include <DLK_MCP2515.h>    // MCP2515 CAN Bus library
 
 #include "CANCommunication.h"
+#include "CANDispatcher.h"
 
 #define TITLE_MSG           "DLK AEK-MOT-MR200G1 Demo"
 
@@ -187,6 +198,26 @@
 #define ARROWS_ON               15
 #define ARROWS_OFF              16
 
+#define ARROW_OUTS              (LAMPANIM_OUT(OUT_7) | LAMPANIM_OUT(OUT_8))     // mirror arrow bulbs
+
+// mirror heater regulation
+#define HEATER_TEMP_CLUSTER     TEMP_CL1        // thermal cluster used as heater feedback
+#define HEATER_SETPOINT_C       45.0            // C
+#define HEATER_RATE_LIMIT       0.5             // C/S
+#define HEATER_DEFROST_MS       600000UL        // longest defrost (mS)
+
+// supply voltage load shedding (only the heater; the motors and the arrow bulbs are never shed)
+// (the early warning is above the shed voltage, so it catches a fast dip before class 1 sheds;
+//  the early warning threshold can be at most EW_THR_MAX)
+#define SUPPLY_EARLY_WARN_V     10.0            // VSREG early warning threshold (V)
+#define SUPPLY_SHED_V           9.5             // VS voltage the heater is shed below (V)
+
+#define DTC_EEPROM_ADDR         0               // stored diagnostic trouble codes EEPROM address
+
+// fault/event log: Control register writes recorded (not the PWM duty cycle and ECV voltage ramps)
+#define EVLOG_WRITES            (EVLOG_ALL_CRS & ~(EVLOG_CR(L99DZ200G_CR11) | EVLOG_CR(L99DZ200G_CR13) | \
+                                 EVLOG_CR(L99DZ200G_CR14) | EVLOG_CR(L99DZ200G_CR15) | EVLOG_CR(L99DZ200G_CR16)))
+
 // specify pins to use
 #ifdef __AVR__      // this includes Arduino Nano Every MCU
 #define LED_PIN                 8           // the heartbeat LED pin (LED_BUILTIN is used for SPI SCK)
@@ -221,18 +252,120 @@
 #define DEBUG_LO()          digitalWrite(DEBUG_PIN, LOW)
 #define DEBUG_TOGL()        digitalWrite(DEBUG_PIN, !digitalRead(DEBUG_PIN))
 
-#define SPI_CLOCK           250000          // 250 Kbps
+#define MCP2515_SPI_CLOCK   250000          // 250 Kbps
+#define L99DZ200G_SPI_CLOCK L99DZ200G_SPI_MAX_CLOCK // not throttled to the MCP2515 SPI clock
 #define CAN_SPEED           CAN_250KBPS
 
-DLK_MCP2515 Mcp2515(SPI_CLOCK, MCP2515_CS_PIN);
+#define CAN_FRAME_LOGGING                   // comment out to not log received CAN frames
+#define ECV_TARGET_MASK     0xFFFF0000UL    // ECV target command, target mV in 16 data LSB
 
-uint8_t Len = 0;    // length of received buffer
-uint8_t Buf[8];     // Buffer to hold up to 8 bytes of data
-uint32_t CanID;     // Can message ID
+DLK_SPIBus SpiBus(SPI);         // shared SPI bus arbiter for the L99DZ200G and MCP2515
+
+DLK_MCP2515 Mcp2515(MCP2515_SPI_CLOCK, MCP2515_CS_PIN);
+uint8_t Mcp2515BusDev = SpiBus.SPIBus_AddDevice(SPIBUS_EXTERNAL, SPIBUS_PRIO_NORMAL);
+
+// CAN command dispatch table
+//  Must be sorted by CAN ID, then mask (largest first), then pattern (smallest first).
+const CanCmdEntry CanCmdTable[] PROGMEM =
+{
+    //  CAN ID      mask             pattern                                handler          param
+    { ID_MR_200G, CAN_FULL_MASK,   AEK_MOT_MR200G1_DEMO_ON_CMD,           CanMirrorCmd,    DEMO_ON         },
+    { ID_MR_200G, CAN_FULL_MASK,   AEK_MOT_MR200G1_MIRROR_FOLDING_CMD,    CanMirrorCmd,    F_FOLD          },
+    { ID_MR_200G, CAN_FULL_MASK,   AEK_MOT_MR200G1_MIRROR_UNFOLDING_CMD,  CanMirrorCmd,    F_UNFOLD        },
+    { ID_MR_200G, CAN_FULL_MASK,   AEK_MOT_MR200G1_ECV_ON_CMD,            CanMirrorCmd,    ECV_ON          },
+    { ID_MR_200G, CAN_FULL_MASK,   AEK_MOT_MR200G1_ECV_OFF_CMD,           CanMirrorCmd,    ECV_OFF         },
+    { ID_MR_200G, CAN_FULL_MASK,   AEK_MOT_MR200G1_HEATER_ON_CMD,         CanMirrorCmd,    HEATER_ON       },
+    { ID_MR_200G, CAN_FULL_MASK,   AEK_MOT_MR200G1_HEATER_OFF_CMD,        CanMirrorCmd,    HEATER_OFF      },
+    { ID_MR_200G, CAN_FULL_MASK,   AEK_MOT_MR200G1_MIRROR_X_CK_CMD,       CanMirrorCmd,    X_CLOCKWISE     },
+    { ID_MR_200G, CAN_FULL_MASK,   AEK_MOT_MR200G1_MIRROR_X_CCK_CMD,      CanMirrorCmd,    X_C_CLOCKWISE   },
+    { ID_MR_200G, CAN_FULL_MASK,   AEK_MOT_MR200G1_MIRROR_Y_CK_CMD,       CanMirrorCmd,    Y_CLOCKWISE     },
+    { ID_MR_200G, CAN_FULL_MASK,   AEK_MOT_MR200G1_MIRROR_Y_CCK_CMD,      CanMirrorCmd,    Y_C_CLOCKWISE   },
+    { ID_MR_200G, CAN_FULL_MASK,   AEK_MOT_MR200G1_MIRROR_BRK_CMD,        CanMirrorCmd,    BRAKE_ALL       },
+    { ID_MR_200G, CAN_FULL_MASK,   AEK_MOT_MR200G1_BULBS_ON_CMD,          CanMirrorCmd,    ARROWS_ON       },
+    { ID_MR_200G, CAN_FULL_MASK,   AEK_MOT_MR200G1_BULBS_OFF_CMD,         CanMirrorCmd,    ARROWS_OFF      },
+    { ID_MR_200G, CAN_FULL_MASK,   AEK_MOT_MR200G1_BULBS_FLASH_CMD,       CanMirrorCmd,    ARROWS_FLASHING },
+    { ID_MR_200G, CAN_FULL_MASK,   AEK_MOT_MR200G1_MIRROR_CENTER_CMD,     CanMirrorCmd,    CENTER_MIRROR   },
+    { ID_MR_200G, CAN_FULL_MASK,   AEK_MOT_MR200G1_DEMO_OFF_CMD,          CanMirrorCmd,    IDLE            },
+    { ID_MR_200G, ECV_TARGET_MASK, AEK_MOT_MR200G1_ECV_TARGET_CMD,        CanEcvTargetCmd, 0               },
+};
+
+CANDispatcher CanDispatcher(CanCmdTable, sizeof(CanCmdTable) / sizeof(CanCmdTable[0]));
+#ifdef CAN_FRAME_LOGGING
+CANFrameLog CanLog;             // deferred received CAN frame log
+#endif
 
 CommandLine CmdLine(Serial);    // setup CommandLine to use standard Arduino Serial and echo on
 
-DLK_L99DZ200G L99dz200g(SPI_CLOCK, L99DZ200G_CS_PIN);
+DLK_L99DZ200G L99dz200g(SpiBus, L99DZ200G_SPI_CLOCK, L99DZ200G_CS_PIN);
+
+DLK_EventLog EventLog;                  // fault/event ring buffer for post-mortem dumps
+
+DLK_Logger Logger;                      // status messages, written to Serial from loop() without waiting
+
+DLK_LampAnimator LampAnim(L99dz200g);   // mirror arrow bulb patterns
+
+DLK_OutputSequencer OutSeq(L99dz200g);  // staggered bulb turn-on
+
+DLK_ECVController EcvCtl(L99dz200g);    // electrochromic mirror dimming
+
+DLK_HeaterRegulator HeaterReg(L99dz200g);   // mirror heater regulation
+
+DLK_LoadShedder LoadShed(L99dz200g);    // supply dip load shedding
+
+DLK_OCRMonitor OcrMon(L99dz200g);       // overcurrent autorecovery monitoring
+
+DLK_DTCManager DtcMgr(L99dz200g);       // diagnostic trouble codes
+
+DLK_CurrentCapture CurCap(L99dz200g);   // OUTn current waveform capture ("cap" command)
+
+// diagnostic trouble codes (fail/pass counts in DTC_STEP_MS samples)
+//  Latched shutdown bits are not cleared here (that turns the output back on).
+const DTCDef DtcTable[] PROGMEM =
+{
+    //  register     fault bit(s)                             fail  pass  flags
+    { L99DZ200G_SR2, SR2_VS_UV,                                 5,   20,  DTC_CLEAR },
+    { L99DZ200G_SR2, SR2_VS_OV,                                 5,   20,  DTC_CLEAR },
+    { L99DZ200G_SR2, SR2_TW,                                    3,   20,  DTC_CLEAR },
+    { L99DZ200G_SR1, SR1_TSD1 | SR1_TSD2,                       1,   20,  DTC_CLEAR },
+    { L99DZ200G_SR3, SR3_OUT2H_OCTHX | SR3_OUT2L_OCTHX,         2,   10,  0         },
+    { L99DZ200G_SR3, SR3_OUT3H_OCTHX | SR3_OUT3L_OCTHX,         2,   10,  0         },
+    { L99DZ200G_SR3, SR3_OUT6H_OCTHX | SR3_OUT6L_OCTHX,         2,   10,  0         },
+    { L99DZ200G_SR3, SR3_OUT1H_OCTHX | SR3_OUT1L_OCTHX,         2,   10,  0         },
+    { L99DZ200G_SR3, SR3_OUT7_OCTHX | SR3_OUT8_OCTHX,           2,   10,  0         },
+    { L99DZ200G_SR5, SR5_OUT7_OL | SR5_OUT8_OL,                10,   10,  DTC_CLEAR },
+    { L99DZ200G_SR5, SR5_DS_MON_HEAT,                           1,   20,  0         },
+    { L99DZ200G_SR5, SR5_OUTGH_OL,                             10,   10,  0         },
+    { L99DZ200G_SR5, SR5_ECV_OC,                                2,   10,  0         },
+};
+
+// diagnostic trouble code names (same order as DtcTable[])
+const char DtcNameVsUv[] PROGMEM    = "VS undervoltage";
+const char DtcNameVsOv[] PROGMEM    = "VS overvoltage";
+const char DtcNameTw[] PROGMEM      = "Thermal warning";
+const char DtcNameTsd[] PROGMEM     = "Thermal shutdown";
+const char DtcNameMotX[] PROGMEM    = "Motor X overcurrent (OUT2)";
+const char DtcNameMotY[] PROGMEM    = "Motor Y overcurrent (OUT3)";
+const char DtcNameMotF[] PROGMEM    = "Fold motor overcurrent (OUT6)";
+const char DtcNameMotCom[] PROGMEM  = "Motor common overcurrent (OUT1)";
+const char DtcNameArrOc[] PROGMEM   = "Arrow bulb overcurrent (OUT7/8)";
+const char DtcNameArrOl[] PROGMEM   = "Arrow bulb open load (OUT7/8)";
+const char DtcNameHtrSc[] PROGMEM   = "Heater short (drain monitor)";
+const char DtcNameHtrOl[] PROGMEM   = "Heater open load";
+const char DtcNameEcvOc[] PROGMEM   = "ECV overcurrent";
+
+const char * const DtcNames[] PROGMEM =
+{
+    DtcNameVsUv, DtcNameVsOv, DtcNameTw, DtcNameTsd, DtcNameMotX, DtcNameMotY, DtcNameMotF,
+    DtcNameMotCom, DtcNameArrOc, DtcNameArrOl, DtcNameHtrSc, DtcNameHtrOl, DtcNameEcvOc
+};
+
+// arrow bulbs turn-on, staggered so their inrush currents do not add up
+const OutSeqStep ArrowsOnSeq[] =
+{
+    // output, type, offset (mS), inrush (mS)
+    { OUT_7, ON_OUT,  0, 50 },
+    { OUT_8, ON_OUT, 25, 50 },
+};
 
 uint8_t OutHB = 0;                  // OUTn to be used with heartbeat LED
 volatile bool L99DZ200G_IntFlag = false;
@@ -267,6 +400,7 @@ void L99DZ200G_Reset(void)
 void setup()
 {
     uint32_t start_time = millis();
+    uint8_t ret;
 
     // init heartbeat LED
     pinMode(LED_PIN, OUTPUT);
@@ -337,6 +471,10 @@ void setup()
 
     delay(5);       // allow power to stabilize in L99DZ200G
 
+    // record L99DZ200G faults/events from the start
+    EventLog.EventLog_SetWriteFilter(EVLOG_WRITES);
+    L99dz200g.L99DZ200G_SetEventLog(&EventLog);
+
     // Initialize L99DZ200G
     if (L99DZ200G_Init() != L99DZ200G_OK)
     {
@@ -347,8 +485,17 @@ void setup()
         }
     }
 
+    // diagnostic trouble codes, stored ones from EEPROM
+    if (DtcMgr.DTC_Begin(DtcTable, sizeof(DtcTable) / sizeof(DtcTable[0]), DTC_EEPROM_ADDR) != L99DZ200G_OK)
+    {
+        Serial.println(F("No stored DTCs"));
+    }
+
     // Initialize MCP2515 running at 8MHz with a baudrate of 250kb/s
-    if (Mcp2515.MCP2515_Init(CAN_SPEED) == MCP2515_OK)
+    SpiBus.SPIBus_Acquire(Mcp2515BusDev);
+    ret = Mcp2515.MCP2515_Init(CAN_SPEED);
+    SpiBus.SPIBus_Release(Mcp2515BusDev);
+    if (ret == MCP2515_OK)
     {
         Serial.println(F("MCP2515 Initialized Successfully!"));
     }
@@ -360,6 +507,12 @@ void setup()
             yield();
         }
     }
+
+    if (!CanDispatcher.CheckTable())
+    {
+        Serial.print(F("CanCmdTable[] out of order at entry "));
+        Serial.println(CanDispatcher.BadEntry());
+    }
 }
 
 void loop()
@@ -371,9 +524,15 @@ void loop()
     static uint32_t last_sr3 = 0xff0000;
     static uint32_t last_sr4 = 0xff0000;
     static uint32_t last_sr5 = 0xff0000;
+#ifdef CAN_FRAME_LOGGING
+    static bool can_line = false;
+    static bool log_line = false;
+#endif
     uint8_t gsb;
     uint32_t reg;
+    uint32_t sr[5];
     CAN_FRAME frame;
+    bool can_recv;
 
     if (new_prompt)
     {
@@ -400,51 +559,55 @@ void loop()
             {
 DEBUG_TOGL();
                 last_gsb = gsb;
-                Serial.print("GSB: ");
-                Print0xHexByteln(gsb);
+                LOG_W(Logger, "GSB: 0x%02lX", gsb);
 DEBUG_TOGL();
             }
 
-            reg = L99dz200g.L99DZ200G_ReadRegister(L99DZ200G_SR1) & FULL_REG_MASK;
+            // read SR1 to SR5 in a single SPI session
+            {
+                DLK_L99DZ200G_Session session(L99dz200g);
+
+                for (uint8_t i = 0; i < 5; ++i)
+                {
+                    sr[i] = L99dz200g.L99DZ200G_ReadRegister(L99DZ200G_SR1 + i) & FULL_REG_MASK;
+                }
+            }
+
+            reg = sr[0];
             if ((reg != 0) && (reg != last_sr1))
             {
 DEBUG_TOGL();
                 last_sr1 = reg;
-                Serial.print("SR1: ");
-                Print0xHex24ln(reg);
+                LOG_W(Logger, "SR1: 0x%06lX", reg);
 DEBUG_TOGL();
             }
 
-            reg = L99dz200g.L99DZ200G_ReadRegister(L99DZ200G_SR2) & FULL_REG_MASK;
+            reg = sr[1];
             if ((reg != 0) && (reg != last_sr2))
             {
                 last_sr2 = reg;
-                Serial.print("SR2: ");
-                Print0xHex24ln(reg);
+                LOG_W(Logger, "SR2: 0x%06lX", reg);
             }
 
-            reg = L99dz200g.L99DZ200G_ReadRegister(L99DZ200G_SR3) & FULL_REG_MASK;
+            reg = sr[2];
             if ((reg != 0) && (reg != last_sr3))
             {
                 last_sr3 = reg;
-                Serial.print("SR3: ");
-                Print0xHex24ln(reg);
+                LOG_W(Logger, "SR3: 0x%06lX", reg);
             }
 
-            reg = L99dz200g.L99DZ200G_ReadRegister(L99DZ200G_SR4) & FULL_REG_MASK;
+            reg = sr[3];
             if ((reg != 0) && (reg != last_sr4))
             {
                 last_sr4 = reg;
-                Serial.print("SR4: ");
-                Print0xHex24ln(reg);
+                LOG_W(Logger, "SR4: 0x%06lX", reg);
             }
 
-            reg = L99dz200g.L99DZ200G_ReadRegister(L99DZ200G_SR5) & FULL_REG_MASK;
+            reg = sr[4];
             if ((reg != 0) && (reg != last_sr5))
             {
                 last_sr5 = reg;
-                Serial.print("SR5: ");
-                Print0xHex24ln(reg);
+                LOG_W(Logger, "SR5: 0x%06lX", reg);
             }
         }
     }
@@ -453,6 +616,7 @@ DEBUG_TOGL();
     {
         L99DZ200G_IntFlag = false;
         L99DZ200G_ResetFlag = false;
+        EventLog.EventLog_Add(EVLOG_NINT, 0, 0);
 
         // Re-initialize L99DZ200G
         if (L99DZ200G_Init() != L99DZ200G_OK)
@@ -463,12 +627,13 @@ DEBUG_TOGL();
                 yield();    // needed by ESP8266 to prevent Soft WDT reset "rst cause:2, boot mode:(3,6)"
             }
         }
-        Serial.println("L99DZ200G Interrupt!");
+        LOG_W(Logger, "L99DZ200G Interrupt!");
     }
     else if (L99DZ200G_ResetFlag)
     {
         L99DZ200G_ResetFlag = false;
         L99DZ200G_IntFlag = false;
+        EventLog.EventLog_Add(EVLOG_NRESET, 0, 0);
 
         delay(5);       // allow power to stabilize in L99DZ200G
 
@@ -481,15 +646,64 @@ DEBUG_TOGL();
                 yield();    // needed by ESP8266 to prevent Soft WDT reset "rst cause:2, boot mode:(3,6)"
             }
         }
-        Serial.println("L99DZ200G Reset!");
+        LOG_W(Logger, "L99DZ200G Reset!");
     }
 
     // uses polling of MCP2515 to determine if CAN data available
-    if (Mcp2515.MCP2515_Recv(&frame) == MCP2515_OK) // check if data is coming in
+    if (SpiBus.SPIBus_Acquire(Mcp2515BusDev))
     {
-        ProcessCanMsg(&frame);
+        can_recv = (Mcp2515.MCP2515_Recv(&frame) == MCP2515_OK);   // check if data is coming in
+        SpiBus.SPIBus_Release(Mcp2515BusDev);
+        if (can_recv)
+        {
+            ProcessCanMsg(&frame);
+        }
+    }
+
+    // print logged CAN frames and messages as Serial allows (a whole line of one at a time)
+#ifdef CAN_FRAME_LOGGING
+    if (!log_line)
+    {
+        can_line = CanLog.Drain(Serial);
+    }
+    if (!can_line)
+    {
+        log_line = Logger.Log_Drain(Serial);
+    }
+#else
+    Logger.Log_Drain(Serial);
+#endif
+
+    // If watchdog is not running, assumes L99DZ200G is in a standby mode
+    // and should not be disturbed by SPI communications!
+    if (L99dz200g.L99DZ200G_WatchdogRunning())
+    {
+        // step lamp patterns (no SPI traffic unless a lamp changes)
+        LampAnim.LampAnim_Tick();
+
+        // step output turn-on sequence (no SPI traffic unless an output changes)
+        OutSeq.OutSeq_Tick();
+
+        // step ECV dimming (no SPI traffic unless dimming)
+        EcvCtl.ECV_Tick();
+
+        // regulate mirror heater (SPI traffic only once per heater PWM period)
+        HeaterReg.HeaterReg_Tick();
+
+        // shed/restore loads on supply dips (VS and SR2 read every LOADSHED_STEP_MS)
+        LoadShed.LoadShed_Tick();
+
+        // count overcurrent recovery alerts, adapt autorecovery (SR4 read every OCRMON_STEP_MS)
+        OcrMon.OcrMon_Tick();
     }
 
+    // debounce diagnostic trouble codes (fault SRs read every DTC_STEP_MS, none in standby
+    // where only the operating minutes are counted)
+    DtcMgr.DTC_Tick();
+
+    // sample the captured current when due (no SPI traffic)
+    CurCap.Capture_Tick();
+
     // do other stuff here
 
     // do Heartbeat
@@ -498,98 +712,31 @@ DEBUG_TOGL();
 
 void ProcessCanMsg(CAN_FRAME * frame)
 {
-    uint32_t * cmd_ptr;
-    uint32_t cmd_data;
-    uint8_t cmd = IDLE;
+    uint32_t cmd_data = 0;
 
-    // Read data, Len: data length, Buf: data buffer
-    CanID = frame->can_id;
-    Len = frame->can_dlc;
-    memcpy(Buf, frame->can_data, Len);
+    // the command is the first 4 data bytes
+    memcpy(&cmd_data, frame->can_data, (frame->can_dlc < 4) ? frame->can_dlc : 4);
 
-    Serial.print(F("CAN ID: 0x"));
-    Serial.print(CanID, HEX);       // print the CAN ID in HEX
+#ifdef CAN_FRAME_LOGGING
+    // only saved here, printed later from loop() so Serial does not delay the command
+    CanLog.Push(frame->can_id, frame->can_data, frame->can_dlc);
+#endif
 
-    Serial.print(F("    Data Length: ")); // Print the length of the received data
-    Serial.print(Len);
-    Serial.print(F("    "));
+    CanDispatcher.Dispatch(frame->can_id, cmd_data);
+}
 
-    for (int i = 0; i < Len; i++)    // loop on the incoming data to print each byte
-    {
-        Serial.print(Buf[i]);
-//        Serial.print(Buf[i], HEX);
-        if (i < Len - 1)
-        {
-            Serial.print(',');      // Separate the numbers for readability
-        }
-    }
-    Serial.print(F(" ("));
-    cmd_ptr = (uint32_t *)frame->can_data;
-    cmd_data = *cmd_ptr;
-    Print0xHex32(cmd_data);
-    Serial.println(')');
+// CAN mirror command handler, param = mirror operation
+void CanMirrorCmd(uint32_t cmd_data, uint8_t param)
+{
+    (void)cmd_data;
+    DoMirrorOperation(param);
+}
 
-    if (CanID == ID_MR_200G)
-    {
-        switch (cmd_data)
-        {
-            case AEK_MOT_MR200G1_DEMO_ON_CMD:
-                cmd = DEMO_ON;
-                break;
-            case AEK_MOT_MR200G1_DEMO_OFF_CMD:
-                cmd = IDLE;
-                break;
-            case AEK_MOT_MR200G1_MIRROR_FOLDING_CMD:
-                cmd = F_FOLD;
-                break;
-            case AEK_MOT_MR200G1_MIRROR_UNFOLDING_CMD:
-                cmd = F_UNFOLD;
-                break;
-            case AEK_MOT_MR200G1_MIRROR_X_CK_CMD:
-                cmd = X_CLOCKWISE;
-                break;
-            case AEK_MOT_MR200G1_MIRROR_X_CCK_CMD:
-                cmd = X_C_CLOCKWISE;
-                break;
-            case AEK_MOT_MR200G1_MIRROR_Y_CK_CMD:
-                cmd = Y_CLOCKWISE;
-                break;
-            case AEK_MOT_MR200G1_MIRROR_Y_CCK_CMD:
-                cmd = Y_C_CLOCKWISE;
-                break;
-            case AEK_MOT_MR200G1_MIRROR_BRK_CMD:
-                cmd = BRAKE_ALL;
-                break;
-            case AEK_MOT_MR200G1_MIRROR_CENTER_CMD:
-                cmd = CENTER_MIRROR;
-                break;
-            case AEK_MOT_MR200G1_BULBS_ON_CMD:
-                cmd = ARROWS_ON;
-                break;
-            case AEK_MOT_MR200G1_BULBS_OFF_CMD:
-                cmd = ARROWS_OFF;
-                break;
-            case AEK_MOT_MR200G1_BULBS_FLASH_CMD:
-                cmd = ARROWS_FLASHING;
-                break;
-            case AEK_MOT_MR200G1_HEATER_ON_CMD:
-                cmd = HEATER_ON;
-                break;
-            case AEK_MOT_MR200G1_HEATER_OFF_CMD:
-                cmd = HEATER_OFF;
-                break;
-            case AEK_MOT_MR200G1_ECV_ON_CMD:
-                cmd = ECV_ON;
-                break;
-            case AEK_MOT_MR200G1_ECV_OFF_CMD:
-                cmd = ECV_OFF;
-                break;
-
-            default:
-                return;
-        }
-        DoMirrorOperation(cmd);
-    }
+// CAN ECV target command handler, target mV in 16 data LSB
+void CanEcvTargetCmd(uint32_t cmd_data, uint8_t param)
+{
+    (void)param;
+    EcvCtl.ECV_SetTarget(cmd_data & 0xFFFF);
 }
 
 // do Heartbeat
@@ -602,11 +749,7 @@ void DoHeartbeat(void)
     {
         if (TIMER_EXPIRED(last_HB_tick, HEARTBEAT_ON_INTERVAL))
         {
-            LED_off();      // off
-            if (OutHB && L99dz200g.L99DZ200G_WatchdogRunning())
-            {
-                L99dz200g.L99DZ200G_HSOutputsControl(OFF_OUT, OutHB);
-            }
+            LED_off();      // off (the OutHB output blinks from LampAnim)
             last_HB_state = false;
             last_HB_tick = millis();
         }
@@ -616,10 +759,6 @@ void DoHeartbeat(void)
         if (TIMER_EXPIRED(last_HB_tick, HEARTBEAT_OFF_INTERVAL))
         {
             LED_on();       // on
-            if (OutHB && L99dz200g.L99DZ200G_WatchdogRunning())
-            {
-                L99dz200g.L99DZ200G_HSOutputsControl(ON_OUT, OutHB);
-            }
             last_HB_state = true;
             last_HB_tick = millis();
         }
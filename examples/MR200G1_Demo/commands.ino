@@ -22,8 +22,12 @@
 // Defines for code to be included
 
 #define SHOW_ADC
+#define SHOW_BUS
+#define SHOW_CAPTURE
 #define SHOW_CCM
+#define SHOW_DTC
 #define SHOW_ECV
+#define SHOW_EVLOG
 #define SHOW_HEATER
 #define SHOW_MIRROR
 #define SHOW_MOTOR
@@ -45,13 +49,25 @@ int8_t Cmd_rclr(int8_t argc, char * argv[]);
 #ifdef SHOW_ADC
 int8_t Cmd_adc(int8_t argc, char * argv[]);
 #endif
+#ifdef SHOW_BUS
+int8_t Cmd_bus(int8_t argc, char * argv[]);
+#endif
+#ifdef SHOW_CAPTURE
+int8_t Cmd_cap(int8_t argc, char * argv[]);
+#endif
 #ifdef SHOW_CCM
 int8_t Cmd_ccm(int8_t argc, char * argv[]);
 #endif
 int8_t Cmd_dir(int8_t argc, char * argv[]);
+#ifdef SHOW_DTC
+int8_t Cmd_dtc(int8_t argc, char * argv[]);
+#endif
 #ifdef SHOW_ECV
 int8_t Cmd_ecv(int8_t argc, char * argv[]);
 #endif
+#ifdef SHOW_EVLOG
+int8_t Cmd_evlog(int8_t argc, char * argv[]);
+#endif
 #ifdef SHOW_HEATER
 int8_t Cmd_ghol(int8_t argc, char * argv[]);
 int8_t Cmd_ght(int8_t argc, char * argv[]);
@@ -120,13 +136,25 @@ const char MenuCmdRclr[] PROGMEM  = "rclr";
 #ifdef SHOW_ADC
 const char MenuCmdAdc[] PROGMEM   = "adc";
 #endif
+#ifdef SHOW_BUS
+const char MenuCmdBus[] PROGMEM   = "bus";
+#endif
+#ifdef SHOW_CAPTURE
+const char MenuCmdCap[] PROGMEM   = "cap";
+#endif
 #ifdef SHOW_CCM
 const char MenuCmdCcm[] PROGMEM   = "ccm";
 #endif
 const char MenuCmdDir[] PROGMEM   = "dir";
+#ifdef SHOW_DTC
+const char MenuCmdDtc[] PROGMEM   = "dtc";
+#endif
 #ifdef SHOW_ECV
 const char MenuCmdEcv[] PROGMEM   = "ecv";
 #endif
+#ifdef SHOW_EVLOG
+const char MenuCmdEvlog[] PROGMEM = "evlog";
+#endif
 #ifdef SHOW_HEATER
 const char MenuCmdGhol[] PROGMEM  = "ghol";
 const char MenuCmdGht[] PROGMEM   = "ght";
@@ -181,14 +209,26 @@ const char MenuHelpRclr[] PROGMEM  =    " [reg val] | <all>           : Read/cle
 #ifdef SHOW_ADC
 const char MenuHelpAdc[] PROGMEM   =   " [n | <A> | <B> | <x> | <y>] [<v> | <r>]  : Show analog input value (v = volts, r = raw)";
 #endif
+#ifdef SHOW_BUS
+const char MenuHelpBus[] PROGMEM   =   " [clr|test]                   : Show(clear/test) shared SPI bus statistics";
+#endif
+#ifdef SHOW_CAPTURE
+const char MenuHelpCap[] PROGMEM   =   " [n [rise | fall | mot [thr [pre [uS]]]] | trig | stop | dump]  : Arm[trigger/stop/dump] OUTn current capture";
+#endif
 #ifdef SHOW_CCM
 const char MenuHelpCcm[] PROGMEM   =   " [n [off | on]]               : Show[set] L99DZ200G OUTn constant current mode control";
 #endif
 const char MenuHelpDir[] PROGMEM   =   " [lo | hi]                    : Show[set] DIR output pin";
+#ifdef SHOW_DTC
+const char MenuHelpDtc[] PROGMEM   =   " [clr]                        : Show[clear] diagnostic trouble codes";
+#endif
 #ifdef SHOW_ECV
 const char MenuHelpEcv[] PROGMEM   =   " [[ecoff | econ] | [vm12 | vm15] | [lsoff | lson] | [ocoff | ocon] | volts]"
                                 "\r\n                                 : Show[set] L99DZ200G ECV output control";
 #endif
+#ifdef SHOW_EVLOG
+const char MenuHelpEvlog[] PROGMEM =     " [dump | clr]                : Show[dump/clear] L99DZ200G fault/event log";
+#endif
 #ifdef SHOW_HEATER
 const char MenuHelpGhol[] PROGMEM  =    " [off | on]                  : Show[set] L99DZ200G Heater open-load diagnosis control";
 const char MenuHelpGht[] PROGMEM   =   " [threshold]                  : Show[set] L99DZ200G Heater Drain monitor threshold control";
@@ -254,13 +294,25 @@ const tCmdLineEntry g_sCmdTable[] PROGMEM =
 #ifdef SHOW_ADC
     { MenuCmdAdc,     Cmd_adc,     MenuHelpAdc     },
 #endif
+#ifdef SHOW_BUS
+    { MenuCmdBus,     Cmd_bus,     MenuHelpBus     },
+#endif
+#ifdef SHOW_CAPTURE
+    { MenuCmdCap,     Cmd_cap,     MenuHelpCap     },
+#endif
 #ifdef SHOW_CCM
     { MenuCmdCcm,     Cmd_ccm,     MenuHelpCcm     },
 #endif
     { MenuCmdDir,     Cmd_dir,     MenuHelpDir     },
+#ifdef SHOW_DTC
+    { MenuCmdDtc,     Cmd_dtc,     MenuHelpDtc     },
+#endif
 #ifdef SHOW_ECV
     { MenuCmdEcv,     Cmd_ecv,     MenuHelpEcv     },
 #endif
+#ifdef SHOW_EVLOG
+    { MenuCmdEvlog,   Cmd_evlog,   MenuHelpEvlog   },
+#endif
 #ifdef SHOW_HEATER
     { MenuCmdGhol,    Cmd_ghol,    MenuHelpGhol    },
     { MenuCmdGht,     Cmd_ght,     MenuHelpGht     },
@@ -955,6 +1007,14 @@ int8_t Cmd_init(int8_t argc __attribute__((unused)), char * argv[] __attribute__
     return L99DZ200G_Init();
 }
 
+// heater load shed/restored by the load shedder
+void HeaterShedHandler(uint8_t output, bool shed, void * arg)
+{
+    (void)output;
+    (void)arg;
+    HeaterReg.HeaterReg_Inhibit(shed);
+}
+
 // do L99DZ200G initialization
 uint8_t L99DZ200G_Init(void)
 {
@@ -1001,6 +1061,9 @@ uint8_t L99DZ200G_Init(void)
 
     L99dz200g.L99DZ200G_Set_OCR_AutorecoveryTime(OUT_1_2_3_6, OCR_TON_64US);
     L99dz200g.L99DZ200G_Set_OCR_AutorecoveryFrequency(OUT_1_2_3_6, OCR_FREQ_4_4KHZ);
+
+    // adapt the autorecovery to how the loads behave (motors, arrow bulbs)
+    OcrMon.OcrMon_Begin(OCRMON_ALL_OUTS);
 #endif
 
     // ECV fast discharge activated - this causes -> GSB: 0x08, SR5: 0x000080
@@ -1023,6 +1086,19 @@ uint8_t L99DZ200G_Init(void)
 
     // Setting the Maximum voltage of Electrochromic
     L99dz200g.L99DZ200G_Set_ECV_MaxVoltage(ECV_1_5);
+    EcvCtl.ECV_Begin();
+
+    // mirror heater regulation
+    HeaterReg.HeaterReg_Begin(HEATER_TEMP_CLUSTER, GH_TH_550_MV);
+    HeaterReg.HeaterReg_SetSetpoint(HEATER_SETPOINT_C);
+    HeaterReg.HeaterReg_SetRateLimit(HEATER_RATE_LIMIT);
+    HeaterReg.HeaterReg_SetOpenLoadCheck(OL_DIAG_ON);
+
+    // supply voltage load shedding: the heater regulator holds the heater off while it is shed
+    // (the arrow bulbs are left to the lamp animator and the output sequencer that drive them)
+    LoadShed.LoadShed_AddLoad(OUT_GH, LOADSHED_PRIO_1, HeaterShedHandler, NULL);
+    LoadShed.LoadShed_SetThresholds(SUPPLY_SHED_V, LOADSHED_CLASS_V, LOADSHED_HYST_V);
+    LoadShed.LoadShed_Begin(SUPPLY_EARLY_WARN_V);
 
     // Enabling of the Fast Discharge - this causes -> GSB: 0x08, SR5: 0x000080
 //    L99dz200g.L99DZ200G_Set_ECV_FastDischargeControl(ENABLE);
@@ -1070,6 +1146,7 @@ uint8_t L99DZ200G_Init(void)
  * SPECIAL CONSIDERATIONS:
  *  Temporarily enables L99DZ200G CM/DIR pin as CM output always for OUTn current monitoring,
  *  reads the CM analog input, and then restores the CM/DIR pin as DIR input always.
+ *  An OUTn current is not read while a "cap" capture owns the CM/DIR pin.
  */
 int8_t Cmd_adc(int8_t argc, char * argv[])
 {
@@ -1157,6 +1234,12 @@ int8_t Cmd_adc(int8_t argc, char * argv[])
             }
         }
 
+        if ((item == 'o') && CurCap.Capture_OwnsCM())
+        {
+            Serial.println(F("CM/DIR pin in use by the capture (\"cap stop\" first)"));
+            return 0;
+        }
+
         switch (item)
         {
             case 'x':               // X position
@@ -1299,6 +1382,294 @@ uint16_t GetAnalogValue(uint8_t adc_input)
 }
 #endif
 
+#ifdef SHOW_BUS
+/*
+ * NAME:
+ *  int8_t Cmd_bus(int8_t argc, char * argv[])
+ *
+ * PARAMETERS:
+ *  int8_t argc = number of command line arguments for the command
+ *  char * argv[] = pointer to array of parameters associated with the command
+ *
+ * WHAT:
+ *  Implements the "bus" command to show/clear the shared SPI bus statistics.
+ *
+ *  One optional parameter supported.
+ *   <clr> = clear the shared SPI bus statistics
+ *   <test> = check a L99DZ200G frame is skipped (and counted) while the MCP2515 holds the bus
+ *
+ *       1   2
+ *     "bus"        - show the shared SPI bus statistics
+ *     "bus clr"    - clear the shared SPI bus statistics
+ *     "bus test"   - test L99DZ200G frames with the shared SPI bus held
+ *
+ * RETURN VALUES:
+ *  int8_t = 0 = command successfully processed
+ *
+ * SPECIAL CONSIDERATIONS:
+ *  None.
+ */
+int8_t Cmd_bus(int8_t argc, char * argv[])
+{
+    if (argc > 2)
+    {
+        return CMDLINE_TOO_MANY_ARGS;
+    }
+    else if (argc > 1)
+    {
+        if (strcmp_P(argv[ARG1], PSTR("clr")) == 0)
+        {
+            SpiBus.SPIBus_ClearStats();
+        }
+        else if (strcmp_P(argv[ARG1], PSTR("test")) == 0)
+        {
+            BusHeldTest();
+            return 0;
+        }
+        else
+        {
+            return CMDLINE_INVALID_ARG;
+        }
+    }
+
+    Serial.print(F("L99DZ200G: "));
+    ShowBusStats(L99dz200g.L99DZ200G_BusDevice());
+    Serial.print(F("           frames skipped (bus held): "));
+    Serial.println(L99dz200g.L99DZ200G_BusErrors());
+    Serial.print(F("MCP2515:   "));
+    ShowBusStats(Mcp2515BusDev);
+
+    // Return success.
+    return 0;
+}
+
+// show shared SPI bus statistics of device
+void ShowBusStats(uint8_t dev)
+{
+    SPIBusStats stats;
+
+    SpiBus.SPIBus_GetStats(dev, &stats);
+    Serial.print(F("xfers: "));
+    Serial.print(stats.transactions);
+    Serial.print(F("  held: "));
+    Serial.print(stats.hold_us);
+    Serial.print(F(" uS (max "));
+    Serial.print(stats.max_hold_us);
+    Serial.print(F(" uS)  contended: "));
+    Serial.print(stats.contentions);
+    Serial.print(F("  deferred: "));
+    Serial.println(stats.deferred);
+}
+
+// check a L99DZ200G frame is skipped (CS not asserted) while another device holds the shared SPI bus
+void BusHeldTest(void)
+{
+    uint32_t errors = L99dz200g.L99DZ200G_BusErrors();
+    uint32_t reg_data;
+
+    if (!SpiBus.SPIBus_Acquire(Mcp2515BusDev))
+    {
+        Serial.println(F("Shared SPI bus busy, try again"));
+        return;
+    }
+    reg_data = L99dz200g.L99DZ200G_ReadRegister(L99DZ200G_SR1);
+    SpiBus.SPIBus_Release(Mcp2515BusDev);
+
+    Serial.print(F("Bus held test: "));
+    if ((reg_data == 0) && (L99dz200g.L99DZ200G_BusErrors() == (errors + 1)))
+    {
+        Serial.println(F("PASS"));
+    }
+    else
+    {
+        Serial.println(F("FAIL"));
+    }
+}
+#endif
+
+#ifdef SHOW_CAPTURE
+/*
+ * NAME:
+ *  int8_t Cmd_cap(int8_t argc, char * argv[])
+ *
+ * PARAMETERS:
+ *  int8_t argc = number of command line arguments for the command
+ *  char * argv[] = pointer to array of parameters associated with the command
+ *
+ * WHAT:
+ *  Implements the "cap" command to arm/trigger/stop/dump an OUTn current waveform capture.
+ *
+ *  Up to five optional parameters supported.
+ *   <n> = arm a capture of the OUTn current monitor: (1, 2, 3, 6, 7, 8, 9, 10, 13, 14, 15)
+ *   <rise | fall | mot> = trigger on the current rising/falling to the threshold, or on a
+ *                         motor start (default rise)
+ *   <threshold> = trigger threshold (0 - 1023 ADC counts, default CAP_THRESHOLD)
+ *   <pre> = samples kept before the trigger (0 - (CAPTURE_SIZE - 1), default CAPTURE_SIZE / 4)
+ *   <uS> = sample period (CAPTURE_MIN_PERIOD_US - 65535 uS, default CAP_PERIOD_US)
+ *      -or-
+ *   <trig> = force the trigger
+ *      -or-
+ *   <stop> = stop the capture
+ *      -or-
+ *   <dump> = write the capture (one "uS,ADC counts" line per sample, time from the trigger)
+ *
+ *      1  2  3    4   5   6
+ *     "cap"                    - show the capture state
+ *     "cap 2"                  - arm an OUT2 capture, trigger at CAP_THRESHOLD rising
+ *     "cap 6 mot"              - arm an OUT6 capture, trigger on a motor start
+ *     "cap 1 fall 20 64 2000"  - arm an OUT1 capture, trigger at 20 falling, 64 pre-trigger
+ *                                samples, 2000 uS sample period
+ *     "cap trig"               - force the trigger
+ *     "cap dump"               - write the capture
+ *
+ * RETURN VALUES:
+ *  int8_t = 0 = command successfully processed
+ *
+ * SPECIAL CONSIDERATIONS:
+ *  The L99DZ200G CM/DIR pin is the CM output (OUTn current monitor) while the capture is
+ *  taken, and is restored as DIR input when done or stopped.
+ */
+int8_t Cmd_cap(int8_t argc, char * argv[])
+{
+#define CAP_THRESHOLD   50      // default trigger threshold (ADC counts)
+#define CAP_PERIOD_US   1000    // default sample period (uS)
+    int32_t val;
+    int8_t paramtype;
+    uint8_t pin = L99DZ200G_DIR_PIN;
+    uint8_t out_cm;
+    uint8_t trigger = CAPTURE_TRIG_RISE;
+    uint16_t threshold = CAP_THRESHOLD;
+    uint16_t pre = CAPTURE_SIZE / 4;
+    uint16_t period = CAP_PERIOD_US;
+
+    if (argc > 6)
+    {
+        return CMDLINE_TOO_MANY_ARGS;
+    }
+    else if ((argc == 2) && (strcmp_P(argv[ARG1], PSTR("trig")) == 0))
+    {
+        CurCap.Capture_Trigger();
+    }
+    else if ((argc == 2) && (strcmp_P(argv[ARG1], PSTR("stop")) == 0))
+    {
+        CurCap.Capture_Stop();
+    }
+    else if ((argc == 2) && (strcmp_P(argv[ARG1], PSTR("dump")) == 0))
+    {
+        CurCap.Capture_Dump(Serial);
+        return 0;
+    }
+    else if (argc > 1)
+    {
+        // get the OUTn number
+        paramtype = CmdLine.ParseParam(argv[ARG1], &val);
+        if ((paramtype == BADPARAM) || (paramtype == STRVAL))
+        {
+            return CMDLINE_INVALID_ARG;
+        }
+        switch (val)
+        {
+            case OUT_1:
+            case OUT_2:
+            case OUT_3:
+            case OUT_6:
+            case OUT_7:
+            case OUT_8:
+            case OUT_9:
+            case OUT_10:
+            case OUT_13:
+            case OUT_14:
+            case OUT_15:
+                out_cm = val - 1;                   // OUT_n_CM
+                break;                              // OK
+            default:
+                return CMDLINE_INVALID_ARG;         // invalid
+        }
+
+        if (argc > 2)
+        {
+            // get the trigger type
+            if (strcmp_P(argv[ARG2], PSTR("rise")) == 0)
+            {
+                trigger = CAPTURE_TRIG_RISE;
+            }
+            else if (strcmp_P(argv[ARG2], PSTR("fall")) == 0)
+            {
+                trigger = CAPTURE_TRIG_FALL;
+            }
+            else if (strcmp_P(argv[ARG2], PSTR("mot")) == 0)
+            {
+                trigger = CAPTURE_TRIG_START;
+            }
+            else
+            {
+                return CMDLINE_INVALID_ARG;
+            }
+        }
+
+        if (argc > 3)
+        {
+            // get the trigger threshold
+            paramtype = CmdLine.ParseParam(argv[ARG3], &val);
+            if ((paramtype == BADPARAM) || (paramtype == STRVAL) || (val < 0) || (val > 1023))
+            {
+                return CMDLINE_INVALID_ARG;
+            }
+            threshold = val;
+        }
+
+        if (argc > 4)
+        {
+            // get the pre-trigger samples
+            paramtype = CmdLine.ParseParam(argv[ARG4], &val);
+            if ((paramtype == BADPARAM) || (paramtype == STRVAL) || (val < 0) || (val >= CAPTURE_SIZE))
+            {
+                return CMDLINE_INVALID_ARG;
+            }
+            pre = val;
+        }
+
+        if (argc > 5)
+        {
+            // get the sample period
+            paramtype = CmdLine.ParseParam(argv[ARG5], &val);
+            if ((paramtype == BADPARAM) || (paramtype == STRVAL) ||
+                (val < CAPTURE_MIN_PERIOD_US) || (val > 65535))
+            {
+                return CMDLINE_INVALID_ARG;
+            }
+            period = val;
+        }
+
+        if (CurCap.Capture_Arm(pin, out_cm, period, pre, trigger, threshold) != L99DZ200G_OK)
+        {
+            return CMDLINE_INVALID_ARG;
+        }
+    }
+
+    switch (CurCap.Capture_State())
+    {
+        case CAPTURE_IDLE:
+            Serial.print(F("Capture: idle"));
+            break;
+        case CAPTURE_ARMED:
+            Serial.print(F("Capture: armed"));
+            break;
+        case CAPTURE_TRIGGERED:
+            Serial.print(F("Capture: triggered"));
+            break;
+        case CAPTURE_DONE:
+            Serial.print(F("Capture: done"));
+            break;
+    }
+    Serial.print(F("  late samples: "));
+    Serial.println(CurCap.Capture_Late());
+
+    // Return success.
+    return 0;
+}
+#endif
+
 #ifdef SHOW_CCM
 /*
  * NAME:
@@ -1460,6 +1831,7 @@ void ShowConstantCurrentMode(uint8_t output)
  *
  * SPECIAL CONSIDERATIONS:
  *  Assumes the L99DZ200G CM/DIR pin has been configured as a DIR input pin.
+ *  The DIR output state is not set while a "cap" capture owns the CM/DIR pin.
  */
 int8_t Cmd_dir(int8_t argc, char * argv[])
 {
@@ -1467,6 +1839,11 @@ int8_t Cmd_dir(int8_t argc, char * argv[])
     {
         return CMDLINE_TOO_MANY_ARGS;
     }
+    else if ((argc > 1) && CurCap.Capture_OwnsCM())
+    {
+        Serial.println(F("CM/DIR pin in use by the capture (\"cap stop\" first)"));
+        return 0;
+    }
     else if (argc > 1)
     {
         if (strcmp_P(argv[ARG1], PSTR("lo")) == 0)
@@ -1527,6 +1904,80 @@ void Show_DIR_CM_DIR_States(void)
     ShowHighLow(digitalRead(L99DZ200G_DIR_PIN));
 }
 
+#ifdef SHOW_DTC
+/*
+ * NAME:
+ *  int8_t Cmd_dtc(int8_t argc, char * argv[])
+ *
+ * PARAMETERS:
+ *  int8_t argc = number of command line arguments for the command
+ *  char * argv[] = pointer to array of parameters associated with the command
+ *
+ * WHAT:
+ *  Implements the "dtc" command to show/clear the diagnostic trouble codes.
+ *
+ *  One optional parameter supported.
+ *   <clr> = clear the stored diagnostic trouble codes
+ *
+ *       1   2
+ *     "dtc"        - show the active and stored diagnostic trouble codes
+ *     "dtc clr"    - clear the stored diagnostic trouble codes
+ *
+ * RETURN VALUES:
+ *  int8_t = 0 = command successfully processed
+ *
+ * SPECIAL CONSIDERATIONS:
+ *  None.
+ */
+int8_t Cmd_dtc(int8_t argc, char * argv[])
+{
+    const DTCRecord * rec;
+
+    if (argc > 2)
+    {
+        return CMDLINE_TOO_MANY_ARGS;
+    }
+    else if (argc > 1)
+    {
+        if (strcmp_P(argv[ARG1], PSTR("clr")) == 0)
+        {
+            DtcMgr.DTC_ClearAll();
+        }
+        else
+        {
+            return CMDLINE_INVALID_ARG;
+        }
+    }
+
+    Serial.print(F("Operating minutes: "));
+    Serial.print(DtcMgr.DTC_OperatingMinutes());
+    Serial.print(F("  active DTCs: "));
+    Serial.println(DtcMgr.DTC_ActiveCount());
+
+    for (uint8_t i = 0; i < DtcMgr.DTC_Count(); ++i)
+    {
+        rec = DtcMgr.DTC_Record(i);
+        if ((rec->status & (DTC_ACTIVE_MASK | DTC_STORED_MASK)) == 0)
+        {
+            continue;       // never seen
+        }
+        Serial.print(F(" "));
+        Serial.print((const __FlashStringHelper *)pgm_read_ptr(&DtcNames[i]));
+        Serial.print((rec->status & DTC_ACTIVE_MASK) ? F(": active") : F(": stored"));
+        Serial.print(F("  count: "));
+        Serial.print((rec->status & DTC_OCC_MASK) >> DTC_OCC_POS);
+        Serial.print(F("  first: "));
+        Serial.print(rec->first_min);
+        Serial.print(F("  last: "));
+        Serial.print(rec->last_min);
+        Serial.println(F(" min"));
+    }
+
+    // Return success.
+    return 0;
+}
+#endif
+
 #ifdef SHOW_ECV
 /*
  * NAME:
@@ -1614,10 +2065,12 @@ int8_t Cmd_ecv(int8_t argc, char * argv[])
         else if (strcmp_P(argv[ARG1], PSTR("vm12")) == 0)
         {
             L99dz200g.L99DZ200G_Set_ECV_MaxVoltage(ECV_1_2);
+            EcvCtl.ECV_Begin();
         }
         else if (strcmp_P(argv[ARG1], PSTR("vm15")) == 0)
         {
             L99dz200g.L99DZ200G_Set_ECV_MaxVoltage(ECV_1_5);
+            EcvCtl.ECV_Begin();
         }
         else
         {
@@ -1703,6 +2156,130 @@ void ShowECV_Settings(void)
 }
 #endif
 
+#ifdef SHOW_EVLOG
+/*
+ * NAME:
+ *  int8_t Cmd_evlog(int8_t argc, char * argv[])
+ *
+ * PARAMETERS:
+ *  int8_t argc = number of command line arguments for the command
+ *  char * argv[] = pointer to array of parameters associated with the command
+ *
+ * WHAT:
+ *  Implements the "evlog" command to show/dump/clear the L99DZ200G fault/event log.
+ *
+ *  One optional parameter supported.
+ *   <dump> = write the event log in binary (for offline decoding)
+ *   <clr>  = clear the event log
+ *
+ *       1     2
+ *     "evlog"          - show the event log, oldest event first
+ *     "evlog dump"     - write the event log in binary
+ *     "evlog clr"      - clear the event log
+ *
+ * RETURN VALUES:
+ *  int8_t = 0 = command successfully processed
+ *
+ * SPECIAL CONSIDERATIONS:
+ *  The binary dump is written straight to Serial, a terminal shows it as garbage.
+ */
+int8_t Cmd_evlog(int8_t argc, char * argv[])
+{
+    const EventLogEntry * ev;
+    uint32_t data;
+
+    if (argc > 2)
+    {
+        return CMDLINE_TOO_MANY_ARGS;
+    }
+    else if (argc > 1)
+    {
+        if (strcmp_P(argv[ARG1], PSTR("dump")) == 0)
+        {
+            EventLog.EventLog_Dump(Serial);
+            return 0;
+        }
+        else if (strcmp_P(argv[ARG1], PSTR("clr")) == 0)
+        {
+            EventLog.EventLog_Clear();
+        }
+        else
+        {
+            return CMDLINE_INVALID_ARG;
+        }
+    }
+
+    Serial.print(F("Events: "));
+    Serial.print(EventLog.EventLog_Count());
+    Serial.print(F("  lost: "));
+    Serial.println(EventLog.EventLog_Lost());
+
+    for (uint8_t n = 0; n < EventLog.EventLog_Count(); ++n)
+    {
+        ev = EventLog.EventLog_Entry(n);
+        if (ev->type == EVLOG_TIME)
+        {
+            continue;       // only needed for the event times
+        }
+        data = ev->data[0] | ((uint32_t)ev->data[1] << 8) | ((uint32_t)ev->data[2] << 16);
+        Serial.print(F(" "));
+        Serial.print(EventLog.EventLog_Time(n));
+        Serial.print(F(" mS "));
+        switch (ev->type)
+        {
+            case EVLOG_GSB:
+                Serial.print(F("GSB: "));
+                Print0xHexByte(data);
+                Serial.print(F(" -> "));
+                Print0xHexByteln(ev->reg);
+                break;
+            case EVLOG_SR:
+                Serial.print(F("SR"));
+                Serial.print(ev->reg - L99DZ200G_SR1 + 1);
+                Serial.print(F(": "));
+                Print0xHex24ln(data);
+                break;
+            case EVLOG_WRITE:
+                if (ev->reg == L99DZ200G_CFR)
+                {
+                    Serial.print(F("CFR"));
+                }
+                else
+                {
+                    Serial.print(F("CR"));
+                    Serial.print(ev->reg - L99DZ200G_CR1 + 1);
+                }
+                Serial.print(F(" = "));
+                Print0xHex24ln(data);
+                break;
+            case EVLOG_WDOG_MISS:
+                Serial.print(F("Watchdog trigger late: "));
+                Serial.print(data);
+                Serial.println(F(" mS"));
+                break;
+            case EVLOG_NINT:
+                Serial.println(F("NINT interrupt"));
+                break;
+            case EVLOG_NRESET:
+                Serial.println(F("NRESET reset"));
+                break;
+
+            default:
+                Serial.print(F("Event "));
+                Print0xHexByte(ev->type);
+                Serial.print(F(": "));
+                Print0xHexByte(ev->reg);
+                Serial.print(F(" "));
+                Print0xHex24ln(data);
+                break;
+        }
+    }
+
+    // Return success.
+    return 0;
+}
+#endif
+
 #ifdef SHOW_HEATER
 /*
  * NAME:
@@ -2179,6 +2756,10 @@ int8_t Cmd_motor(int8_t argc, char * argv[])
             }
 
             L99dz200g.L99DZ200G_MotorDriver(outputs, mot_dir);
+            if (mot_dir != BRAKE)
+            {
+                CurCap.Capture_MotorStart();
+            }
         }
         else if (mot_dir == BRAKE)
         {
@@ -2980,7 +3561,17 @@ DEBUG_TOGL();
             }
             else if ((int8_t)output_type == HB_OUT)
             {
-                OutHB = output;
+                if (OutHB && (OutHB != output))
+                {
+                    LampAnim.LampAnim_Set(LAMPANIM_OUT(OutHB), OFF_OUT);
+                }
+                // heartbeat blink stepped by LampAnim_Tick()
+                OutHB = 0;
+                if (LampAnim.LampAnim_Blink(LAMPANIM_OUT(output), HEARTBEAT_ON_INTERVAL,
+                                            HEARTBEAT_OFF_INTERVAL, 0) == L99DZ200G_OK)
+                {
+                    OutHB = output;
+                }
             }
             else
             {
@@ -2988,6 +3579,7 @@ DEBUG_TOGL();
                 {
                     OutHB = 0;
                 }
+                LampAnim.LampAnim_Release(LAMPANIM_OUT(output));
                 L99dz200g.L99DZ200G_HSOutputsControl(output_type, output);
             }
         }
@@ -3125,7 +3717,7 @@ void ShowOutputState(uint8_t output)
         Serial.print(output);
     }
     Serial.print(F(": "));
-    if (OutHB == output)
+    if ((OutHB == output) && (LampAnim.LampAnim_Pattern(output) == LAMPANIM_BLINK))
     {
         Serial.println(F("HB"));
         return;
@@ -3399,23 +3991,29 @@ void DoMirrorOperation(uint8_t cmd)
 
         case F_UNFOLD:
             L99dz200g.L99DZ200G_MotorDriver(OUT6_F, RIGHT_DIRECTION);
+            CurCap.Capture_MotorStart();
             break;
         case F_FOLD:
             L99dz200g.L99DZ200G_MotorDriver(OUT6_F, LEFT_DIRECTION);
+            CurCap.Capture_MotorStart();
             break;
 
         case X_CLOCKWISE:
             L99dz200g.L99DZ200G_MotorDriver(OUT2_X, RIGHT_DIRECTION);
+            CurCap.Capture_MotorStart();
             break;
         case X_C_CLOCKWISE:
             L99dz200g.L99DZ200G_MotorDriver(OUT2_X, LEFT_DIRECTION);
+            CurCap.Capture_MotorStart();
             break;
 
         case Y_CLOCKWISE:
             L99dz200g.L99DZ200G_MotorDriver(OUT3_Y, RIGHT_DIRECTION);
+            CurCap.Capture_MotorStart();
             break;
         case Y_C_CLOCKWISE:
             L99dz200g.L99DZ200G_MotorDriver(OUT3_Y, LEFT_DIRECTION);
+            CurCap.Capture_MotorStart();
             break;
 
         case BRAKE_ALL:
@@ -3424,33 +4022,30 @@ void DoMirrorOperation(uint8_t cmd)
             break;
 
         case HEATER_ON:
-            L99dz200g.L99DZ200G_HeaterOutputControl(ON_OUT);
+            HeaterReg.HeaterReg_Start(HEATER_DEFROST_MS);
             break;
         case HEATER_OFF:
-            L99dz200g.L99DZ200G_HeaterOutputControl(OFF_OUT);
+            HeaterReg.HeaterReg_Stop();
             break;
 
         case ECV_ON:
-            L99dz200g.L99DZ200G_Set_ECV_Control(ENABLE);
-            L99dz200g.L99DZ200G_Set_ECV_DriveVoltage(1.5);
+            EcvCtl.ECV_SetTarget(ECV_1_5_VOLTS * 1000);
             break;
         case ECV_OFF:
-            L99dz200g.L99DZ200G_Set_ECV_DriveVoltage(0);
-            L99dz200g.L99DZ200G_Set_ECV_Control(DISABLE);
+            EcvCtl.ECV_Off();
             break;
 
         case ARROWS_ON:
-            SetArrowsState(ON_OUT);
+            // stop any arrows pattern, then stagger the bulbs' inrush
+            LampAnim.LampAnim_Release(ARROW_OUTS);
+            OutSeq.OutSeq_Start(ArrowsOnSeq, sizeof(ArrowsOnSeq) / sizeof(ArrowsOnSeq[0]));
             break;
         case ARROWS_OFF:
             SetArrowsState(OFF_OUT);
             break;
 
         case ARROWS_FLASHING:
-            SetArrowsState(ON_OUT);
-            L99dz200g.L99DZ200G_Delay(950);
-            SetArrowsState(OFF_OUT);
-            L99dz200g.L99DZ200G_Delay(950);
+            LampAnim.LampAnim_Blink(ARROW_OUTS, 950, 950, 1);
             break;
 
         case CENTER_MIRROR:
@@ -3521,6 +4116,12 @@ void DoMirrorOperation(uint8_t cmd)
             break;
 
         case DEMO_ON:
+            if (CurCap.Capture_OwnsCM())
+            {
+                // the routine reads the OUTn currents on the CM/DIR pin
+                CurCap.Capture_Stop();
+                Serial.println(F("Capture stopped (CM/DIR pin needed)"));
+            }
             SetArrowsState(OFF_OUT);
 
             // ----------OPENING ROUTINE
@@ -3705,37 +4306,16 @@ void DoMirrorOperation(uint8_t cmd)
             }
             L99dz200g.L99DZ200G_MotorDriver(OUT6_F, BRAKE);
 
-            SetArrowsState(ON_OUT);
-            L99dz200g.L99DZ200G_Delay(500);
-            SetArrowsState(OFF_OUT);
-            L99dz200g.L99DZ200G_Delay(500);
-            SetArrowsState(ON_OUT);
-            L99dz200g.L99DZ200G_Delay(500);
-            SetArrowsState(OFF_OUT);
-            L99dz200g.L99DZ200G_Delay(500);
-            SetArrowsState(ON_OUT);
-            L99dz200g.L99DZ200G_Delay(500);
-            SetArrowsState(OFF_OUT);
-            L99dz200g.L99DZ200G_Delay(500);
-            SetArrowsState(ON_OUT);
-            L99dz200g.L99DZ200G_Delay(500);
-            SetArrowsState(OFF_OUT);
+            LampAnim.LampAnim_Blink(ARROW_OUTS, 500, 500, 4);
             break;
     }
 }
 
 void SetArrowsState(uint8_t on_off)
 {
-    if (on_off)
-    {
-        L99dz200g.L99DZ200G_HSOutputsControl(ON_OUT, OUT_7);
-        L99dz200g.L99DZ200G_HSOutputsControl(ON_OUT, OUT_8);
-    }
-    else
-    {
-        L99dz200g.L99DZ200G_HSOutputsControl(OFF_OUT, OUT_7);
-        L99dz200g.L99DZ200G_HSOutputsControl(OFF_OUT, OUT_8);
-    }
+    OutSeq.OutSeq_Stop();
+    // (stops any arrows pattern, both arrows switch in the same SPI frame)
+    LampAnim.LampAnim_Set(ARROW_OUTS, on_off ? ON_OUT : OFF_OUT);
 }
 
 float ReadDataVoltage_X(void)
@@ -3748,7 +4328,7 @@ float ReadDataVoltage_Y(void)
     return GetAnalogValue(MR200G1_Y_POS_PIN);
 }
 
-// OUTn item
+// OUTn item (not while a capture owns the CM/DIR pin)
 float ReadDataVoltage_OUTn(void)
 {
     float adc_value;
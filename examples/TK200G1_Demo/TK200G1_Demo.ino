@@ -154,6 +154,9 @@ CSENSA-----TP29------>|PB0[D16/A2]     ~[D9]PC3|-------TP9--------->|PWMH1A  |
 
 #include <CommandLine.h>
 #include <DLK_L99DZ200G.h>
+#include <DLK_LampAnimator.h>
+#include <DLK_Logger.h>
+#include <DLK_CurrentCapture.h>
 #include <DLK_MCP2515.h>    // MCP2515 CAN Bus library
 
 #include "CANCommunication.h"
@@ -226,10 +229,14 @@ CSENSA-----TP29------>|PB0[D16/A2]     ~[D9]PC3|-------TP9--------->|PWMH1A  |
 #define DEBUG_LO()          digitalWrite(DEBUG_PIN, LOW)
 #define DEBUG_TOGL()        digitalWrite(DEBUG_PIN, !digitalRead(DEBUG_PIN))
 
-#define SPI_CLOCK           250000          // 250 Kbps
+#define MCP2515_SPI_CLOCK   250000          // 250 Kbps
+#define L99DZ200G_SPI_CLOCK L99DZ200G_SPI_MAX_CLOCK // not throttled to the MCP2515 SPI clock
 #define CAN_SPEED           CAN_250KBPS
 
-DLK_MCP2515 Mcp2515(SPI_CLOCK, MCP2515_CS_PIN);
+DLK_SPIBus SpiBus(SPI);         // shared SPI bus arbiter for the L99DZ200G and MCP2515
+
+DLK_MCP2515 Mcp2515(MCP2515_SPI_CLOCK, MCP2515_CS_PIN);
+uint8_t Mcp2515BusDev = SpiBus.SPIBus_AddDevice(SPIBUS_EXTERNAL, SPIBUS_PRIO_NORMAL);
 
 uint8_t Len = 0;    // length of received buffer
 uint8_t Buf[8];     // Buffer to hold up to 8 bytes of data
@@ -237,7 +244,15 @@ uint32_t CanID;     // Can message ID
 
 CommandLine CmdLine(Serial);    // setup CommandLine to use standard Arduino Serial and echo on
 
-DLK_L99DZ200G L99dz200g(SPI_CLOCK, L99DZ200G_CS_PIN);
+DLK_L99DZ200G L99dz200g(SpiBus, L99DZ200G_SPI_CLOCK, L99DZ200G_CS_PIN);
+
+#define TRUNK_LIGHT_OUTS    (LAMPANIM_OUT(OUT_7) | LAMPANIM_OUT(OUT_8))     // trunk light bulbs
+
+DLK_LampAnimator LampAnim(L99dz200g);   // trunk light patterns
+
+DLK_Logger Logger;                      // status messages, written to Serial from loop() without waiting
+
+DLK_CurrentCapture CurCap(L99dz200g);   // H-Bridge/OUTn current waveform capture ("cap" command)
 
 // Define State Machine
 #define IDLE                0
@@ -285,6 +300,7 @@ void L99DZ200G_Reset(void)
 void setup()
 {
     uint32_t start_time = millis();
+    uint8_t ret;
 
     // init heartbeat LED
     pinMode(LED_PIN, OUTPUT);
@@ -383,7 +399,10 @@ void setup()
     }
 
     // Initialize MCP2515 running at 8MHz with a baudrate of 250kb/s
-    if (Mcp2515.MCP2515_Init(CAN_SPEED) == MCP2515_OK)
+    SpiBus.SPIBus_Acquire(Mcp2515BusDev);
+    ret = Mcp2515.MCP2515_Init(CAN_SPEED);
+    SpiBus.SPIBus_Release(Mcp2515BusDev);
+    if (ret == MCP2515_OK)
     {
         Serial.println(F("MCP2515 Initialized Successfully!"));
     }
@@ -396,13 +415,8 @@ void setup()
         }
     }
 
-    for (uint8_t i = 0; i < 3; i++)
-    {
-        TrunkLightsControl(ON_OUT);
-        L99dz200g.L99DZ200G_Delay(500);
-        TrunkLightsControl(OFF_OUT);
-        L99dz200g.L99DZ200G_Delay(500);
-    }
+    // blink the trunk lights 3 times (stepped from loop())
+    LampAnim.LampAnim_Blink(TRUNK_LIGHT_OUTS, 500, 500, 3);
 }
 
 void loop()
@@ -416,7 +430,9 @@ void loop()
     static uint32_t last_sr5 = 0xff0000;
     uint8_t gsb;
     uint32_t reg;
+    uint32_t sr[5];
     CAN_FRAME frame;
+    bool can_recv;
 
     if (new_prompt)
     {
@@ -443,51 +459,55 @@ void loop()
             {
 DEBUG_TOGL();
                 last_gsb = gsb;
-                Serial.print(F("GSB: "));
-                Print0xHexByteln(gsb);
+                LOG_W(Logger, "GSB: 0x%02lX", gsb);
 DEBUG_TOGL();
             }
 
-            reg = L99dz200g.L99DZ200G_ReadRegister(L99DZ200G_SR1) & FULL_REG_MASK;
+            // read SR1 to SR5 in a single SPI session
+            {
+                DLK_L99DZ200G_Session session(L99dz200g);
+
+                for (uint8_t i = 0; i < 5; ++i)
+                {
+                    sr[i] = L99dz200g.L99DZ200G_ReadRegister(L99DZ200G_SR1 + i) & FULL_REG_MASK;
+                }
+            }
+
+            reg = sr[0];
             if ((reg != 0) && (reg != last_sr1))
             {
 DEBUG_TOGL();
                 last_sr1 = reg;
-                Serial.print(F("SR1: "));
-                Print0xHex24ln(reg);
+                LOG_W(Logger, "SR1: 0x%06lX", reg);
 DEBUG_TOGL();
             }
 
-            reg = L99dz200g.L99DZ200G_ReadRegister(L99DZ200G_SR2) & FULL_REG_MASK;
+            reg = sr[1];
             if ((reg != 0) && (reg != last_sr2))
             {
                 last_sr2 = reg;
-                Serial.print(F("SR2: "));
-                Print0xHex24ln(reg);
+                LOG_W(Logger, "SR2: 0x%06lX", reg);
             }
 
-            reg = L99dz200g.L99DZ200G_ReadRegister(L99DZ200G_SR3) & FULL_REG_MASK;
+            reg = sr[2];
             if ((reg != 0) && (reg != last_sr3))
             {
                 last_sr3 = reg;
-                Serial.print(F("SR3: "));
-                Print0xHex24ln(reg);
+                LOG_W(Logger, "SR3: 0x%06lX", reg);
             }
 
-            reg = L99dz200g.L99DZ200G_ReadRegister(L99DZ200G_SR4) & FULL_REG_MASK;
+            reg = sr[3];
             if ((reg != 0) && (reg != last_sr4))
             {
                 last_sr4 = reg;
-                Serial.print(F("SR4: "));
-                Print0xHex24ln(reg);
+                LOG_W(Logger, "SR4: 0x%06lX", reg);
             }
 
-            reg = L99dz200g.L99DZ200G_ReadRegister(L99DZ200G_SR5) & FULL_REG_MASK;
+            reg = sr[4];
             if ((reg != 0) && (reg != last_sr5))
             {
                 last_sr5 = reg;
-                Serial.print(F("SR5: "));
-                Print0xHex24ln(reg);
+                LOG_W(Logger, "SR5: 0x%06lX", reg);
             }
         }
     }
@@ -506,7 +526,7 @@ DEBUG_TOGL();
                 yield();    // needed by ESP8266 to prevent Soft WDT reset "rst cause:2, boot mode:(3,6)"
             }
         }
-        Serial.println(F("L99DZ200G Interrupt!"));
+        LOG_W(Logger, "L99DZ200G Interrupt!");
     }
     else if (L99DZ200G_ResetFlag)
     {
@@ -524,13 +544,18 @@ DEBUG_TOGL();
                 yield();    // needed by ESP8266 to prevent Soft WDT reset "rst cause:2, boot mode:(3,6)"
             }
         }
-        Serial.println(F("L99DZ200G Reset!"));
+        LOG_W(Logger, "L99DZ200G Reset!");
     }
 
     // uses polling of MCP2515 to determine if CAN data available
-    if (Mcp2515.MCP2515_Recv(&frame) == MCP2515_OK) // check if data is coming in
+    if (SpiBus.SPIBus_Acquire(Mcp2515BusDev))
     {
-        ProcessCanMsg(&frame);
+        can_recv = (Mcp2515.MCP2515_Recv(&frame) == MCP2515_OK);   // check if data is coming in
+        SpiBus.SPIBus_Release(Mcp2515BusDev);
+        if (can_recv)
+        {
+            ProcessCanMsg(&frame);
+        }
     }
 
     HandlePositionInputs();
@@ -540,6 +565,20 @@ DEBUG_TOGL();
         RunTrunkLiftgateTestOperations();
     }
 
+    // If watchdog is not running, assumes L99DZ200G is in a standby mode
+    // and should not be disturbed by SPI communications!
+    if (L99dz200g.L99DZ200G_WatchdogRunning())
+    {
+        // step lamp patterns (no SPI traffic unless a lamp changes)
+        LampAnim.LampAnim_Tick();
+    }
+
+    // sample the captured current when due (no SPI traffic)
+    CurCap.Capture_Tick();
+
+    // print logged messages as Serial allows
+    Logger.Log_Drain(Serial);
+
     // do other stuff here
 
     // do Heartbeat
@@ -550,6 +589,7 @@ void ProcessCanMsg(CAN_FRAME * frame)
 {
     uint32_t * cmd_ptr;
     uint32_t cmd_data;
+    uint32_t data_hi;
     uint8_t cmd = TRUNK_STOP_CMD;
 
     // Read data, Len: data length, Buf: data buffer
@@ -557,27 +597,12 @@ void ProcessCanMsg(CAN_FRAME * frame)
     Len = frame->can_dlc;
     memcpy(Buf, frame->can_data, Len);
 
-    Serial.print(F("CAN ID: 0x"));
-    Serial.print(CanID, HEX);       // print the CAN ID in HEX
-
-    Serial.print(F("    Data Length: ")); // Print the length of the received data
-    Serial.print(Len);
-    Serial.print(F("    "));
-
-    for (int i = 0; i < Len; i++)    // loop on the incoming data to print each byte
-    {
-        Serial.print(Buf[i]);     
-//            Serial.print(Buf[i], HEX);     
-        if (i < Len - 1)
-        {
-            Serial.print(',');      // Separate the numbers for readability
-        }
-    }
-    Serial.print(F(" ("));
     cmd_ptr = (uint32_t *)frame->can_data;
     cmd_data = *cmd_ptr;
-    Print0xHex32(cmd_data);
-    Serial.println(')');
+    data_hi = cmd_ptr[1];
+
+    // only logged here, printed later from loop() so Serial does not delay the command
+    LOG_I(Logger, "CAN ID: 0x%lX    Data Length: %lu    (0x%08lX 0x%08lX)", CanID, Len, cmd_data, data_hi);
 
     if (CanID == SID_MOTOR)
     {
@@ -613,6 +638,7 @@ void ProcessCanMsg(CAN_FRAME * frame)
                 SetHBridgePwmSetting(H_BRIDGE_CONTROL_B, 50);
                 L99dz200g.L99DZ200G_Set_HB_SingleMotorClockwise(H_BRIDGE_CONTROL_A);
                 L99dz200g.L99DZ200G_Set_HB_SingleMotorClockwise(H_BRIDGE_CONTROL_B);
+                CurCap.Capture_MotorStart();
                 State = IDLE;
                 break;
 
@@ -621,6 +647,7 @@ void ProcessCanMsg(CAN_FRAME * frame)
                 SetHBridgePwmSetting(H_BRIDGE_CONTROL_B, 50);
                 L99dz200g.L99DZ200G_Set_HB_SingleMotorCounterClockwise(H_BRIDGE_CONTROL_A);
                 L99dz200g.L99DZ200G_Set_HB_SingleMotorCounterClockwise(H_BRIDGE_CONTROL_B);
+                CurCap.Capture_MotorStart();
                 State = IDLE;
                 break;
 
@@ -662,16 +689,28 @@ void HandlePositionInputs(void)
     posA = digitalRead(TK200G1_M_POSA_PIN);
     if (last_posA != posA)
     {
-        Serial.print(F("M_POSA: "));
-        Serial.println(posA ? "HI" : "LO");
+        if (posA)
+        {
+            LOG_I(Logger, "M_POSA: HI");
+        }
+        else
+        {
+            LOG_I(Logger, "M_POSA: LO");
+        }
         last_posA = posA;
     }
 
     posB = digitalRead(TK200G1_M_POSB_PIN);
     if (last_posB != posB)
     {
-        Serial.print(F("M_POSB: "));
-        Serial.println(posB ? "HI" : "LO");
+        if (posB)
+        {
+            LOG_I(Logger, "M_POSB: HI");
+        }
+        else
+        {
+            LOG_I(Logger, "M_POSB: LO");
+        }
         last_posB = posB;
     }
 }
@@ -697,7 +736,7 @@ void RunTrunkLiftgateTestOperations(void)
     {
         case TRUNK_UNLOCK:
             // lights on, trunk unlock
-            Serial.println(F(" Unlocking"));
+            LOG_I(Logger, " Unlocking");
             TrunkLightsControl(ON_OUT);
             TrunkUnlock(TrunkPwmDutyCycle);
             ms_delay = 3000;
@@ -706,7 +745,7 @@ void RunTrunkLiftgateTestOperations(void)
 
         case TRUNK_WAIT1:
             // wait n seconds, trunk unlock stop, lights off
-            Serial.println(F(" Wait1"));
+            LOG_I(Logger, " Wait1");
             TrunkLockStop();
             TrunkLightsControl(OFF_OUT);
             ms_delay = 1000;
@@ -715,7 +754,7 @@ void RunTrunkLiftgateTestOperations(void)
 
         case TRUNK_OPEN:
             // lights on, trunk open
-            Serial.println(F(" Opening"));
+            LOG_I(Logger, " Opening");
             TrunkLightsControl(ON_OUT);
             TrunkLiftOpen(TrunkPwmDutyCycle);
             ms_delay = 3000;
@@ -724,7 +763,7 @@ void RunTrunkLiftgateTestOperations(void)
 
         case TRUNK_WAIT2:
             // wait n seconds, trunk open stop, lights off
-            Serial.println(F(" Wait2"));
+            LOG_I(Logger, " Wait2");
             TrunkLiftStop();
             TrunkLightsControl(OFF_OUT);
             ms_delay = 3000;
@@ -733,7 +772,7 @@ void RunTrunkLiftgateTestOperations(void)
 
         case TRUNK_CLOSE:
             // lights on, trunk close
-            Serial.println(F(" Closing"));
+            LOG_I(Logger, " Closing");
             TrunkLightsControl(ON_OUT);
             TrunkLiftClose(TrunkPwmDutyCycle);
             ms_delay = 3000;
@@ -742,7 +781,7 @@ void RunTrunkLiftgateTestOperations(void)
 
         case TRUNK_WAIT3:
             // wait n seconds, trunk close stop, lights off
-            Serial.println(F(" Wait3"));
+            LOG_I(Logger, " Wait3");
             TrunkLiftStop();
             TrunkLightsControl(OFF_OUT);
             ms_delay = 1000;
@@ -751,7 +790,7 @@ void RunTrunkLiftgateTestOperations(void)
 
         case TRUNK_LOCK:
             // lights on, trunk lock
-            Serial.println(F(" Locking"));
+            LOG_I(Logger, " Locking");
             TrunkLightsControl(ON_OUT);
             TrunkLock(TrunkPwmDutyCycle);
             ms_delay = 3000;
@@ -760,7 +799,7 @@ void RunTrunkLiftgateTestOperations(void)
 
         case TRUNK_WAIT4:
             // wait n seconds, trunk lock stop, lights off
-            Serial.println(F(" Wait4/Done"));
+            LOG_I(Logger, " Wait4/Done");
             TrunkLockStop();
             TrunkLightsControl(OFF_OUT);
             ms_delay = 10000;
@@ -780,11 +819,7 @@ void DoHeartbeat(void)
     {
         if (TIMER_EXPIRED(last_HB_tick, HEARTBEAT_ON_INTERVAL))
         {
-            LED_off();      // off
-            if (OutHB && L99dz200g.L99DZ200G_WatchdogRunning())
-            {
-                L99dz200g.L99DZ200G_HSOutputsControl(OFF_OUT, OutHB);
-            }
+            LED_off();      // off (the OutHB output blinks from LampAnim)
             last_HB_state = false;
             last_HB_tick = millis();
         }
@@ -794,10 +829,6 @@ void DoHeartbeat(void)
         if (TIMER_EXPIRED(last_HB_tick, HEARTBEAT_OFF_INTERVAL))
         {
             LED_on();       // on
-            if (OutHB && L99dz200g.L99DZ200G_WatchdogRunning())
-            {
-                L99dz200g.L99DZ200G_HSOutputsControl(ON_OUT, OutHB);
-            }
             last_HB_state = true;
             last_HB_tick = millis();
         }
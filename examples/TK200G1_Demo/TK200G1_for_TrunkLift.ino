@@ -30,6 +30,7 @@ void TrunkEnableHB(uint8_t trunk_cmd)
         case TRUNK_UNLOCK:
             L99dz200g.L99DZ200G_Set_HB_Control(H_BRIDGE_CONTROL_A, ENABLE);
             L99dz200g.L99DZ200G_Set_HB_Control(H_BRIDGE_CONTROL_B, ENABLE);
+            CurCap.Capture_MotorStart();
             break;
 
         case TRUNK_STOP:
@@ -334,7 +335,7 @@ void TrunkLockWithDelay(uint8_t duty, uint32_t ms_delay)
 // ON_OUT or OFF_OUT
 void TrunkLightsControl(uint8_t output_type)
 {
-    L99dz200g.L99DZ200G_HSOutputsControl(output_type, OUT_7);
-    L99dz200g.L99DZ200G_HSOutputsControl(output_type, OUT_8);
+    // (stops any trunk lights pattern, both lamps switch in the same SPI frame)
+    LampAnim.LampAnim_Set(TRUNK_LIGHT_OUTS, output_type);
 }
 
@@ -22,11 +22,13 @@
 // Defines for code to be included
 
 #define SHOW_ADC
+#define SHOW_BUS
 #define SHOW_PWM
 #define SHOW_STAT
 #define SHOW_TIMER
 #define SHOW_HBRIDGE
 #define SHOW_TRUNK
+#define SHOW_CAPTURE
 
 // local function prototypes
 int8_t Cmd_help(int8_t argc, char * argv[]);
@@ -37,6 +39,12 @@ int8_t Cmd_rclr(int8_t argc, char * argv[]);
 #ifdef SHOW_ADC
 int8_t Cmd_adc(int8_t argc, char * argv[]);
 #endif
+#ifdef SHOW_BUS
+int8_t Cmd_bus(int8_t argc, char * argv[]);
+#endif
+#ifdef SHOW_CAPTURE
+int8_t Cmd_cap(int8_t argc, char * argv[]);
+#endif
 int8_t Cmd_dir(int8_t argc, char * argv[]);
 int8_t Cmd_gsb(int8_t argc, char * argv[]);
 int8_t Cmd_init(int8_t argc, char * argv[]);
@@ -82,6 +90,12 @@ const char MenuCmdRclr[] PROGMEM  = "rclr";
 #ifdef SHOW_ADC
 const char MenuCmdAdc[] PROGMEM   = "adc";
 #endif
+#ifdef SHOW_BUS
+const char MenuCmdBus[] PROGMEM   = "bus";
+#endif
+#ifdef SHOW_CAPTURE
+const char MenuCmdCap[] PROGMEM   = "cap";
+#endif
 const char MenuCmdDir[] PROGMEM   = "dir";
 const char MenuCmdGsb[] PROGMEM   = "gsb";
 const char MenuCmdInit[] PROGMEM  = "init";
@@ -113,6 +127,12 @@ const char MenuHelpRclr[] PROGMEM  =    " [reg val] | <all>           : Read/cle
 #ifdef SHOW_ADC
 const char MenuHelpAdc[] PROGMEM   =   " [n | <A> | <B>] [<v> | <r>]  : Show analog input value (v = volts, r = raw)";
 #endif
+#ifdef SHOW_BUS
+const char MenuHelpBus[] PROGMEM   =   " [clr]                        : Show(clear) shared SPI bus statistics";
+#endif
+#ifdef SHOW_CAPTURE
+const char MenuHelpCap[] PROGMEM   =   " [A | B | n [rise | fall | mot [thr [pre [uS]]]] | trig | stop | dump]  : Arm[trigger/stop/dump] current capture";
+#endif
 const char MenuHelpDir[] PROGMEM   =   " [lo | hi]                    : Show[set] DIR output pin";
 const char MenuHelpGsb[] PROGMEM   =   "                              : Show L99DZ200G Global Status Byte";
 const char MenuHelpInit[] PROGMEM  =    "                             : Init L99DZ200G";
@@ -155,6 +175,12 @@ const tCmdLineEntry g_sCmdTable[] PROGMEM =
     { MenuCmdRclr,    Cmd_rclr,    MenuHelpRclr    },
 #ifdef SHOW_ADC
     { MenuCmdAdc,     Cmd_adc,     MenuHelpAdc     },
+#endif
+#ifdef SHOW_BUS
+    { MenuCmdBus,     Cmd_bus,     MenuHelpBus     },
+#endif
+#ifdef SHOW_CAPTURE
+    { MenuCmdCap,     Cmd_cap,     MenuHelpCap     },
 #endif
     { MenuCmdDir,     Cmd_dir,     MenuHelpDir     },
     { MenuCmdGsb,     Cmd_gsb,     MenuHelpGsb     },
@@ -675,6 +701,7 @@ uint8_t L99DZ200G_Init(void)
  * SPECIAL CONSIDERATIONS:
  *  Temporarily enables L99DZ200G CM/DIR pin as CM output always for OUTn current monitoring,
  *  reads the CM analog input, and then restores the CM/DIR pin as DIR input always.
+ *  An OUTn current is not read while a "cap" capture owns the CM/DIR pin.
  */
 int8_t Cmd_adc(int8_t argc, char * argv[])
 {
@@ -756,6 +783,12 @@ int8_t Cmd_adc(int8_t argc, char * argv[])
             }
         }
 
+        if ((item == 'o') && CurCap.Capture_OwnsCM())
+        {
+            Serial.println(F("CM/DIR pin in use by the capture (\"cap stop\" first)"));
+            return 0;
+        }
+
         switch (item)
         {
             case 'a':               // H-Bridge A current sense
@@ -881,6 +914,264 @@ uint16_t GetAnalogValue(uint8_t adc_input)
 }
 #endif
 
+#ifdef SHOW_BUS
+/*
+ * NAME:
+ *  int8_t Cmd_bus(int8_t argc, char * argv[])
+ *
+ * PARAMETERS:
+ *  int8_t argc = number of command line arguments for the command
+ *  char * argv[] = pointer to array of parameters associated with the command
+ *
+ * WHAT:
+ *  Implements the "bus" command to show/clear the shared SPI bus statistics.
+ *
+ *  One optional parameter supported.
+ *   <clr> = clear the shared SPI bus statistics
+ *
+ *       1   2
+ *     "bus"        - show the shared SPI bus statistics
+ *     "bus clr"    - clear the shared SPI bus statistics
+ *
+ * RETURN VALUES:
+ *  int8_t = 0 = command successfully processed
+ *
+ * SPECIAL CONSIDERATIONS:
+ *  None.
+ */
+int8_t Cmd_bus(int8_t argc, char * argv[])
+{
+    if (argc > 2)
+    {
+        return CMDLINE_TOO_MANY_ARGS;
+    }
+    else if (argc > 1)
+    {
+        if (strcmp_P(argv[ARG1], PSTR("clr")) == 0)
+        {
+            SpiBus.SPIBus_ClearStats();
+        }
+        else
+        {
+            return CMDLINE_INVALID_ARG;
+        }
+    }
+
+    Serial.print(F("L99DZ200G: "));
+    ShowBusStats(L99dz200g.L99DZ200G_BusDevice());
+    Serial.print(F("MCP2515:   "));
+    ShowBusStats(Mcp2515BusDev);
+
+    // Return success.
+    return 0;
+}
+
+// show shared SPI bus statistics of device
+void ShowBusStats(uint8_t dev)
+{
+    SPIBusStats stats;
+
+    SpiBus.SPIBus_GetStats(dev, &stats);
+    Serial.print(F("xfers: "));
+    Serial.print(stats.transactions);
+    Serial.print(F("  held: "));
+    Serial.print(stats.hold_us);
+    Serial.print(F(" uS (max "));
+    Serial.print(stats.max_hold_us);
+    Serial.print(F(" uS)  contended: "));
+    Serial.print(stats.contentions);
+    Serial.print(F("  deferred: "));
+    Serial.println(stats.deferred);
+}
+#endif
+
+#ifdef SHOW_CAPTURE
+/*
+ * NAME:
+ *  int8_t Cmd_cap(int8_t argc, char * argv[])
+ *
+ * PARAMETERS:
+ *  int8_t argc = number of command line arguments for the command
+ *  char * argv[] = pointer to array of parameters associated with the command
+ *
+ * WHAT:
+ *  Implements the "cap" command to arm/trigger/stop/dump an H-Bridge or OUTn current waveform
+ *  capture.
+ *
+ *  Up to five optional parameters supported.
+ *   <A | B | n> = arm a capture of the H-Bridge A/B current sense or the OUTn current
+ *                 monitor: (7, 8)
+ *   <rise | fall | mot> = trigger on the current rising/falling to the threshold, or on a
+ *                         motor start (default rise)
+ *   <threshold> = trigger threshold (0 - 1023 ADC counts, default CAP_THRESHOLD)
+ *   <pre> = samples kept before the trigger (0 - (CAPTURE_SIZE - 1), default CAPTURE_SIZE / 4)
+ *   <uS> = sample period (CAPTURE_MIN_PERIOD_US - 65535 uS, default CAP_PERIOD_US)
+ *      -or-
+ *   <trig> = force the trigger
+ *      -or-
+ *   <stop> = stop the capture
+ *      -or-
+ *   <dump> = write the capture (one "uS,ADC counts" line per sample, time from the trigger)
+ *
+ *      1  2  3    4   5   6
+ *     "cap"                    - show the capture state
+ *     "cap a"                  - arm an H-Bridge A capture, trigger at CAP_THRESHOLD rising
+ *     "cap b mot"              - arm an H-Bridge B capture, trigger on a motor start
+ *     "cap 7 fall 20 64 2000"  - arm an OUT7 capture, trigger at 20 falling, 64 pre-trigger
+ *                                samples, 2000 uS sample period
+ *     "cap trig"               - force the trigger
+ *     "cap dump"               - write the capture
+ *
+ * RETURN VALUES:
+ *  int8_t = 0 = command successfully processed
+ *
+ * SPECIAL CONSIDERATIONS:
+ *  For OUTn the L99DZ200G CM/DIR pin is the CM output (OUTn current monitor) while the
+ *  capture is taken, and is restored as DIR input when done or stopped.
+ */
+int8_t Cmd_cap(int8_t argc, char * argv[])
+{
+#define CAP_THRESHOLD   50      // default trigger threshold (ADC counts)
+#define CAP_PERIOD_US   1000    // default sample period (uS)
+    int32_t val;
+    int8_t paramtype;
+    uint8_t pin = L99DZ200G_DIR_PIN;
+    uint8_t out_cm = CAPTURE_NO_CM;
+    uint8_t trigger = CAPTURE_TRIG_RISE;
+    uint16_t threshold = CAP_THRESHOLD;
+    uint16_t pre = CAPTURE_SIZE / 4;
+    uint16_t period = CAP_PERIOD_US;
+
+    if (argc > 6)
+    {
+        return CMDLINE_TOO_MANY_ARGS;
+    }
+    else if ((argc == 2) && (strcmp_P(argv[ARG1], PSTR("trig")) == 0))
+    {
+        CurCap.Capture_Trigger();
+    }
+    else if ((argc == 2) && (strcmp_P(argv[ARG1], PSTR("stop")) == 0))
+    {
+        CurCap.Capture_Stop();
+    }
+    else if ((argc == 2) && (strcmp_P(argv[ARG1], PSTR("dump")) == 0))
+    {
+        CurCap.Capture_Dump(Serial);
+        return 0;
+    }
+    else if (argc > 1)
+    {
+        if ((tolower(argv[ARG1][0]) == 'a') && (argv[ARG1][1] == '\0'))
+        {
+            pin = TK200G1_C_SENS_A_PIN;     // H-Bridge A current sense
+        }
+        else if ((tolower(argv[ARG1][0]) == 'b') && (argv[ARG1][1] == '\0'))
+        {
+            pin = TK200G1_C_SENS_B_PIN;     // H-Bridge B current sense
+        }
+        else
+        {
+            // get the OUTn number
+            paramtype = CmdLine.ParseParam(argv[ARG1], &val);
+            if ((paramtype == BADPARAM) || (paramtype == STRVAL))
+            {
+                return CMDLINE_INVALID_ARG;
+            }
+            switch (val)
+            {
+                case OUT_7:
+                case OUT_8:
+                    out_cm = val - 1;               // OUT_n_CM
+                    break;                          // OK
+                default:
+                    return CMDLINE_INVALID_ARG;     // invalid
+            }
+        }
+
+        if (argc > 2)
+        {
+            // get the trigger type
+            if (strcmp_P(argv[ARG2], PSTR("rise")) == 0)
+            {
+                trigger = CAPTURE_TRIG_RISE;
+            }
+            else if (strcmp_P(argv[ARG2], PSTR("fall")) == 0)
+            {
+                trigger = CAPTURE_TRIG_FALL;
+            }
+            else if (strcmp_P(argv[ARG2], PSTR("mot")) == 0)
+            {
+                trigger = CAPTURE_TRIG_START;
+            }
+            else
+            {
+                return CMDLINE_INVALID_ARG;
+            }
+        }
+
+        if (argc > 3)
+        {
+            // get the trigger threshold
+            paramtype = CmdLine.ParseParam(argv[ARG3], &val);
+            if ((paramtype == BADPARAM) || (paramtype == STRVAL) || (val < 0) || (val > 1023))
+            {
+                return CMDLINE_INVALID_ARG;
+            }
+            threshold = val;
+        }
+
+        if (argc > 4)
+        {
+            // get the pre-trigger samples
+            paramtype = CmdLine.ParseParam(argv[ARG4], &val);
+            if ((paramtype == BADPARAM) || (paramtype == STRVAL) || (val < 0) || (val >= CAPTURE_SIZE))
+            {
+                return CMDLINE_INVALID_ARG;
+            }
+            pre = val;
+        }
+
+        if (argc > 5)
+        {
+            // get the sample period
+            paramtype = CmdLine.ParseParam(argv[ARG5], &val);
+            if ((paramtype == BADPARAM) || (paramtype == STRVAL) ||
+                (val < CAPTURE_MIN_PERIOD_US) || (val > 65535))
+            {
+                return CMDLINE_INVALID_ARG;
+            }
+            period = val;
+        }
+
+        if (CurCap.Capture_Arm(pin, out_cm, period, pre, trigger, threshold) != L99DZ200G_OK)
+        {
+            return CMDLINE_INVALID_ARG;
+        }
+    }
+
+    switch (CurCap.Capture_State())
+    {
+        case CAPTURE_IDLE:
+            Serial.print(F("Capture: idle"));
+            break;
+        case CAPTURE_ARMED:
+            Serial.print(F("Capture: armed"));
+            break;
+        case CAPTURE_TRIGGERED:
+            Serial.print(F("Capture: triggered"));
+            break;
+        case CAPTURE_DONE:
+            Serial.print(F("Capture: done"));
+            break;
+    }
+    Serial.print(F("  late samples: "));
+    Serial.println(CurCap.Capture_Late());
+
+    // Return success.
+    return 0;
+}
+#endif
+
 /*
  * NAME:
  *  int8_t Cmd_dir(int8_t argc, char * argv[])
@@ -909,6 +1200,7 @@ uint16_t GetAnalogValue(uint8_t adc_input)
  *
  * SPECIAL CONSIDERATIONS:
  *  Assumes the L99DZ200G CM/DIR pin has been configured as a DIR input pin.
+ *  The DIR output state is not set while a "cap" capture owns the CM/DIR pin.
  */
 int8_t Cmd_dir(int8_t argc, char * argv[])
 {
@@ -916,6 +1208,11 @@ int8_t Cmd_dir(int8_t argc, char * argv[])
     {
         return CMDLINE_TOO_MANY_ARGS;
     }
+    else if ((argc > 1) && CurCap.Capture_OwnsCM())
+    {
+        Serial.println(F("CM/DIR pin in use by the capture (\"cap stop\" first)"));
+        return 0;
+    }
     else if (argc > 1)
     {
         if (strcmp_P(argv[ARG1], PSTR("lo")) == 0)
@@ -1146,7 +1443,17 @@ DEBUG_TOGL();
             }
             else if ((int8_t)output_type == HB_OUT)
             {
-                OutHB = output;
+                if (OutHB && (OutHB != output))
+                {
+                    LampAnim.LampAnim_Set(LAMPANIM_OUT(OutHB), OFF_OUT);
+                }
+                // heartbeat blink stepped by LampAnim_Tick()
+                OutHB = 0;
+                if (LampAnim.LampAnim_Blink(LAMPANIM_OUT(output), HEARTBEAT_ON_INTERVAL,
+                                            HEARTBEAT_OFF_INTERVAL, 0) == L99DZ200G_OK)
+                {
+                    OutHB = output;
+                }
             }
             else
             {
@@ -1154,6 +1461,7 @@ DEBUG_TOGL();
                 {
                     OutHB = 0;
                 }
+                LampAnim.LampAnim_Release(LAMPANIM_OUT(output));
                 L99dz200g.L99DZ200G_HSOutputsControl(output_type, output);
             }
         }
@@ -1267,7 +1575,7 @@ void ShowOutputState(uint8_t output)
     Serial.print(F("OUT"));
     Serial.print(output);
     Serial.print(F(": "));
-    if (OutHB == output)
+    if ((OutHB == output) && (LampAnim.LampAnim_Pattern(output) == LAMPANIM_BLINK))
     {
         Serial.println(F("HB"));
         return;
@@ -3273,6 +3581,7 @@ DEBUG_TOGL();
                 {
                     L99dz200g.L99DZ200G_Set_HB_SingleMotorClockwise(hbridge);
                 }
+                CurCap.Capture_MotorStart();
             }
 
         }
@@ -0,0 +1,211 @@
+/** \file TelemetryDecoder.cpp */
+/*
+ * NAME: TelemetryDecoder.cpp
+ *
+ * WHAT:
+ *  Host decoder for the DLK_Telemetry L99DZ200G binary telemetry stream.
+ *
+ *  Reads the raw serial stream (a capture file, or stdin), splits it into frames at the
+ *  0x00 delimiters, COBS decodes and CRC checks each frame and writes one CSV line per good
+ *  frame to stdout:
+ *      seq,ms,gsb,sr1,...,sr12,tcl1,...,tcl6,vsreg,vs,vwu,ch0,...,ch3
+ *  (registers in hex, temperatures in Celsius, voltages in Volts). Bad frames, sequence
+ *  gaps and a summary are reported to stderr.
+ *
+ *  Build:  g++ -O2 -o TelemetryDecoder TelemetryDecoder.cpp
+ *  Use:    stty -F /dev/ttyUSB0 115200 raw; ./TelemetryDecoder /dev/ttyUSB0 > log.csv
+ *
+ * SPECIAL CONSIDERATIONS:
+ *  Must match the frame layout of src/DLK_Telemetry.h (TELEM_FRAME_STATUS version 1).
+ *  Text output mixed into the stream (command echo, prompts) only costs the frame it is
+ *  mixed into.
+ *
+ * AUTHOR:
+ *  D.L. Karmann
+ *
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#define TELEM_FRAME_STATUS      1
+#define TELEM_SR_COUNT          12
+#define TELEM_ADC_COUNT         9
+#define TELEM_CHANNELS          4
+#define TELEM_PAYLOAD_SIZE      (8 + (TELEM_SR_COUNT * 3) + (TELEM_ADC_COUNT * 2) + (TELEM_CHANNELS * 2) + 2)
+
+// decoder statistics
+struct DecodeStats
+{
+    unsigned long frames;       // good frames
+    unsigned long bad;          // frames failing COBS, length or CRC checks
+    unsigned long missed;       // frames missing (sequence number gaps)
+};
+
+// Add bytes to a CRC-16 (CCITT)
+static uint16_t Crc16(uint16_t crc, const uint8_t * data, size_t len)
+{
+    while (len--)
+    {
+        crc ^= (uint16_t)*data++ << 8;
+        for (int b = 0; b < 8; ++b)
+        {
+            crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+// COBS decode a frame (without the delimiter), false = bad encoding
+static bool CobsDecode(const std::vector<uint8_t> & src, std::vector<uint8_t> & dst)
+{
+    size_t i = 0;
+    uint8_t code;
+
+    dst.clear();
+    while (i < src.size())
+    {
+        code = src[i++];
+        if ((code == 0) || ((i + code - 1) > src.size()))
+        {
+            return false;
+        }
+        for (uint8_t n = 1; n < code; ++n)
+        {
+            dst.push_back(src[i++]);
+        }
+        if ((code < 0xFF) && (i < src.size()))
+        {
+            dst.push_back(0x00);
+        }
+    }
+    return true;
+}
+
+// Get a little-endian value from a payload
+static uint32_t GetLE(const uint8_t * p, int bytes)
+{
+    uint32_t val = 0;
+
+    for (int b = bytes - 1; b >= 0; --b)
+    {
+        val = (val << 8) | p[b];
+    }
+    return val;
+}
+
+// Decode one frame and write its CSV line
+static void DecodeFrame(const std::vector<uint8_t> & raw, DecodeStats & stats, bool & have_seq, uint16_t & last_seq)
+{
+    std::vector<uint8_t> frame;
+    const uint8_t * p;
+    uint16_t seq;
+    double counts;
+
+    if (!CobsDecode(raw, frame) || (frame.size() != TELEM_PAYLOAD_SIZE) ||
+        (frame[0] != TELEM_FRAME_STATUS) ||
+        (Crc16(0xFFFF, frame.data(), frame.size() - 2) != GetLE(&frame[frame.size() - 2], 2)))
+    {
+        ++stats.bad;
+        fprintf(stderr, "bad frame (%u bytes)\n", (unsigned)raw.size());
+        return;
+    }
+
+    p = frame.data() + 1;
+    seq = GetLE(p, 2);
+    if (have_seq && (seq != (uint16_t)(last_seq + 1)))
+    {
+        stats.missed += (uint16_t)(seq - last_seq - 1);
+        fprintf(stderr, "frames %u to %u missing\n", (unsigned)(uint16_t)(last_seq + 1), (unsigned)(uint16_t)(seq - 1));
+    }
+    have_seq = true;
+    last_seq = seq;
+    ++stats.frames;
+
+    printf("%u,%lu,0x%02X", (unsigned)seq, (unsigned long)GetLE(p + 2, 4), p[6]);
+    p += 7;
+    for (int i = 0; i < TELEM_SR_COUNT; ++i, p += 3)
+    {
+        printf(",0x%06lX", (unsigned long)GetLE(p, 3));
+    }
+    for (int i = 0; i < TELEM_ADC_COUNT; ++i, p += 2)
+    {
+        counts = GetLE(p, 2) / 16.0;
+        if (i < 6)
+        {
+            printf(",%.1f", 350.0 - (0.488 * counts));      // thermal clusters
+        }
+        else
+        {
+            printf(",%.2f", 22.0 * counts / 1024);          // VSREG, VS, VWU
+        }
+    }
+    for (int i = 0; i < TELEM_CHANNELS; ++i, p += 2)
+    {
+        printf(",%lu", (unsigned long)GetLE(p, 2));
+    }
+    printf("\n");
+}
+
+int main(int argc, char * argv[])
+{
+    FILE * in = stdin;
+    std::vector<uint8_t> raw;
+    DecodeStats stats = { 0, 0, 0 };
+    bool have_seq = false;
+    uint16_t last_seq = 0;
+    int c;
+
+    if (argc > 2)
+    {
+        fprintf(stderr, "usage: %s [capture file or serial device]\n", argv[0]);
+        return 1;
+    }
+    if (argc > 1)
+    {
+        in = fopen(argv[1], "rb");
+        if (in == NULL)
+        {
+            perror(argv[1]);
+            return 1;
+        }
+    }
+
+    printf("seq,ms,gsb");
+    for (int i = 1; i <= TELEM_SR_COUNT; ++i)
+    {
+        printf(",sr%d", i);
+    }
+    printf(",tcl1,tcl2,tcl3,tcl4,tcl5,tcl6,vsreg,vs,vwu");
+    for (int i = 0; i < TELEM_CHANNELS; ++i)
+    {
+        printf(",ch%d", i);
+    }
+    printf("\n");
+
+    while ((c = fgetc(in)) != EOF)
+    {
+        if (c != 0x00)
+        {
+            if (raw.size() < 1024)
+            {
+                raw.push_back((uint8_t)c);
+            }
+            continue;
+        }
+        if (!raw.empty())
+        {
+            DecodeFrame(raw, stats, have_seq, last_seq);
+            fflush(stdout);
+            raw.clear();
+        }
+    }
+
+    fprintf(stderr, "%lu frames, %lu bad, %lu missing\n", stats.frames, stats.bad, stats.missed);
+    if (in != stdin)
+    {
+        fclose(in);
+    }
+    return 0;
+}
@@ -0,0 +1,274 @@
+/** \file DLK_CurrentCapture.cpp */
+/*
+ * NAME: DLK_CurrentCapture.cpp
+ *
+ * WHAT:
+ *  Arduino L99DZ200G current waveform capture functions.
+ *
+ * SPECIAL CONSIDERATIONS:
+ *  None.
+ *
+ * AUTHOR:
+ *  D.L. Karmann
+ *
+ * MODIFIED:
+ *
+ */
+
+#include "DLK_CurrentCapture.h"
+
+// the OUTn current monitor selections (bit n = OUT_n_CM value n)
+#define CAPTURE_CM_OUTPUTS  ((1U << OUT_1_CM) | (1U << OUT_2_CM) | (1U << OUT_3_CM) | \
+                             (1U << OUT_6_CM) | (1U << OUT_7_CM) | (1U << OUT_8_CM) | \
+                             (1U << OUT_9_CM) | (1U << OUT_10_CM) | (1U << OUT_13_CM) | \
+                             (1U << OUT_14_CM) | (1U << OUT_15_CM))
+
+// DLK_CurrentCapture Class members
+
+// Constructor
+DLK_CurrentCapture::DLK_CurrentCapture(DLK_L99DZ200G & l99dz200g)
+{
+    L99 = &l99dz200g;
+    Head = 0;
+    Filled = 0;
+    PostLeft = 0;
+    Pre = 0;
+    PreCnt = 0;
+    Prev = 0;
+    Threshold = 0;
+    Period = CAPTURE_MIN_PERIOD_US;
+    NextTime = 0;
+    Late = 0;
+    Pin = 0;
+    OutCM = CAPTURE_NO_CM;
+    TrigType = CAPTURE_TRIG_RISE;
+    State = CAPTURE_IDLE;
+    ForceTrig = false;
+}
+
+// Arm a capture
+uint8_t DLK_CurrentCapture::Capture_Arm(uint8_t pin, uint8_t out_cm, uint16_t period_us, uint16_t pre,
+                                        uint8_t trigger, uint16_t threshold)
+{
+    if ((period_us < CAPTURE_MIN_PERIOD_US) || (pre >= CAPTURE_SIZE) || (trigger > CAPTURE_TRIG_START))
+    {
+        return L99DZ200G_FAIL;
+    }
+    if ((out_cm != CAPTURE_NO_CM) && ((out_cm > OUT_15_CM) || !(CAPTURE_CM_OUTPUTS & (1U << out_cm))))
+    {
+        return L99DZ200G_FAIL;      // not an OUTn current monitor selection
+    }
+
+    Capture_Stop();
+
+    Pin = pin;
+    OutCM = out_cm;
+    Period = period_us;
+    Pre = pre;
+    TrigType = trigger;
+    Threshold = threshold;
+    Head = 0;
+    Filled = 0;
+    PreCnt = 0;
+    Late = 0;
+    ForceTrig = false;
+
+    if (OutCM != CAPTURE_NO_CM)
+    {
+        // enable CM output on L99DZ200G CM_DIR pin
+        L99->L99DZ200G_CM_DIR_Config(CM_ALWAYS);
+        pinMode(Pin, INPUT);
+        L99->L99DZ200G_CM_OUTn_Select(OutCM);
+    }
+
+    State = CAPTURE_ARMED;
+    NextTime = micros();        // first sample now
+    return L99DZ200G_OK;
+}
+
+// Stop a capture being taken
+void DLK_CurrentCapture::Capture_Stop(void)
+{
+    if ((State == CAPTURE_ARMED) || (State == CAPTURE_TRIGGERED))
+    {
+        Capture_Release();
+        State = CAPTURE_IDLE;
+    }
+}
+
+// Force the trigger
+void DLK_CurrentCapture::Capture_Trigger(void)
+{
+    if (State == CAPTURE_ARMED)
+    {
+        ForceTrig = true;
+    }
+}
+
+// Report a motor start
+void DLK_CurrentCapture::Capture_MotorStart(void)
+{
+    if (TrigType == CAPTURE_TRIG_START)
+    {
+        Capture_Trigger();
+    }
+}
+
+// Run a capture step
+void DLK_CurrentCapture::Capture_Tick(void)
+{
+    uint32_t now;
+
+    if ((State != CAPTURE_ARMED) && (State != CAPTURE_TRIGGERED))
+    {
+        return;
+    }
+
+    now = micros();
+    if ((int32_t)(now - NextTime) < 0)
+    {
+        return;     // not due yet
+    }
+    if ((now - NextTime) >= Period)
+    {
+        NextTime = now;     // fell behind, restart the pacing from this sample
+        if (Late < 0xFFFF)
+        {
+            ++Late;
+        }
+    }
+    NextTime += Period;
+
+    Capture_Take();
+}
+
+// Get the capture state
+uint8_t DLK_CurrentCapture::Capture_State(void)
+{
+    return State;
+}
+
+// Check if the capture being taken owns the CM/DIR pin
+bool DLK_CurrentCapture::Capture_OwnsCM(void)
+{
+    return ((State == CAPTURE_ARMED) || (State == CAPTURE_TRIGGERED)) && (OutCM != CAPTURE_NO_CM);
+}
+
+// Get a sample of the capture held (oldest first)
+uint16_t DLK_CurrentCapture::Capture_Sample(uint16_t n)
+{
+    if ((State != CAPTURE_DONE) || (n >= CAPTURE_SIZE))
+    {
+        return 0;
+    }
+    return Samples[(Head + n) & (CAPTURE_SIZE - 1)];
+}
+
+// Get the number of samples before the trigger sample
+uint16_t DLK_CurrentCapture::Capture_PreCount(void)
+{
+    return PreCnt;
+}
+
+// Get the number of samples taken late
+uint16_t DLK_CurrentCapture::Capture_Late(void)
+{
+    return Late;
+}
+
+// Write the capture held as text
+void DLK_CurrentCapture::Capture_Dump(Print & out)
+{
+    int32_t time_us;
+
+    if (State != CAPTURE_DONE)
+    {
+        out.println(F("# no capture"));
+        return;
+    }
+
+    out.print(F("# pin "));
+    out.print(Pin);
+    out.print(F(", period "));
+    out.print(Period);
+    out.print(F(" uS, "));
+    out.print(PreCnt);
+    out.print(F(" pre-trigger, "));
+    out.print(CAPTURE_SIZE);
+    out.print(F(" samples, "));
+    out.print(Late);
+    out.println(F(" late"));
+
+    for (uint16_t n = 0; n < CAPTURE_SIZE; ++n)
+    {
+        L99->L99DZ200G_CheckWdogExpired();      // process watchdog (a long dump)
+
+        time_us = ((int32_t)n - PreCnt) * (int32_t)Period;
+        out.print(time_us);
+        out.print(',');
+        out.println(Capture_Sample(n));
+    }
+}
+
+// Take a sample - trigger when armed, done when the post-trigger samples are taken
+void DLK_CurrentCapture::Capture_Take(void)
+{
+    uint16_t sample = analogRead(Pin);
+    bool trig = false;
+
+    if (State == CAPTURE_ARMED)
+    {
+        if (ForceTrig)
+        {
+            trig = true;
+        }
+        else if ((Filled > 0) && (Filled >= Pre))
+        {
+            // level crossing (only with the pre-trigger samples taken)
+            if (TrigType == CAPTURE_TRIG_RISE)
+            {
+                trig = (Prev < Threshold) && (sample >= Threshold);
+            }
+            else if (TrigType == CAPTURE_TRIG_FALL)
+            {
+                trig = (Prev > Threshold) && (sample <= Threshold);
+            }
+        }
+    }
+
+    Samples[Head] = sample;
+    Head = (Head + 1) & (CAPTURE_SIZE - 1);
+    Prev = sample;
+
+    if (trig)
+    {
+        PreCnt = (Filled < Pre) ? Filled : Pre;
+        PostLeft = CAPTURE_SIZE - PreCnt - 1;
+        State = CAPTURE_TRIGGERED;
+    }
+    else if (State == CAPTURE_TRIGGERED)
+    {
+        --PostLeft;
+    }
+    if (Filled < CAPTURE_SIZE)
+    {
+        ++Filled;
+    }
+
+    if ((State == CAPTURE_TRIGGERED) && (PostLeft == 0))
+    {
+        Capture_Release();
+        State = CAPTURE_DONE;
+    }
+}
+
+// Restore the CM/DIR pin to DIR input if it was used
+void DLK_CurrentCapture::Capture_Release(void)
+{
+    if (OutCM != CAPTURE_NO_CM)
+    {
+        // re-enable DIR input on L99DZ200G CM_DIR pin
+        L99->L99DZ200G_CM_DIR_Config(DIR_ALWAYS);
+        pinMode(Pin, OUTPUT);
+    }
+}
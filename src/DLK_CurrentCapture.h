@@ -0,0 +1,234 @@
+/** \file DLK_CurrentCapture.h */
+/*
+ * NAME: DLK_CurrentCapture.h
+ *
+ * WHAT:
+ *  Header file for DLK_CurrentCapture Arduino L99DZ200G current waveform capture class.
+ *
+ *  Works like a single shot oscilloscope on one current channel: once armed, the channel is
+ *  sampled (one analogRead() per sample) every period into a RAM ring buffer of
+ *  CAPTURE_SIZE samples. The capture triggers on:
+ *   - CAPTURE_TRIG_RISE: a sample rising to the threshold or above
+ *   - CAPTURE_TRIG_FALL: a sample falling to the threshold or below
+ *   - CAPTURE_TRIG_START: Capture_MotorStart() (called by the application as it starts a
+ *     motor)
+ *  or Capture_Trigger() (forced, any trigger type). The buffer then keeps the pre-trigger
+ *  samples before the trigger sample and fills the rest with post-trigger samples, and the
+ *  capture is done (Capture_Dump() writes it as text).
+ *
+ *  The channel is an analog pin, either a current sense output (e.g. TK200G1 CSENSA/CSENSB)
+ *  or the L99DZ200G CM/DIR pin: with an OUTn current monitor selection the CM/DIR pin is
+ *  switched to CM output while the capture runs, and back to DIR input when it is done or
+ *  stopped. Other users of the CM/DIR pin must check Capture_OwnsCM() first (and leave
+ *  the pin and the CR7 CM selection alone, or Capture_Stop() the capture).
+ *
+ * SPECIAL CONSIDERATIONS:
+ *  Sampling is paced by Capture_Tick() (call often from loop()) from micros(), one sample
+ *  per tick, so the period must be longer than the slowest loop() pass for an even time
+ *  base (hence CAPTURE_MIN_PERIOD_US). Samples are not taken from a timer interrupt: the
+ *  analogRead() would collide with the ones loop() takes, and the CM/DIR pin restore at the
+ *  end of a capture is an SPI write. A sample taken a period or more late restarts the
+ *  pacing from that sample and is counted (Capture_Late()); the dump times are the nominal
+ *  ones.
+ *  While the CM/DIR pin is the CM output the DIR input can not be driven.
+ *  Capture_Dump() blocks until written (processing the L99DZ200G watchdog as it goes).
+ *
+ * AUTHOR:
+ *  D.L. Karmann
+ *
+ */
+#ifndef __DLK_CURRENTCAPTURE_H__
+#define __DLK_CURRENTCAPTURE_H__
+
+#include "Arduino.h"
+#include "DLK_L99DZ200G.h"
+
+#ifndef CAPTURE_SIZE
+#ifdef __AVR__
+#define CAPTURE_SIZE            128     // samples kept (power of 2)
+#else
+#define CAPTURE_SIZE            1024    // samples kept (power of 2)
+#endif
+#endif
+#define CAPTURE_MIN_PERIOD_US   1000    // shortest sample period (uS), a loop() pass the demos hold
+#define CAPTURE_NO_CM           0xFF    // channel is not the CM/DIR pin current monitor
+
+// trigger types
+#define CAPTURE_TRIG_RISE       0       // sample rising to the threshold or above
+#define CAPTURE_TRIG_FALL       1       // sample falling to the threshold or below
+#define CAPTURE_TRIG_START      2       // Capture_MotorStart()
+
+// capture states
+#define CAPTURE_IDLE            0       // not armed (no capture held)
+#define CAPTURE_ARMED           1       // pre-trigger sampling, waiting for the trigger
+#define CAPTURE_TRIGGERED       2       // post-trigger sampling
+#define CAPTURE_DONE            3       // capture held
+
+/**
+ * DLK_CurrentCapture Arduino L99DZ200G current waveform capture class.
+ */
+class DLK_CurrentCapture
+{
+    public:
+        // Constructor
+        /**
+         *  A constructor that sets up the (idle) current capture.
+         *
+         *  \param l99dz200g: the L99DZ200G with the CM/DIR pin current monitor
+         *
+         *  \return None.
+         */
+        DLK_CurrentCapture(DLK_L99DZ200G & l99dz200g);
+
+        /**
+         * Arm a capture (the capture held is discarded).
+         *
+         * \param pin: the analog input pin sampled
+         * \param out_cm: the OUTn current monitor on the CM/DIR pin: (OUT_1_CM, OUT_2_CM, OUT_3_CM,
+         *                OUT_6_CM, OUT_7_CM, OUT_8_CM, OUT_9_CM, OUT_10_CM, OUT_13_CM, OUT_14_CM,
+         *                OUT_15_CM), CAPTURE_NO_CM = pin is not the CM/DIR pin
+         * \param period_us: the sample period (CAPTURE_MIN_PERIOD_US to 65535 uS)
+         * \param pre: the samples kept before the trigger sample (0 to CAPTURE_SIZE - 1)
+         * \param trigger: the trigger type: (CAPTURE_TRIG_RISE, CAPTURE_TRIG_FALL, CAPTURE_TRIG_START)
+         * \param threshold: the trigger threshold (ADC counts, CAPTURE_TRIG_RISE/FALL)
+         *
+         * \return   L99DZ200G_OK = capture armed
+         * \return   L99DZ200G_FAIL = invalid parameter
+         */
+        uint8_t Capture_Arm(uint8_t pin, uint8_t out_cm, uint16_t period_us, uint16_t pre,
+                            uint8_t trigger, uint16_t threshold);
+
+        /**
+         * Stop a capture being taken (the CM/DIR pin is restored to DIR input).
+         *
+         *  \return None.
+         */
+        void Capture_Stop(void);
+
+        /**
+         * Force the trigger (at the next sample, any trigger type).
+         *
+         *  \return None.
+         */
+        void Capture_Trigger(void);
+
+        /**
+         * Report a motor start (triggers a CAPTURE_TRIG_START capture at the next sample).
+         *
+         *  \return None.
+         */
+        void Capture_MotorStart(void);
+
+        /**
+         * Run a capture step (call often from loop()). Takes a sample when due.
+         *
+         *  \return None.
+         */
+        void Capture_Tick(void);
+
+        /**
+         * Get the capture state.
+         *
+         * \return   uint8_t = (CAPTURE_IDLE, CAPTURE_ARMED, CAPTURE_TRIGGERED, CAPTURE_DONE)
+         */
+        uint8_t Capture_State(void);
+
+        /**
+         * Check if the capture being taken owns the CM/DIR pin (as the OUTn current monitor).
+         *
+         * \return   true = armed or triggered with an OUTn current monitor selected
+         * \return   false = the CM/DIR pin and the CM selection are free to use
+         */
+        bool Capture_OwnsCM(void);
+
+        /**
+         * Get a sample of the capture held.
+         *
+         * \param n: the sample (0 = oldest to CAPTURE_SIZE - 1), Capture_PreCount() = trigger sample
+         *
+         * \return   uint16_t = the sample (ADC counts), 0 = no capture held or invalid sample
+         */
+        uint16_t Capture_Sample(uint16_t n);
+
+        /**
+         * Get the number of samples before the trigger sample in the capture held (fewer than
+         * asked for if the trigger was forced early).
+         *
+         * \return   uint16_t = the samples before the trigger sample
+         */
+        uint16_t Capture_PreCount(void);
+
+        /**
+         * Get the number of samples taken a period or more late since Capture_Arm().
+         *
+         * \return   uint16_t = the late samples (saturates at 65535)
+         */
+        uint16_t Capture_Late(void);
+
+        /**
+         * Write the capture held as text: a "#" header line, then one "<uS>,<ADC counts>"
+         * line per sample (time from the trigger sample).
+         *
+         * \param out: where to write the capture (e.g. Serial)
+         *
+         *  \return None.
+         */
+        void Capture_Dump(Print & out);
+
+    private:
+        /// L99DZ200G with the CM/DIR pin current monitor
+        DLK_L99DZ200G * L99;
+
+        /// the samples
+        uint16_t Samples[CAPTURE_SIZE];
+
+        /// next sample index
+        uint16_t Head;
+
+        /// samples taken since armed (saturates at CAPTURE_SIZE)
+        uint16_t Filled;
+
+        /// post-trigger samples still to take
+        uint16_t PostLeft;
+
+        /// samples kept before the trigger sample (asked for, and in the capture held)
+        uint16_t Pre;
+        uint16_t PreCnt;
+
+        /// the sample before the latest one
+        uint16_t Prev;
+
+        /// trigger threshold (ADC counts)
+        uint16_t Threshold;
+
+        /// sample period (uS)
+        uint16_t Period;
+
+        /// time (uS) the next sample is due
+        uint32_t NextTime;
+
+        /// samples taken late
+        uint16_t Late;
+
+        /// analog input pin sampled
+        uint8_t Pin;
+
+        /// OUTn current monitor on the CM/DIR pin (or CAPTURE_NO_CM)
+        uint8_t OutCM;
+
+        /// trigger type
+        uint8_t TrigType;
+
+        /// capture state
+        uint8_t State;
+
+        /// true = trigger at the next sample
+        bool ForceTrig;
+
+        /// Take a sample
+        void Capture_Take(void);
+
+        /// Restore the CM/DIR pin to DIR input if it was used
+        void Capture_Release(void);
+};
+#endif  // __DLK_CURRENTCAPTURE_H__
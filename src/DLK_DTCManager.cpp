@@ -0,0 +1,337 @@
+/** \file DLK_DTCManager.cpp */
+/*
+ * NAME: DLK_DTCManager.cpp
+ *
+ * WHAT:
+ *  Arduino L99DZ200G diagnostic trouble code manager functions.
+ *
+ * SPECIAL CONSIDERATIONS:
+ *  EEPROM image: magic (2), DTC count (1), operating minutes (4),
+ *                per DTC: status (1), first minute (2), last minute (2),
+ *                checksum (1)
+ *
+ * AUTHOR:
+ *  D.L. Karmann
+ *
+ * MODIFIED:
+ *
+ */
+
+#include "DLK_DTCManager.h"
+#ifdef DTC_HAS_EEPROM
+#include <EEPROM.h>
+#endif
+
+#define DTC_EEPROM_MAGIC        0x4454  // "DT"
+#define DTC_SR_COUNT            6       // SR1 to SR6
+
+// DLK_DTCManager Class members
+
+// Constructor
+DLK_DTCManager::DLK_DTCManager(DLK_L99DZ200G & l99dz200g)
+{
+    L99 = &l99dz200g;
+    Defs = NULL;
+    Count = 0;
+    memset(Records, 0, sizeof(Records));
+    RegsUsed = 0;
+    EepromAddr = DTC_NO_EEPROM;
+    Dirty = false;
+    OpMinutes = 0;
+    SavedMinutes = 0;
+    MinuteStart = 0;
+    LastSave = 0;
+    LastStep = 0;
+}
+
+// Set the DTC table and load the stored DTCs from EEPROM
+uint8_t DLK_DTCManager::DTC_Begin(const DTCDef * defs, uint8_t count, int16_t eeprom_addr)
+{
+    uint8_t reg;
+    uint8_t ret;
+
+    Count = 0;
+    RegsUsed = 0;
+    if (count > DTC_MAX)
+    {
+        return L99DZ200G_FAIL;
+    }
+
+    Defs = defs;
+    Count = count;
+    for (uint8_t i = 0; i < Count; ++i)
+    {
+        reg = pgm_read_byte(&Defs[i].reg);
+        if ((reg >= L99DZ200G_SR1) && (reg < (L99DZ200G_SR1 + DTC_SR_COUNT)))
+        {
+            RegsUsed |= 1 << (reg - L99DZ200G_SR1);
+        }
+    }
+
+    memset(Records, 0, sizeof(Records));
+    OpMinutes = 0;
+    Dirty = false;
+    EepromAddr = eeprom_addr;
+    MinuteStart = millis();
+    LastSave = MinuteStart;
+    LastStep = MinuteStart;
+
+    if (EepromAddr == DTC_NO_EEPROM)
+    {
+        SavedMinutes = OpMinutes;
+        return L99DZ200G_OK;
+    }
+    ret = DTC_Load();
+    SavedMinutes = OpMinutes;
+    return ret;
+}
+
+// Run a debounce step
+void DLK_DTCManager::DTC_Tick(void)
+{
+    if (!TIMER_EXPIRED(LastStep, DTC_STEP_MS))
+    {
+        return;
+    }
+    LastStep = millis();
+
+    while ((LastStep - MinuteStart) >= 60000UL)
+    {
+        MinuteStart += 60000UL;
+        ++OpMinutes;
+    }
+
+    // If watchdog is not running, assumes L99DZ200G is in a standby mode
+    // and should not be disturbed by SPI communications! (minutes are still counted)
+    if ((Count != 0) && L99->L99DZ200G_WatchdogRunning())
+    {
+        DTC_Sample();
+    }
+
+    if ((Dirty || ((EepromAddr != DTC_NO_EEPROM) && ((OpMinutes - SavedMinutes) >= DTC_SAVE_MINUTES))) &&
+        TIMER_EXPIRED(LastSave, DTC_SAVE_MS))
+    {
+        DTC_Save();
+    }
+}
+
+// Check if a DTC is active
+bool DLK_DTCManager::DTC_Active(uint8_t dtc)
+{
+    return (dtc < Count) && (Records[dtc].status & DTC_ACTIVE_MASK);
+}
+
+// Get the number of active DTCs
+uint8_t DLK_DTCManager::DTC_ActiveCount(void)
+{
+    uint8_t cnt = 0;
+
+    for (uint8_t i = 0; i < Count; ++i)
+    {
+        if (Records[i].status & DTC_ACTIVE_MASK)
+        {
+            ++cnt;
+        }
+    }
+    return cnt;
+}
+
+// Get a DTC record
+const DTCRecord * DLK_DTCManager::DTC_Record(uint8_t dtc)
+{
+    return (dtc < Count) ? &Records[dtc] : NULL;
+}
+
+// Get the number of DTCs in the table
+uint8_t DLK_DTCManager::DTC_Count(void)
+{
+    return Count;
+}
+
+// Get the operating minutes
+uint32_t DLK_DTCManager::DTC_OperatingMinutes(void)
+{
+    return OpMinutes;
+}
+
+// Clear the stored state of all DTCs and save it
+void DLK_DTCManager::DTC_ClearAll(void)
+{
+    for (uint8_t i = 0; i < Count; ++i)
+    {
+        Records[i].status &= DTC_ACTIVE_MASK;
+        Records[i].first_min = 0;
+        Records[i].last_min = 0;
+    }
+    Dirty = true;
+    DTC_Save();
+}
+
+// Save the stored DTCs and operating minutes to EEPROM
+uint8_t DLK_DTCManager::DTC_Save(void)
+{
+#ifdef DTC_HAS_EEPROM
+    uint8_t image[DTC_EEPROM_SIZE(DTC_MAX)];
+    uint8_t len = 0;
+    uint8_t sum = 0;
+
+    if (EepromAddr == DTC_NO_EEPROM)
+    {
+        return L99DZ200G_FAIL;
+    }
+
+    image[len++] = DTC_EEPROM_MAGIC >> 8;
+    image[len++] = DTC_EEPROM_MAGIC & 0xFF;
+    image[len++] = Count;
+    for (uint8_t b = 0; b < 4; ++b)
+    {
+        image[len++] = OpMinutes >> (8 * b);
+    }
+    for (uint8_t i = 0; i < Count; ++i)
+    {
+        image[len++] = Records[i].status & ~DTC_ACTIVE_MASK;
+        image[len++] = Records[i].first_min & 0xFF;
+        image[len++] = Records[i].first_min >> 8;
+        image[len++] = Records[i].last_min & 0xFF;
+        image[len++] = Records[i].last_min >> 8;
+    }
+    for (uint8_t i = 0; i < len; ++i)
+    {
+        sum += image[i];
+    }
+    image[len++] = ~sum;
+
+    for (uint8_t i = 0; i < len; ++i)
+    {
+        EEPROM.update(EepromAddr + i, image[i]);    // only changed bytes are written
+    }
+
+    Dirty = false;
+    SavedMinutes = OpMinutes;
+    LastSave = millis();
+    return L99DZ200G_OK;
+#else
+    return L99DZ200G_FAIL;
+#endif
+}
+
+// Sample the status registers used and debounce the DTCs
+void DLK_DTCManager::DTC_Sample(void)
+{
+    uint32_t sr[DTC_SR_COUNT];
+    uint32_t clr[DTC_SR_COUNT];
+    DTCDef def;
+    DTCRecord * rec;
+    uint8_t idx;
+    uint8_t occ;
+
+    L99->L99DZ200G_BeginSession();
+
+    // each status register used read once
+    for (idx = 0; idx < DTC_SR_COUNT; ++idx)
+    {
+        clr[idx] = 0;
+        sr[idx] = 0;
+        if (RegsUsed & (1 << idx))
+        {
+            sr[idx] = L99->L99DZ200G_ReadRegister(L99DZ200G_SR1 + idx) & FULL_REG_MASK;
+        }
+    }
+
+    for (uint8_t i = 0; i < Count; ++i)
+    {
+        memcpy_P(&def, &Defs[i], sizeof(def));
+        if ((def.reg < L99DZ200G_SR1) || (def.reg >= (L99DZ200G_SR1 + DTC_SR_COUNT)))
+        {
+            continue;
+        }
+        idx = def.reg - L99DZ200G_SR1;
+        rec = &Records[i];
+
+        if (sr[idx] & def.mask)
+        {
+            if (def.flags & DTC_CLEAR)
+            {
+                clr[idx] |= sr[idx] & def.mask;
+            }
+            rec->counter = (rec->counter < 0) ? 1 : ((rec->counter < 127) ? rec->counter + 1 : 127);
+            if (!(rec->status & DTC_ACTIVE_MASK) && (rec->counter >= (int8_t)def.fail_cnt))
+            {
+                // became active
+                occ = (rec->status & DTC_OCC_MASK) >> DTC_OCC_POS;
+                if (occ < DTC_OCC_MAX)
+                {
+                    ++occ;
+                }
+                if (!(rec->status & DTC_STORED_MASK))
+                {
+                    rec->first_min = (uint16_t)OpMinutes;
+                }
+                rec->status = DTC_ACTIVE_MASK | DTC_STORED_MASK | (occ << DTC_OCC_POS);
+                rec->last_min = (uint16_t)OpMinutes;
+                Dirty = true;
+            }
+        }
+        else
+        {
+            rec->counter = (rec->counter > 0) ? -1 : ((rec->counter > -127) ? rec->counter - 1 : -127);
+            if ((rec->status & DTC_ACTIVE_MASK) && (-rec->counter >= (int8_t)def.pass_cnt))
+            {
+                rec->status &= ~DTC_ACTIVE_MASK;
+            }
+        }
+    }
+
+    // clear the sampled bits so a fault still present sets them again
+    for (idx = 0; idx < DTC_SR_COUNT; ++idx)
+    {
+        if (clr[idx] != 0)
+        {
+            L99->L99DZ200G_ReadClearRegister(L99DZ200G_SR1 + idx, clr[idx]);
+        }
+    }
+
+    L99->L99DZ200G_EndSession();
+}
+
+// Load the stored DTCs and operating minutes from EEPROM
+uint8_t DLK_DTCManager::DTC_Load(void)
+{
+#ifdef DTC_HAS_EEPROM
+    uint8_t image[DTC_EEPROM_SIZE(DTC_MAX)];
+    uint8_t len = DTC_EEPROM_SIZE(Count);
+    uint8_t sum = 0;
+    uint8_t pos;
+
+    for (uint8_t i = 0; i < len; ++i)
+    {
+        image[i] = EEPROM.read(EepromAddr + i);
+    }
+    for (uint8_t i = 0; i < (len - 1); ++i)
+    {
+        sum += image[i];
+    }
+    if ((image[0] != (DTC_EEPROM_MAGIC >> 8)) || (image[1] != (DTC_EEPROM_MAGIC & 0xFF)) ||
+        (image[2] != Count) || (image[len - 1] != (uint8_t)~sum))
+    {
+        return L99DZ200G_FAIL;      // nothing valid stored for this DTC table
+    }
+
+    OpMinutes = 0;
+    for (uint8_t b = 0; b < 4; ++b)
+    {
+        OpMinutes |= (uint32_t)image[3 + b] << (8 * b);
+    }
+    pos = 7;
+    for (uint8_t i = 0; i < Count; ++i)
+    {
+        Records[i].status = image[pos] & ~DTC_ACTIVE_MASK;
+        Records[i].first_min = image[pos + 1] | ((uint16_t)image[pos + 2] << 8);
+        Records[i].last_min = image[pos + 3] | ((uint16_t)image[pos + 4] << 8);
+        pos += 5;
+    }
+    return L99DZ200G_OK;
+#else
+    return L99DZ200G_OK;
+#endif
+}
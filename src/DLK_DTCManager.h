@@ -0,0 +1,224 @@
+/** \file DLK_DTCManager.h */
+/*
+ * NAME: DLK_DTCManager.h
+ *
+ * WHAT:
+ *  Header file for DLK_DTCManager Arduino L99DZ200G diagnostic trouble code manager class.
+ *
+ *  Each diagnostic trouble code (DTC) is one or more fault bits of a status register (SR1 to
+ *  SR6), given by a PROGMEM DTCDef table. Every DTC_STEP_MS the status registers used are
+ *  read once and each DTC is debounced:
+ *   - a sample with the fault bit(s) set counts the debounce counter up (from 0 if it was
+ *     counting down); fail_cnt samples in a row make the DTC active
+ *   - a sample with the fault bit(s) clear counts it down (from 0 if it was counting up);
+ *     pass_cnt samples in a row make the DTC inactive
+ *  so a single transient flag never sets or heals a DTC. When a DTC becomes active its
+ *  occurrence count is incremented and its first/last active times are recorded (in
+ *  operating minutes).
+ *
+ *  The DTC table is 6 bytes of RAM per DTC (DTCRecord). The stored state (stored flag,
+ *  occurrences, first/last times) and the operating minutes can be kept in EEPROM
+ *  (AVR and Teensy): they are loaded by DTC_Begin() and saved at most every DTC_SAVE_MS
+ *  after a DTC occurrence, every DTC_SAVE_MINUTES operating minutes, or by DTC_Save().
+ *  (A save per minute would wear out the EEPROM cells of the minutes and the checksum in
+ *  months; hourly is over ten years at 100k cycles. Up to an hour of operating minutes is
+ *  lost at power off unless the application calls DTC_Save().)
+ *
+ * SPECIAL CONSIDERATIONS:
+ *  Fault bits with DTC_CLEAR are cleared after each sample so a fault still present sets
+ *  them again for the next one; bits without it (latched shutdowns cleared by the
+ *  application) are left as read.
+ *  Times are operating minutes modulo 65536 (about 45 days).
+ *
+ * AUTHOR:
+ *  D.L. Karmann
+ *
+ */
+#ifndef __DLK_DTCMANAGER_H__
+#define __DLK_DTCMANAGER_H__
+
+#include "Arduino.h"
+#include "DLK_L99DZ200G.h"
+
+#if defined(__AVR__) || defined(TEENSYDUINO)
+#define DTC_HAS_EEPROM                  // EEPROM persistence available
+#endif
+
+#define DTC_MAX                 16      // DTCs managed
+#define DTC_STEP_MS             50      // debounce sample interval (mS)
+#define DTC_SAVE_MS             60000UL // shortest time between EEPROM saves (mS)
+#define DTC_SAVE_MINUTES        60      // operating minutes saved at least this often (hourly)
+#define DTC_NO_EEPROM           -1      // no EEPROM persistence
+#define DTC_EEPROM_SIZE(count)  (8 + ((count) * 5))     // EEPROM bytes used for count DTCs
+
+// DTC definition flags
+#define DTC_CLEAR               0x01    // clear the fault bit(s) after each sample
+
+// DTC record status
+#define DTC_ACTIVE_MASK         0x01    // debounced fault present
+#define DTC_STORED_MASK         0x02    // has been active since the last DTC_ClearAll()
+#define DTC_OCC_MASK            0xFC    // times it became active (saturates at DTC_OCC_MAX)
+#define DTC_OCC_POS             2
+#define DTC_OCC_MAX             63
+
+/**
+ * DTC definition (placed in PROGMEM).
+ */
+typedef struct
+{
+    uint8_t reg;            ///< the status register: (L99DZ200G_SR1 to L99DZ200G_SR6)
+    uint32_t mask;          ///< the fault bit(s) (any set = fault sample)
+    uint8_t fail_cnt;       ///< fault samples in a row to become active: (1 to 127)
+    uint8_t pass_cnt;       ///< no fault samples in a row to become inactive: (1 to 127)
+    uint8_t flags;          ///< DTC_CLEAR or 0
+} DTCDef;
+
+/**
+ * DTC record (bit-packed RAM table entry).
+ */
+typedef struct
+{
+    int8_t counter;         ///< debounce counter (> 0 counting faults, < 0 counting passes)
+    uint8_t status;         ///< DTC_ACTIVE_MASK | DTC_STORED_MASK | occurrences
+    uint16_t first_min;     ///< operating minutes when first active
+    uint16_t last_min;      ///< operating minutes when last active
+} DTCRecord;
+
+/**
+ * DLK_DTCManager Arduino L99DZ200G diagnostic trouble code manager class.
+ */
+class DLK_DTCManager
+{
+    public:
+        // Constructor
+        /**
+         *  A constructor that sets up the DTC manager.
+         *
+         *  \param l99dz200g: the L99DZ200G to diagnose
+         *
+         *  \return None.
+         */
+        DLK_DTCManager(DLK_L99DZ200G & l99dz200g);
+
+        /**
+         * Set the DTC table and load the stored DTCs from EEPROM.
+         *
+         * \param defs: the PROGMEM DTC definitions
+         * \param count: the number of DTCs: (1 to DTC_MAX)
+         * \param eeprom_addr: the EEPROM address of the stored DTCs
+         *                     (DTC_EEPROM_SIZE(count) bytes), or DTC_NO_EEPROM
+         *
+         * \return   L99DZ200G_OK = the stored DTCs were loaded (or there is no EEPROM)
+         * \return   L99DZ200G_FAIL = too many DTCs or nothing valid stored (DTCs cleared)
+         */
+        uint8_t DTC_Begin(const DTCDef * defs, uint8_t count, int16_t eeprom_addr);
+
+        /**
+         * Run a debounce step (call often from loop()). Does nothing until the next
+         * DTC_STEP_MS step. While the L99DZ200G watchdog is not running (standby) only the
+         * operating minutes are counted (no SPI traffic).
+         *
+         *  \return None.
+         */
+        void DTC_Tick(void);
+
+        /**
+         * Check if a DTC is active.
+         *
+         * \param dtc: the DTC (index in the DTC table)
+         *
+         * \return   true = the debounced fault is present
+         * \return   false = no fault (or invalid DTC)
+         */
+        bool DTC_Active(uint8_t dtc);
+
+        /**
+         * Get the number of active DTCs.
+         *
+         * \return   uint8_t = the active DTCs
+         */
+        uint8_t DTC_ActiveCount(void);
+
+        /**
+         * Get a DTC record.
+         *
+         * \param dtc: the DTC (index in the DTC table)
+         *
+         * \return   const DTCRecord * = the record (NULL for an invalid DTC)
+         */
+        const DTCRecord * DTC_Record(uint8_t dtc);
+
+        /**
+         * Get the number of DTCs in the table.
+         *
+         * \return   uint8_t = the DTCs
+         */
+        uint8_t DTC_Count(void);
+
+        /**
+         * Get the operating minutes.
+         *
+         * \return   uint32_t = the operating minutes
+         */
+        uint32_t DTC_OperatingMinutes(void);
+
+        /**
+         * Clear the stored state of all DTCs (active DTCs stay active) and save it.
+         *
+         *  \return None.
+         */
+        void DTC_ClearAll(void);
+
+        /**
+         * Save the stored DTCs and operating minutes to EEPROM (only changed bytes are
+         * written).
+         *
+         * \return   L99DZ200G_OK = saved
+         * \return   L99DZ200G_FAIL = no EEPROM persistence
+         */
+        uint8_t DTC_Save(void);
+
+    private:
+        /// L99DZ200G to diagnose
+        DLK_L99DZ200G * L99;
+
+        /// the PROGMEM DTC definitions
+        const DTCDef * Defs;
+
+        /// number of DTCs
+        uint8_t Count;
+
+        /// DTC records
+        DTCRecord Records[DTC_MAX];
+
+        /// status registers used (bit n = SR1 + n)
+        uint8_t RegsUsed;
+
+        /// EEPROM address (DTC_NO_EEPROM = none)
+        int16_t EepromAddr;
+
+        /// true = stored state changed since the last save
+        bool Dirty;
+
+        /// operating minutes
+        uint32_t OpMinutes;
+
+        /// operating minutes at the last save (or load)
+        uint32_t SavedMinutes;
+
+        /// time (mS) the present operating minute started
+        uint32_t MinuteStart;
+
+        /// time (mS) of the last save
+        uint32_t LastSave;
+
+        /// time (mS) of the last step
+        uint32_t LastStep;
+
+        /// Sample the status registers used and debounce the DTCs
+        void DTC_Sample(void);
+
+        /// Load the stored DTCs and operating minutes from EEPROM
+        uint8_t DTC_Load(void);
+};
+#endif  // __DLK_DTCMANAGER_H__
@@ -0,0 +1,190 @@
+/** \file DLK_ECVController.cpp */
+/*
+ * NAME: DLK_ECVController.cpp
+ *
+ * WHAT:
+ *  Arduino L99DZ200G closed-loop electrochromic mirror dimming controller functions.
+ *
+ * SPECIAL CONSIDERATIONS:
+ *  None.
+ *
+ * AUTHOR:
+ *  D.L. Karmann
+ *
+ * MODIFIED:
+ *
+ */
+
+#include "DLK_ECVController.h"
+
+// DLK_ECVController Class members
+
+// Constructor
+DLK_ECVController::DLK_ECVController(DLK_L99DZ200G & l99dz200g)
+{
+    L99 = &l99dz200g;
+    VctrlMaxMv = 0;
+    TargetValue = 0;
+    State = ECVCTL_OFF;
+    StartTime = 0;
+    TransitionTime = 0;
+    LastStep = 0;
+}
+
+// Get (and cache) the ECV maximum voltage setting - CFR
+void DLK_ECVController::ECV_Begin(void)
+{
+    uint32_t reg_data;
+
+    if (L99->L99DZ200G_GetShadowRegister(L99DZ200G_CFR, &reg_data) != L99DZ200G_OK)
+    {
+        reg_data = L99->L99DZ200G_ReadRegister(L99DZ200G_CFR);
+    }
+    if (reg_data & CFR_ECV_HV_MASK)
+    {
+        VctrlMaxMv = (uint16_t)(ECV_1_5_VOLTS * 1000);
+    }
+    else
+    {
+        VctrlMaxMv = (uint16_t)(ECV_1_2_VOLTS * 1000);
+    }
+}
+
+// Set the target ECV drive voltage and start the transition to it
+void DLK_ECVController::ECV_SetTarget(uint16_t target_mv)
+{
+    uint32_t reg_data;
+    uint8_t value;
+
+    if (VctrlMaxMv == 0)
+    {
+        ECV_Begin();
+    }
+    if (target_mv > VctrlMaxMv)
+    {
+        target_mv = VctrlMaxMv;
+    }
+    TargetValue = ((uint32_t)target_mv * CR11_EC_VALUE_MASK) / VctrlMaxMv;
+
+    // present drive value (0 if the ECV output is off)
+    if (L99->L99DZ200G_GetShadowRegister(L99DZ200G_CR11, &reg_data) != L99DZ200G_OK)
+    {
+        reg_data = L99->L99DZ200G_ReadRegister(L99DZ200G_CR11);
+    }
+    value = (reg_data & CR11_EC_VALUE_MASK) >> CR11_EC_VALUE_POS;
+    if ((reg_data & CR11_EC_ON_MASK) == 0)
+    {
+        value = 0;
+    }
+
+    if (TargetValue < value)
+    {
+        // lighter: discharge fast down to the target
+        ECV_WriteControl(ENABLE, ENABLE, TargetValue);
+        State = ECVCTL_DISCHARGING;
+    }
+    else
+    {
+        ECV_WriteControl(ENABLE, DISABLE, TargetValue);
+        State = (TargetValue > value) ? ECVCTL_CHARGING : ECVCTL_SETTLED;
+    }
+
+    StartTime = millis();
+    LastStep = StartTime;
+    TransitionTime = 0;
+}
+
+// Turn the ECV output and fast discharge off
+void DLK_ECVController::ECV_Off(void)
+{
+    TargetValue = 0;
+    ECV_WriteControl(DISABLE, DISABLE, 0);
+    State = ECVCTL_OFF;
+}
+
+// Run a control step
+void DLK_ECVController::ECV_Tick(void)
+{
+    if ((State != ECVCTL_CHARGING) && (State != ECVCTL_DISCHARGING))
+    {
+        return;
+    }
+    if (!TIMER_EXPIRED(LastStep, ECVCTL_STEP_MS))
+    {
+        return;
+    }
+    LastStep = millis();
+    TransitionTime = LastStep - StartTime;
+
+    if (State == ECVCTL_CHARGING)
+    {
+        if (L99->L99DZ200G_GetElectrochromicVoltageStatus(ECV_VNR) == L99DZ200G_OK)
+        {
+            State = ECVCTL_SETTLED;     // target voltage reached
+            return;
+        }
+    }
+    else
+    {
+        if (L99->L99DZ200G_GetElectrochromicVoltageStatus(ECV_VHI) == L99DZ200G_OK)
+        {
+            // no longer above the target, stop discharging (no overshoot)
+            ECV_WriteControl(ENABLE, DISABLE, TargetValue);
+            State = ECVCTL_SETTLED;
+            return;
+        }
+    }
+
+    if (TransitionTime >= ECVCTL_SETTLE_MAX_MS)
+    {
+        if (State == ECVCTL_DISCHARGING)
+        {
+            ECV_WriteControl(ENABLE, DISABLE, TargetValue);
+        }
+        State = ECVCTL_TIMEOUT;
+    }
+}
+
+// Get the controller state
+uint8_t DLK_ECVController::ECV_State(void)
+{
+    return State;
+}
+
+// Get the target ECV drive voltage as set in the L99DZ200G
+uint16_t DLK_ECVController::ECV_Target(void)
+{
+    return ((uint32_t)TargetValue * VctrlMaxMv) / CR11_EC_VALUE_MASK;
+}
+
+// Get the time the last transition took (or has taken so far)
+uint32_t DLK_ECVController::ECV_TransitionTime(void)
+{
+    return TransitionTime;
+}
+
+// Write the ECV fields of CR11 (one write, other fields from the shadow image)
+void DLK_ECVController::ECV_WriteControl(uint8_t ec_on, uint8_t fast_discharge, uint8_t value)
+{
+    uint32_t reg_data;
+    uint32_t new_data;
+
+    L99->L99DZ200G_BeginSession();
+
+    if (L99->L99DZ200G_GetShadowRegister(L99DZ200G_CR11, &reg_data) != L99DZ200G_OK)
+    {
+        reg_data = L99->L99DZ200G_ReadRegister(L99DZ200G_CR11);
+    }
+
+    new_data = reg_data & FULL_REG_MASK & ~(CR11_EC_ON_MASK | CR11_ECV_LS_MASK | CR11_EC_VALUE_MASK);
+    new_data |= (uint32_t)ec_on << CR11_EC_ON_POS;
+    new_data |= (uint32_t)fast_discharge << CR11_ECV_LS_POS;
+    new_data |= ((uint32_t)value << CR11_EC_VALUE_POS) & CR11_EC_VALUE_MASK;
+
+    if (new_data != (reg_data & FULL_REG_MASK))
+    {
+        L99->L99DZ200G_WriteControlRegister(L99DZ200G_CR11, new_data);
+    }
+
+    L99->L99DZ200G_EndSession();
+}
@@ -0,0 +1,139 @@
+/** \file DLK_ECVController.h */
+/*
+ * NAME: DLK_ECVController.h
+ *
+ * WHAT:
+ *  Header file for DLK_ECVController Arduino L99DZ200G closed-loop electrochromic mirror
+ *  dimming controller class.
+ *
+ *  The controller tracks a target ECV drive voltage (the mirror dim level), using the
+ *  L99DZ200G SR6 ECV voltage status bits as feedback:
+ *   - darker (target above the present setting): the drive value is stepped to the target
+ *     and the controller waits for ECV_VNR (voltage not reached) to clear
+ *   - lighter (target below the present setting): the drive value is stepped to the target
+ *     with the ECV fast discharge switched on; as soon as ECV_VHI (voltage too high) clears
+ *     the fast discharge is switched off, so the mirror is not discharged below the target
+ *  Each control step makes one SR6 status read and at most one CR11 write (drive value,
+ *  fast discharge and ECV on bits together, based on the CR11 shadow image). The CFR ECV
+ *  maximum voltage setting is read once by ECV_Begin() and cached.
+ *
+ * SPECIAL CONSIDERATIONS:
+ *  Call ECV_Begin() again after changing the ECV maximum voltage (L99DZ200G_Set_ECV_MaxVoltage).
+ *  The ECV fast discharge may set the ECV open-load status (SR5) while it is on.
+ *
+ * AUTHOR:
+ *  D.L. Karmann
+ *
+ */
+#ifndef __DLK_ECVCONTROLLER_H__
+#define __DLK_ECVCONTROLLER_H__
+
+#include "Arduino.h"
+#include "DLK_L99DZ200G.h"
+
+#define ECVCTL_STEP_MS          10      // control step interval (mS)
+#define ECVCTL_SETTLE_MAX_MS    20000   // longest charge/discharge before giving up (mS)
+
+// ECV controller states
+#define ECVCTL_OFF              0       // ECV output off
+#define ECVCTL_SETTLED          1       // ECV voltage at the target
+#define ECVCTL_CHARGING         2       // ECV voltage rising to the target
+#define ECVCTL_DISCHARGING      3       // ECV voltage falling to the target (fast discharge on)
+#define ECVCTL_TIMEOUT          4       // target not reached within ECVCTL_SETTLE_MAX_MS
+
+/**
+ * DLK_ECVController Arduino L99DZ200G closed-loop electrochromic mirror dimming controller class.
+ */
+class DLK_ECVController
+{
+    public:
+        // Constructor
+        /**
+         *  A constructor that sets up the ECV dimming controller.
+         *
+         *  \param l99dz200g: the L99DZ200G driving the electrochromic mirror
+         *
+         *  \return None.
+         */
+        DLK_ECVController(DLK_L99DZ200G & l99dz200g);
+
+        /**
+         * Get (and cache) the ECV maximum voltage setting - CFR.
+         *
+         *  \return None.
+         */
+        void ECV_Begin(void);
+
+        /**
+         * Set the target ECV drive voltage and start the transition to it (turns the ECV
+         * output on).
+         *
+         * \param target_mv: the target voltage (mV): (0 to the ECV maximum voltage, clamped)
+         *
+         *  \return None.
+         */
+        void ECV_SetTarget(uint16_t target_mv);
+
+        /**
+         * Turn the ECV output and fast discharge off.
+         *
+         *  \return None.
+         */
+        void ECV_Off(void);
+
+        /**
+         * Run a control step (call often from loop()). Does nothing until the next
+         * ECVCTL_STEP_MS step, and makes no SPI transfers unless a transition is running.
+         *
+         *  \return None.
+         */
+        void ECV_Tick(void);
+
+        /**
+         * Get the controller state.
+         *
+         * \return   uint8_t = the state: (ECVCTL_OFF, ECVCTL_SETTLED, ECVCTL_CHARGING,
+         *                                 ECVCTL_DISCHARGING, ECVCTL_TIMEOUT)
+         */
+        uint8_t ECV_State(void);
+
+        /**
+         * Get the target ECV drive voltage as set in the L99DZ200G.
+         *
+         * \return   uint16_t = the target voltage (mV)
+         */
+        uint16_t ECV_Target(void);
+
+        /**
+         * Get the time the last transition took (or has taken so far).
+         *
+         * \return   uint32_t = the transition time (mS)
+         */
+        uint32_t ECV_TransitionTime(void);
+
+    private:
+        /// L99DZ200G driving the electrochromic mirror
+        DLK_L99DZ200G * L99;
+
+        /// cached ECV maximum voltage (mV)
+        uint16_t VctrlMaxMv;
+
+        /// CR11 drive value of the target (0 to CR11_EC_VALUE_MASK)
+        uint8_t TargetValue;
+
+        /// controller state (ECVCTL_...)
+        uint8_t State;
+
+        /// time (mS) the transition started
+        uint32_t StartTime;
+
+        /// time (mS) the transition took
+        uint32_t TransitionTime;
+
+        /// time (mS) of the last control step
+        uint32_t LastStep;
+
+        /// Write the ECV fields of CR11 (one write, other fields from the shadow image)
+        void ECV_WriteControl(uint8_t ec_on, uint8_t fast_discharge, uint8_t value);
+};
+#endif  // __DLK_ECVCONTROLLER_H__
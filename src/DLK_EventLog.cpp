@@ -0,0 +1,221 @@
+/** \file DLK_EventLog.cpp */
+/*
+ * NAME: DLK_EventLog.cpp
+ *
+ * WHAT:
+ *  Arduino L99DZ200G fault/event ring buffer functions.
+ *
+ * SPECIAL CONSIDERATIONS:
+ *  None.
+ *
+ * AUTHOR:
+ *  D.L. Karmann
+ *
+ * MODIFIED:
+ *
+ */
+
+#include "DLK_EventLog.h"
+
+#define EVLOG_MAGIC_1           'E'
+#define EVLOG_MAGIC_2           'V'
+
+// DLK_EventLog Class members
+
+// Constructor
+DLK_EventLog::DLK_EventLog(void)
+{
+    WriteFilter = EVLOG_ALL_CRS;
+    EventLog_Clear();
+}
+
+// Add an event
+void DLK_EventLog::EventLog_Add(uint8_t type, uint8_t reg, uint32_t data)
+{
+    uint32_t now = millis();
+    uint16_t epoch = now >> 16;
+
+    if (epoch != LastEpoch)
+    {
+        if (Count == 0)
+        {
+            OldestEpoch = epoch;
+        }
+        else
+        {
+            EventLog_Put(now, EVLOG_TIME, 0, epoch);
+        }
+        LastEpoch = epoch;
+    }
+    EventLog_Put(now, type, reg, data);
+}
+
+// Record a status register value
+void DLK_EventLog::EventLog_Status(uint8_t reg, uint32_t val)
+{
+    uint8_t idx = reg - L99DZ200G_SR1;
+
+    if ((reg < L99DZ200G_SR1) || (idx >= EVLOG_SR_COUNT))
+    {
+        return;
+    }
+    val &= FULL_REG_MASK;
+    if ((SrValid & (1 << idx)) && (LastSr[idx] == val))
+    {
+        return;
+    }
+    SrValid |= 1 << idx;
+    LastSr[idx] = val;
+    EventLog_Add(EVLOG_SR, reg, val);
+}
+
+// Record a Control register write
+void DLK_EventLog::EventLog_Write(uint8_t reg, uint32_t val)
+{
+    if (((reg >= L99DZ200G_CR1) && (reg <= L99DZ200G_CR22)) || (reg == L99DZ200G_CFR))
+    {
+        if (WriteFilter & EVLOG_CR(reg))
+        {
+            EventLog_Add(EVLOG_WRITE, reg, val);
+        }
+    }
+}
+
+// Set the Control registers whose writes are recorded
+void DLK_EventLog::EventLog_SetWriteFilter(uint32_t regs)
+{
+    WriteFilter = regs & EVLOG_ALL_CRS;
+}
+
+// Remove all events
+void DLK_EventLog::EventLog_Clear(void)
+{
+    Next = 0;
+    Count = 0;
+    Lost = 0;
+    LastEpoch = millis() >> 16;
+    OldestEpoch = LastEpoch;
+    SrValid = 0;
+}
+
+// Get the number of events in the log
+uint8_t DLK_EventLog::EventLog_Count(void)
+{
+    return Count;
+}
+
+// Get the number of events overwritten since the log was cleared
+uint16_t DLK_EventLog::EventLog_Lost(void)
+{
+    return Lost;
+}
+
+// Get an event (0 = oldest)
+const EventLogEntry * DLK_EventLog::EventLog_Entry(uint8_t n)
+{
+    if (n >= Count)
+    {
+        return NULL;
+    }
+    return &Entries[(Next + EVLOG_ENTRIES - Count + n) % EVLOG_ENTRIES];
+}
+
+// Get the full time of an event
+uint32_t DLK_EventLog::EventLog_Time(uint8_t n)
+{
+    const EventLogEntry * ev;
+    uint16_t epoch = OldestEpoch;
+
+    if (n >= Count)
+    {
+        return 0;
+    }
+    for (uint8_t i = 0; i <= n; ++i)
+    {
+        ev = EventLog_Entry(i);
+        if (ev->type == EVLOG_TIME)
+        {
+            epoch = ev->data[0] | ((uint16_t)ev->data[1] << 8);
+        }
+    }
+    return ((uint32_t)epoch << 16) | ev->time;
+}
+
+// Write the log in binary
+void DLK_EventLog::EventLog_Dump(Print & out)
+{
+    uint8_t hdr[13];
+    uint32_t now = millis();
+    const EventLogEntry * ev;
+    uint8_t sum = 0;
+    uint8_t len = 0;
+
+    hdr[len++] = EVLOG_MAGIC_1;
+    hdr[len++] = EVLOG_MAGIC_2;
+    hdr[len++] = EVLOG_VERSION;
+    hdr[len++] = EVLOG_ENTRY_SIZE;
+    hdr[len++] = Count;
+    hdr[len++] = Lost & 0xFF;
+    hdr[len++] = Lost >> 8;
+    hdr[len++] = OldestEpoch & 0xFF;
+    hdr[len++] = OldestEpoch >> 8;
+    for (uint8_t b = 0; b < 4; ++b)
+    {
+        hdr[len++] = now >> (8 * b);
+    }
+    for (uint8_t i = 0; i < len; ++i)
+    {
+        sum += hdr[i];
+    }
+    out.write(hdr, len);
+
+    for (uint8_t n = 0; n < Count; ++n)
+    {
+        ev = EventLog_Entry(n);
+        hdr[0] = ev->time & 0xFF;
+        hdr[1] = ev->time >> 8;
+        hdr[2] = ev->type;
+        hdr[3] = ev->reg;
+        hdr[4] = ev->data[0];
+        hdr[5] = ev->data[1];
+        hdr[6] = ev->data[2];
+        for (uint8_t i = 0; i < EVLOG_ENTRY_SIZE; ++i)
+        {
+            sum += hdr[i];
+        }
+        out.write(hdr, EVLOG_ENTRY_SIZE);
+    }
+
+    out.write((uint8_t)~sum);
+}
+
+// Put an event in the ring buffer
+void DLK_EventLog::EventLog_Put(uint16_t time, uint8_t type, uint8_t reg, uint32_t data)
+{
+    EventLogEntry * ev = &Entries[Next];
+
+    if (Count < EVLOG_ENTRIES)
+    {
+        ++Count;
+    }
+    else
+    {
+        // overwriting the oldest event, a time mark sets the period of the events after it
+        if (ev->type == EVLOG_TIME)
+        {
+            OldestEpoch = ev->data[0] | ((uint16_t)ev->data[1] << 8);
+        }
+        if (Lost < 0xFFFF)
+        {
+            ++Lost;
+        }
+    }
+
+    ev->time = time;
+    ev->type = type;
+    ev->reg = reg;
+    ev->data[0] = data;
+    ev->data[1] = data >> 8;
+    ev->data[2] = data >> 16;
+    Next = (Next + 1) % EVLOG_ENTRIES;
+}
@@ -0,0 +1,215 @@
+/** \file DLK_EventLog.h */
+/*
+ * NAME: DLK_EventLog.h
+ *
+ * WHAT:
+ *  Header file for DLK_EventLog Arduino L99DZ200G fault/event ring buffer class.
+ *
+ *  A fixed-size RAM ring buffer of timestamped binary events, kept for post-mortem analysis
+ *  (e.g. after the L99DZ200G enters Fail Safe or resets). Once given to the driver with
+ *  L99DZ200G_SetEventLog(), the driver records:
+ *   - EVLOG_GSB: every Global Status Byte change
+ *   - EVLOG_SR: every SR1 to SR6 change seen by a register read
+ *   - EVLOG_WRITE: every Control register write that changes the register (not counting
+ *     the watchdog trigger bit), for the Control registers in the write filter
+ *   - EVLOG_WDOG_MISS: every watchdog trigger later than about the watchdog time
+ *  The application adds EVLOG_NINT, EVLOG_NRESET and its own events (EVLOG_USER and up)
+ *  with EventLog_Add(). When the buffer is full the oldest event is overwritten.
+ *
+ *  Each event is 7 bytes: the low 16 bits of millis(), the event type, a register (or
+ *  byte payload) and a 24 bit payload. An EVLOG_TIME event (payload = millis() >> 16) is
+ *  added before the first event of every 65.536 S period, so full event times can be
+ *  rebuilt offline.
+ *
+ *  EventLog_Dump() writes the buffer in binary (all values little-endian):
+ *   - header: 'E', 'V', version, event size, event count, events lost (2),
+ *             millis() >> 16 of the oldest event (2), millis() at the dump (4)
+ *   - the events, oldest first: time (2), type, register, payload (3)
+ *   - checksum: ~(8 bit sum of all the bytes before)
+ *
+ * SPECIAL CONSIDERATIONS:
+ *  Recording an event only writes RAM (no SPI or Serial traffic). Events are added from
+ *  loop() context only (not from interrupt handlers).
+ *  Status register bits cleared by Read & Clear show up as an EVLOG_SR change at the next
+ *  read; a fault still present after each clear is not recorded again.
+ *  High-rate Control register writes (PWM duty cycle ramps, ECV voltage) should be left out
+ *  of the write filter so they do not overwrite the events of interest.
+ *
+ * AUTHOR:
+ *  D.L. Karmann
+ *
+ */
+#ifndef __DLK_EVENTLOG_H__
+#define __DLK_EVENTLOG_H__
+
+#include "Arduino.h"
+#include "L99DZ200G.h"
+
+#ifndef EVLOG_ENTRIES
+#define EVLOG_ENTRIES           32      // events kept (1 to 255)
+#endif
+#define EVLOG_ENTRY_SIZE        7       // event bytes in the dump
+#define EVLOG_VERSION           1       // dump format version
+#define EVLOG_SR_COUNT          6       // SR1 to SR6 changes recorded
+
+// event types
+#define EVLOG_TIME              0       // payload = millis() >> 16
+#define EVLOG_GSB               1       // register = new GSB, payload = previous GSB
+#define EVLOG_SR                2       // register = SRn, payload = new value
+#define EVLOG_WRITE             3       // register = CRn/CFR, payload = value written
+#define EVLOG_WDOG_MISS         4       // payload = mS since the previous trigger
+#define EVLOG_NINT              5       // L99DZ200G NINT interrupt (application)
+#define EVLOG_NRESET            6       // L99DZ200G NRESET reset (application)
+#define EVLOG_USER              0x80    // first application event type
+
+// write filter bit of a Control register (L99DZ200G_CR1 to L99DZ200G_CR22, L99DZ200G_CFR)
+#define EVLOG_CR(reg)           (1UL << (((reg) == L99DZ200G_CFR) ? 22 : ((reg) - L99DZ200G_CR1)))
+#define EVLOG_ALL_CRS           0x7FFFFFUL
+
+/**
+ * Event log entry.
+ */
+typedef struct
+{
+    uint16_t time;          ///< millis() low 16 bits
+    uint8_t type;           ///< the event type (EVLOG_...)
+    uint8_t reg;            ///< the register (or byte payload)
+    uint8_t data[3];        ///< 24 bit payload (LSB first)
+} EventLogEntry;
+
+/**
+ * DLK_EventLog Arduino L99DZ200G fault/event ring buffer class.
+ */
+class DLK_EventLog
+{
+    public:
+        // Constructor
+        /**
+         *  A constructor that sets up an empty event log recording writes to all Control
+         *  registers.
+         *
+         *  \return None.
+         */
+        DLK_EventLog(void);
+
+        /**
+         * Add an event.
+         *
+         * \param type: the event type (EVLOG_NINT, EVLOG_NRESET, EVLOG_USER and up, ...)
+         * \param reg: the register (or byte payload)
+         * \param data: the 24 bit payload
+         *
+         *  \return None.
+         */
+        void EventLog_Add(uint8_t type, uint8_t reg, uint32_t data);
+
+        /**
+         * Record a status register value (adds an EVLOG_SR event if it changed).
+         *
+         * \param reg: the status register (only L99DZ200G_SR1 to L99DZ200G_SR6 are recorded)
+         * \param val: the register value
+         *
+         *  \return None.
+         */
+        void EventLog_Status(uint8_t reg, uint32_t val);
+
+        /**
+         * Record a Control register write (adds an EVLOG_WRITE event if the register is in
+         * the write filter).
+         *
+         * \param reg: the Control register: (L99DZ200G_CR1 to L99DZ200G_CR22, L99DZ200G_CFR)
+         * \param val: the value written
+         *
+         *  \return None.
+         */
+        void EventLog_Write(uint8_t reg, uint32_t val);
+
+        /**
+         * Set the Control registers whose writes are recorded.
+         *
+         * \param regs: EVLOG_CR(reg) bits or'ed together, or EVLOG_ALL_CRS
+         *
+         *  \return None.
+         */
+        void EventLog_SetWriteFilter(uint32_t regs);
+
+        /**
+         * Remove all events (and forget the recorded status register values).
+         *
+         *  \return None.
+         */
+        void EventLog_Clear(void);
+
+        /**
+         * Get the number of events in the log.
+         *
+         * \return   uint8_t = the events: (0 to EVLOG_ENTRIES)
+         */
+        uint8_t EventLog_Count(void);
+
+        /**
+         * Get the number of events overwritten since the log was cleared.
+         *
+         * \return   uint16_t = the events lost (saturates at 65535)
+         */
+        uint16_t EventLog_Lost(void);
+
+        /**
+         * Get an event.
+         *
+         * \param n: the event: (0 = oldest to EventLog_Count() - 1)
+         *
+         * \return   const EventLogEntry * = the event (NULL for an invalid event)
+         */
+        const EventLogEntry * EventLog_Entry(uint8_t n);
+
+        /**
+         * Get the full time of an event.
+         *
+         * \param n: the event: (0 = oldest to EventLog_Count() - 1)
+         *
+         * \return   uint32_t = the millis() value the event was added at
+         */
+        uint32_t EventLog_Time(uint8_t n);
+
+        /**
+         * Write the log in binary (see the dump format above).
+         *
+         * \param out: where to write the dump (e.g. Serial)
+         *
+         *  \return None.
+         */
+        void EventLog_Dump(Print & out);
+
+    private:
+        /// event ring buffer
+        EventLogEntry Entries[EVLOG_ENTRIES];
+
+        /// index the next event is put at
+        uint8_t Next;
+
+        /// number of events in the log
+        uint8_t Count;
+
+        /// events overwritten
+        uint16_t Lost;
+
+        /// millis() >> 16 of the oldest event
+        uint16_t OldestEpoch;
+
+        /// millis() >> 16 of the newest event
+        uint16_t LastEpoch;
+
+        /// Control registers whose writes are recorded (EVLOG_CR() bits)
+        uint32_t WriteFilter;
+
+        /// last recorded SR1 to SR6 values
+        uint32_t LastSr[EVLOG_SR_COUNT];
+
+        /// recorded SR1 to SR6 values (bit n = SR1 + n)
+        uint8_t SrValid;
+
+        /// Put an event in the ring buffer
+        void EventLog_Put(uint16_t time, uint8_t type, uint8_t reg, uint32_t data);
+};
+#endif  // __DLK_EVENTLOG_H__
@@ -0,0 +1,234 @@
+/** \file DLK_HeaterRegulator.cpp */
+/*
+ * NAME: DLK_HeaterRegulator.cpp
+ *
+ * WHAT:
+ *  Arduino L99DZ200G thermostatic mirror heater functions.
+ *
+ * SPECIAL CONSIDERATIONS:
+ *  None.
+ *
+ * AUTHOR:
+ *  D.L. Karmann
+ *
+ * MODIFIED:
+ *
+ */
+
+#include "DLK_HeaterRegulator.h"
+
+// DLK_HeaterRegulator Class members
+
+// Constructor
+DLK_HeaterRegulator::DLK_HeaterRegulator(DLK_L99DZ200G & l99dz200g)
+{
+    L99 = &l99dz200g;
+    Cluster = TEMP_CL1;
+    Setpoint = HEATREG_SETPOINT_C;
+    RateLimit = 0;
+    OpenLoadCheck = OL_DIAG_OFF;
+    State = HEATREG_OFF;
+    Duty = 0;
+    HeaterOn = false;
+    Inhibited = false;
+    Temp = HEATREG_TEMP_INVALID;
+    StartTime = 0;
+    MaxTime = 0;
+    PeriodStart = 0;
+    OnTime = 0;
+}
+
+// Set the thermal cluster feedback and the heater MOSFET drain-source monitor threshold - CR11
+void DLK_HeaterRegulator::HeaterReg_Begin(uint8_t therm_cluster, uint8_t mon_threshld)
+{
+    Cluster = therm_cluster;
+    L99->L99DZ200G_SetHeaterMonitorThresholdVoltage(mon_threshld);
+}
+
+// Set the temperature setpoint
+void DLK_HeaterRegulator::HeaterReg_SetSetpoint(float temp_c)
+{
+    Setpoint = temp_c;
+}
+
+// Set the temperature rise rate limit
+void DLK_HeaterRegulator::HeaterReg_SetRateLimit(float c_per_sec)
+{
+    RateLimit = (c_per_sec > 0) ? c_per_sec : 0;
+}
+
+// Switch ON/OFF the heater open-load check - CR11
+void DLK_HeaterRegulator::HeaterReg_SetOpenLoadCheck(uint8_t on_off)
+{
+    OpenLoadCheck = on_off;
+    L99->L99DZ200G_HeaterOpenLoadDiagnosisControl(on_off);
+}
+
+// Start regulating the heater
+void DLK_HeaterRegulator::HeaterReg_Start(uint32_t max_ms)
+{
+    StartTime = millis();
+    MaxTime = max_ms;
+    PeriodStart = StartTime - HEATREG_PERIOD_MS;    // first period starts now
+    OnTime = 0;
+    Duty = 0;
+    Temp = HEATREG_TEMP_INVALID;
+    State = HEATREG_HEATING;
+
+    HeaterReg_Tick();
+}
+
+// Stop regulating and turn the heater off
+void DLK_HeaterRegulator::HeaterReg_Stop(void)
+{
+    HeaterReg_Halt(HEATREG_OFF);
+}
+
+// Hold the heater off while regulating, or let it heat again
+void DLK_HeaterRegulator::HeaterReg_Inhibit(bool inhibit)
+{
+    Inhibited = inhibit;
+    if (inhibit && HeaterOn)
+    {
+        L99->L99DZ200G_HeaterOutputControl(OFF_OUT);
+        HeaterOn = false;
+    }
+}
+
+// Run the regulator
+void DLK_HeaterRegulator::HeaterReg_Tick(void)
+{
+    uint32_t now;
+    uint32_t elapsed;
+    float temp;
+    float rise;
+    float duty;
+
+    if (State != HEATREG_HEATING)
+    {
+        return;
+    }
+
+    now = millis();
+    elapsed = now - PeriodStart;
+
+    // end of the on time (a 100% period stays on into the next period)
+    if (HeaterOn && (OnTime < HEATREG_PERIOD_MS) && (elapsed >= OnTime))
+    {
+        L99->L99DZ200G_HeaterOutputControl(OFF_OUT);
+        HeaterOn = false;
+    }
+
+    if (elapsed < HEATREG_PERIOD_MS)
+    {
+        return;
+    }
+
+    // new period
+    if ((MaxTime != 0) && ((now - StartTime) >= MaxTime))
+    {
+        HeaterReg_Halt(HEATREG_DONE);
+        return;
+    }
+
+    L99->L99DZ200G_BeginSession();
+
+    // heater faults
+    if (L99->L99DZ200G_GetShortCircuitAlertStatus(DS_MON_HEAT) != L99DZ200G_OK)
+    {
+        L99->L99DZ200G_ClearShortCircuitAlertStatus(DS_MON_HEAT);
+        L99->L99DZ200G_EndSession();
+        HeaterReg_Halt(HEATREG_SHORT);
+        return;
+    }
+    if ((OpenLoadCheck == OL_DIAG_ON) && (L99->L99DZ200G_GetOpenLoadStatus(OUT_GH) != L99DZ200G_OK))
+    {
+        L99->L99DZ200G_ClearOpenLoadStatus(OUT_GH);
+        L99->L99DZ200G_EndSession();
+        HeaterReg_Halt(HEATREG_OPEN_LOAD);
+        return;
+    }
+
+    temp = L99->L99DZ200G_GetThermalClusterTemp(Cluster);
+    if (temp <= HEATREG_TEMP_INVALID)
+    {
+        L99->L99DZ200G_EndSession();
+        HeaterReg_Halt(HEATREG_SENSOR_FAIL);
+        return;
+    }
+
+    // proportional band below the setpoint
+    if (temp >= Setpoint)
+    {
+        duty = 0;
+    }
+    else if (temp <= (Setpoint - HEATREG_PBAND_C))
+    {
+        duty = 100;
+    }
+    else
+    {
+        duty = ((Setpoint - temp) * 100) / HEATREG_PBAND_C;
+    }
+
+    // rate limit: scale the power down by how much the last period rose too fast
+    if ((RateLimit > 0) && (Temp > HEATREG_TEMP_INVALID))
+    {
+        rise = ((temp - Temp) * 1000) / elapsed;
+        if (rise > RateLimit)
+        {
+            duty = (duty * RateLimit) / rise;
+        }
+    }
+
+    Temp = temp;
+    PeriodStart = now;
+    Duty = (uint8_t)duty;
+    OnTime = ((uint32_t)HEATREG_PERIOD_MS * Duty) / 100;
+    if ((OnTime < HEATREG_MIN_ON_MS) || Inhibited)
+    {
+        OnTime = 0;
+        Duty = 0;
+    }
+
+    if ((OnTime != 0) && !HeaterOn)
+    {
+        L99->L99DZ200G_HeaterOutputControl(ON_OUT);
+        HeaterOn = true;
+    }
+    else if ((OnTime == 0) && HeaterOn)
+    {
+        L99->L99DZ200G_HeaterOutputControl(OFF_OUT);
+        HeaterOn = false;
+    }
+
+    L99->L99DZ200G_EndSession();
+}
+
+// Get the regulator state
+uint8_t DLK_HeaterRegulator::HeaterReg_State(void)
+{
+    return State;
+}
+
+// Get the heater duty cycle of the present PWM period
+uint8_t DLK_HeaterRegulator::HeaterReg_Duty(void)
+{
+    return Duty;
+}
+
+// Get the last thermal cluster temperature read
+float DLK_HeaterRegulator::HeaterReg_Temp(void)
+{
+    return Temp;
+}
+
+// Stop with a state, heater off
+void DLK_HeaterRegulator::HeaterReg_Halt(uint8_t state)
+{
+    L99->L99DZ200G_HeaterOutputControl(OFF_OUT);
+    HeaterOn = false;
+    Duty = 0;
+    OnTime = 0;
+    State = state;
+}
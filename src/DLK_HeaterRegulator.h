@@ -0,0 +1,207 @@
+/** \file DLK_HeaterRegulator.h */
+/*
+ * NAME: DLK_HeaterRegulator.h
+ *
+ * WHAT:
+ *  Header file for DLK_HeaterRegulator Arduino L99DZ200G thermostatic mirror heater class.
+ *
+ *  The heater gate driver output (OUT_GH) is only on/off, so the regulator drives it with
+ *  a slow time-proportioned PWM (HEATREG_PERIOD_MS period). At the start of each period the
+ *  temperature of a L99DZ200G thermal cluster is read and the heater on time is set from a
+ *  proportional band below the setpoint (full power far below it, no power at or above it).
+ *  The on time is cut back when the temperature rises faster than the rate limit.
+ *
+ *  The external heater MOSFET drain-source monitor threshold is set by HeaterReg_Begin();
+ *  the regulator stops with a fault if the drain-source monitor trips (heater short/overload)
+ *  or, if enabled, if the heater open-load diagnosis reports an open heater.
+ *
+ * SPECIAL CONSIDERATIONS:
+ *  The thermal clusters measure the L99DZ200G die temperature near the cluster outputs, so
+ *  the setpoint is for the cluster temperature the heater produces there, not the glass.
+ *  Each period makes at most two CR5 writes (heater on, heater off) and one temperature
+ *  and one status read.
+ *
+ * AUTHOR:
+ *  D.L. Karmann
+ *
+ */
+#ifndef __DLK_HEATERREGULATOR_H__
+#define __DLK_HEATERREGULATOR_H__
+
+#include "Arduino.h"
+#include "DLK_L99DZ200G.h"
+
+#define HEATREG_PERIOD_MS       1000    // heater PWM period (mS)
+#define HEATREG_MIN_ON_MS       50      // shortest heater on time (mS), shorter = off
+#define HEATREG_PBAND_C         5.0F    // proportional band below the setpoint (C)
+#define HEATREG_SETPOINT_C      45.0F   // default setpoint (C)
+#define HEATREG_TEMP_INVALID    -999.0F // invalid thermal cluster temperature
+
+// heater regulator states
+#define HEATREG_OFF             0       // heater off
+#define HEATREG_HEATING         1       // regulating
+#define HEATREG_DONE            2       // maximum heating time reached
+#define HEATREG_OPEN_LOAD       3       // stopped, heater open-load
+#define HEATREG_SHORT           4       // stopped, heater drain-source monitor tripped
+#define HEATREG_SENSOR_FAIL     5       // stopped, invalid thermal cluster temperature
+
+/**
+ * DLK_HeaterRegulator Arduino L99DZ200G thermostatic mirror heater class.
+ */
+class DLK_HeaterRegulator
+{
+    public:
+        // Constructor
+        /**
+         *  A constructor that sets up the heater regulator.
+         *
+         *  \param l99dz200g: the L99DZ200G driving the heater MOSFET
+         *
+         *  \return None.
+         */
+        DLK_HeaterRegulator(DLK_L99DZ200G & l99dz200g);
+
+        /**
+         * Set the thermal cluster used as temperature feedback and the heater MOSFET
+         * drain-source monitor threshold - CR11.
+         *
+         * \param therm_cluster: the Thermal Cluster:
+         *                       (TEMP_CL1, TEMP_CL2, TEMP_CL3, TEMP_CL4, TEMP_CL5, TEMP_CL6)
+         * \param mon_threshld: the monitoring threshold voltage:
+         *                      (GH_TH_200_MV, GH_TH_250_MV, GH_TH_300_MV, GH_TH_350_MV,
+         *                       GH_TH_400_MV, GH_TH_450_MV, GH_TH_500_MV, GH_TH_550_MV)
+         *
+         *  \return None.
+         */
+        void HeaterReg_Begin(uint8_t therm_cluster, uint8_t mon_threshld);
+
+        /**
+         * Set the temperature setpoint.
+         *
+         * \param temp_c: the setpoint (Celsius)
+         *
+         *  \return None.
+         */
+        void HeaterReg_SetSetpoint(float temp_c);
+
+        /**
+         * Set the temperature rise rate limit.
+         *
+         * \param c_per_sec: the fastest temperature rise allowed (Celsius/S, 0 = no limit)
+         *
+         *  \return None.
+         */
+        void HeaterReg_SetRateLimit(float c_per_sec);
+
+        /**
+         * Switch ON/OFF the heater open-load check (L99DZ200G heater open-load diagnosis) - CR11.
+         *
+         * \param on_off: the heater open-load check: (OL_DIAG_OFF, OL_DIAG_ON)
+         *
+         *  \return None.
+         */
+        void HeaterReg_SetOpenLoadCheck(uint8_t on_off);
+
+        /**
+         * Start regulating the heater.
+         *
+         * \param max_ms: the maximum heating time (mS, 0 = until stopped)
+         *
+         *  \return None.
+         */
+        void HeaterReg_Start(uint32_t max_ms);
+
+        /**
+         * Stop regulating and turn the heater off.
+         *
+         *  \return None.
+         */
+        void HeaterReg_Stop(void);
+
+        /**
+         * Hold the heater off while regulating (e.g. while its load is shed), or let it heat
+         * again from the next PWM period.
+         *
+         * \param inhibit: true = hold the heater off, false = heat as regulated
+         *
+         *  \return None.
+         */
+        void HeaterReg_Inhibit(bool inhibit);
+
+        /**
+         * Run the regulator (call often from loop()). Makes no SPI transfers except at the
+         * start of a PWM period and when the heater on time ends.
+         *
+         *  \return None.
+         */
+        void HeaterReg_Tick(void);
+
+        /**
+         * Get the regulator state.
+         *
+         * \return   uint8_t = the state: (HEATREG_OFF, HEATREG_HEATING, HEATREG_DONE,
+         *                     HEATREG_OPEN_LOAD, HEATREG_SHORT, HEATREG_SENSOR_FAIL)
+         */
+        uint8_t HeaterReg_State(void);
+
+        /**
+         * Get the heater duty cycle of the present PWM period.
+         *
+         * \return   uint8_t = the duty cycle: (0 to 100%)
+         */
+        uint8_t HeaterReg_Duty(void);
+
+        /**
+         * Get the last thermal cluster temperature read.
+         *
+         * \return   float = the temperature (Celsius)
+         */
+        float HeaterReg_Temp(void);
+
+    private:
+        /// L99DZ200G driving the heater MOSFET
+        DLK_L99DZ200G * L99;
+
+        /// thermal cluster used as feedback
+        uint8_t Cluster;
+
+        /// temperature setpoint (C)
+        float Setpoint;
+
+        /// temperature rise rate limit (C/S, 0 = none)
+        float RateLimit;
+
+        /// heater open-load check (OL_DIAG_OFF, OL_DIAG_ON)
+        uint8_t OpenLoadCheck;
+
+        /// regulator state (HEATREG_...)
+        uint8_t State;
+
+        /// duty cycle of the present period (%)
+        uint8_t Duty;
+
+        /// true = heater output is on
+        bool HeaterOn;
+
+        /// true = heater held off (HeaterReg_Inhibit())
+        bool Inhibited;
+
+        /// last temperature read (C)
+        float Temp;
+
+        /// time (mS) heating started
+        uint32_t StartTime;
+
+        /// maximum heating time (mS, 0 = until stopped)
+        uint32_t MaxTime;
+
+        /// time (mS) the present period started
+        uint32_t PeriodStart;
+
+        /// heater on time of the present period (mS)
+        uint32_t OnTime;
+
+        /// Stop with a state, heater off
+        void HeaterReg_Halt(uint8_t state);
+};
+#endif  // __DLK_HEATERREGULATOR_H__
@@ -20,6 +20,41 @@
 
 // outside of DLK_L99DZ200G class
 
+// SPI clocks (bps) stepped through by L99DZ200G_CalibrateSPIClock() (ascending)
+static const uint32_t SPIClockSteps[] PROGMEM =
+{
+    250000, 500000, 1000000, 2000000, 4000000, 5000000, 8000000, 10000000, 12000000, 16000000
+};
+#define SPI_CLOCK_STEPS     (sizeof(SPIClockSteps) / sizeof(SPIClockSteps[0]))
+
+// perceptual brightness level (0 to PWM_LEVEL_MAX) to 10 bit PWM duty cycle (CIE 1931 lightness)
+static const uint16_t PWMGammaTable[PWM_LEVEL_MAX + 1] PROGMEM =
+{
+       0,    1,    1,    1,    2,    2,    3,    3,    4,    4,    4,    5,    5,    6,    6,    7,
+       7,    8,    8,    8,    9,    9,   10,   10,   11,   11,   12,   12,   13,   13,   14,   15,
+      15,   16,   17,   17,   18,   19,   19,   20,   21,   22,   22,   23,   24,   25,   26,   27,
+      28,   29,   30,   31,   32,   33,   34,   35,   36,   37,   38,   39,   40,   42,   43,   44,
+      45,   47,   48,   50,   51,   52,   54,   55,   57,   58,   60,   61,   63,   65,   66,   68,
+      70,   71,   73,   75,   77,   79,   81,   83,   84,   86,   88,   90,   93,   95,   97,   99,
+     101,  103,  106,  108,  110,  113,  115,  118,  120,  123,  125,  128,  130,  133,  136,  138,
+     141,  144,  147,  149,  152,  155,  158,  161,  164,  167,  171,  174,  177,  180,  183,  187,
+     190,  194,  197,  200,  204,  208,  211,  215,  218,  222,  226,  230,  234,  237,  241,  245,
+     249,  254,  258,  262,  266,  270,  275,  279,  283,  288,  292,  297,  301,  306,  311,  315,
+     320,  325,  330,  335,  340,  345,  350,  355,  360,  365,  370,  376,  381,  386,  392,  397,
+     403,  408,  414,  420,  425,  431,  437,  443,  449,  455,  461,  467,  473,  480,  486,  492,
+     499,  505,  512,  518,  525,  532,  538,  545,  552,  559,  566,  573,  580,  587,  594,  601,
+     609,  616,  624,  631,  639,  646,  654,  662,  669,  677,  685,  693,  701,  709,  717,  726,
+     734,  742,  751,  759,  768,  776,  785,  794,  802,  811,  820,  829,  838,  847,  857,  866,
+     875,  885,  894,  903,  913,  923,  932,  942,  952,  962,  972,  982,  992, 1002, 1013, 1023
+};
+
+// Device Information Registers ROM addresses read by L99DZ200G_ReadDeviceInfo()
+static const uint8_t RomAddresses[] PROGMEM =
+{
+    ROM_ID_HEADER, ROM_VERSION, ROM_PRODUCT_CODE_1, ROM_PRODUCT_CODE_2, ROM_SILICON_VERSION,
+    ROM_SPI_FRAME_ID, ROM_WD_TYPE_1, ROM_WD_TYPE_2, ROM_WD_BIT_POS_1, ROM_WD_BIT_POS_2
+};
+
 // private static class variables must be initialized outside of class
 bool DLK_L99DZ200G::SPI_initted = false;
 
@@ -32,40 +67,231 @@ DLK_L99DZ200G::DLK_L99DZ200G(uint32_t spi_speed, uint8_t cs_pin)
 
     SPISettings spi_settings(spi_speed, MSBFIRST, SPI_MODE0);
     SPI_Settings = spi_settings;
+    SPI_Speed = spi_speed;
+    WatchdogRunning = true;
+    SessionDepth = 0;
+    SessionBus = false;
+    BusErrors = 0;
+    VerifyPolicy = L99DZ200G_VERIFY_NEVER;
+    VerifyNth = 1;
+    VerifyRetries = 0;
+    VerifyWriteCnt = 0;
+    VerifyPending = false;
+    VerifyBusy = false;
+    VerifyResult = L99DZ200G_OK;
+    memset(&VerifyStats, 0, sizeof(VerifyStats));
+    ShadowValid = 0;
+    ScrubIndex = 0;
+    memset(&ScrubStats, 0, sizeof(ScrubStats));
+    memset(&DeviceInfo, 0, sizeof(DeviceInfo));
+    SPI_bus = NULL;
+    SPI_busDev = SPIBUS_NO_DEVICE;
+    EvLog = NULL;
+    GlobalStatusRegister = 0;
+}
+
+// Constructor for L99DZ200G on a shared SPI bus
+DLK_L99DZ200G::DLK_L99DZ200G(DLK_SPIBus & spi_bus, uint32_t spi_speed, uint8_t cs_pin)
+{
+    CS_pin = cs_pin;
+
+    SPISettings spi_settings(spi_speed, MSBFIRST, SPI_MODE0);
+    SPI_Settings = spi_settings;
+    SPI_Speed = spi_speed;
     WatchdogRunning = true;
+    SessionDepth = 0;
+    SessionBus = false;
+    BusErrors = 0;
+    VerifyPolicy = L99DZ200G_VERIFY_NEVER;
+    VerifyNth = 1;
+    VerifyRetries = 0;
+    VerifyWriteCnt = 0;
+    VerifyPending = false;
+    VerifyBusy = false;
+    VerifyResult = L99DZ200G_OK;
+    memset(&VerifyStats, 0, sizeof(VerifyStats));
+    ShadowValid = 0;
+    ScrubIndex = 0;
+    memset(&ScrubStats, 0, sizeof(ScrubStats));
+    memset(&DeviceInfo, 0, sizeof(DeviceInfo));
+    EvLog = NULL;
+    GlobalStatusRegister = 0;
+
+    // watchdog trigger frames get the highest priority on the shared bus
+    SPI_bus = &spi_bus;
+    SPI_busDev = SPI_bus->SPIBus_AddDevice(spi_speed, SPIBUS_PRIO_HIGH);
+    SPI_bus->SPIBus_SetPendingHandler(SPI_busDev, L99DZ200G_BusWdogTrigger, this);
 }
 
 // Initialize L99DZ200G
 uint8_t DLK_L99DZ200G::L99DZ200G_Init(void)
 {
-   // setup SPI
-    SPI_dev = &SPI;
+    if (L99DZ200G_SetupSPI() != L99DZ200G_OK)
+    {
+        return L99DZ200G_FAIL;
+    }
+
+    L99DZ200G_ReadDeviceInfo();
+
+    return L99DZ200G_OK;
+}
+
+// Set up the SPI interface and the Chip Select pin (no L99DZ200G frames)
+uint8_t DLK_L99DZ200G::L99DZ200G_SetupSPI(void)
+{
+    if ((SPI_bus != NULL) && (SPI_busDev == SPIBUS_NO_DEVICE))
+    {
+        return L99DZ200G_FAIL;      // no room on shared SPI bus
+    }
 
-    if (!SPI_initted)
+   // setup SPI
+    if (SPI_bus != NULL)
     {
-        SPI_dev->begin();
-        SPI_initted = true;
+        SPI_bus->SPIBus_Begin();
+        SPI_dev = SPI_bus->SPIBus_SPI();
+    }
+    else
+    {
+        SPI_dev = &SPI;
+
+        if (!SPI_initted)
+        {
+            SPI_dev->begin();
+            SPI_initted = true;
+        }
     }
 
     pinMode(CS_pin, OUTPUT);
     digitalWrite(CS_pin, HIGH);
 
+#if defined(__AVR__) && !defined(TEENSYDUINO)
+    // resolve the CS pin once so each frame does not repeat the pin table lookups
+    CS_port = portOutputRegister(digitalPinToPort(CS_pin));
+    CS_mask = digitalPinToBitMask(CS_pin);
+#endif
+
     return L99DZ200G_OK;
 }
 
-// Initiate L99DZ200G SPI transaction
-inline void DLK_L99DZ200G::L99DZ200G_StartSPI(void)
+// Drive the Chip Select pin low (selected)
+inline void DLK_L99DZ200G::L99DZ200G_SelectCS(void)
 {
-    SPI_dev->beginTransaction(SPI_Settings);
+#if defined(TEENSYDUINO)
+    digitalWriteFast(CS_pin, LOW);
+#elif defined(__AVR__)
+    uint8_t sreg_save = SREG;   // port may also be written from an interrupt
+
+    cli();
+    *CS_port &= ~CS_mask;
+    SREG = sreg_save;
+#else
     digitalWrite(CS_pin, LOW);
+#endif
+}
+
+// Drive the Chip Select pin high (deselected)
+inline void DLK_L99DZ200G::L99DZ200G_DeselectCS(void)
+{
+#if defined(TEENSYDUINO)
+    digitalWriteFast(CS_pin, HIGH);
+#elif defined(__AVR__)
+    uint8_t sreg_save = SREG;   // port may also be written from an interrupt
+
+    cli();
+    *CS_port |= CS_mask;
+    SREG = sreg_save;
+#else
+    digitalWrite(CS_pin, HIGH);
+#endif
+}
+
+// Set up the SPI bus for L99DZ200G frames (false = shared SPI bus held by another device)
+inline bool DLK_L99DZ200G::L99DZ200G_BeginTransaction(void)
+{
+    if (SPI_bus != NULL)
+    {
+        return SPI_bus->SPIBus_Acquire(SPI_busDev);
+    }
+
+    SPI_dev->beginTransaction(SPI_Settings);
+    return true;
+}
+
+// Release the SPI bus from L99DZ200G frames
+inline void DLK_L99DZ200G::L99DZ200G_EndTransaction(void)
+{
+    if (SPI_bus != NULL)
+    {
+        SPI_bus->SPIBus_Release(SPI_busDev);
+    }
+    else
+    {
+        SPI_dev->endTransaction();
+    }
+}
+
+// Begin a L99DZ200G SPI session
+void DLK_L99DZ200G::L99DZ200G_BeginSession(void)
+{
+    if (SessionDepth++ == 0)
+    {
+        SessionBus = L99DZ200G_BeginTransaction();
+    }
+}
+
+// End a L99DZ200G SPI session
+void DLK_L99DZ200G::L99DZ200G_EndSession(void)
+{
+    if (SessionDepth == 0)
+    {
+        return;
+    }
+
+    if ((--SessionDepth == 0) && SessionBus)
+    {
+        L99DZ200G_EndTransaction();
+        SessionBus = false;
+    }
+}
+
+// Initiate L99DZ200G SPI transaction (false = shared SPI bus held by another device, CS not asserted)
+inline bool DLK_L99DZ200G::L99DZ200G_StartSPI(void)
+{
+    bool acquired;
+
+    if (SessionDepth == 0)
+    {
+        acquired = L99DZ200G_BeginTransaction();
+    }
+    else
+    {
+        if (!SessionBus)
+        {
+            // the session could not get the bus when it began, try again
+            SessionBus = L99DZ200G_BeginTransaction();
+        }
+        acquired = SessionBus;
+    }
+
+    if (!acquired)
+    {
+        ++BusErrors;
+        return false;
+    }
+
+    L99DZ200G_SelectCS();
+    return true;
 }
 
 // Terminate L99DZ200G SPI transaction
 inline void DLK_L99DZ200G::L99DZ200G_EndSPI(void)
 {
-    digitalWrite(CS_pin, HIGH);
+    L99DZ200G_DeselectCS();
 
-    SPI_dev->endTransaction();
+    if (SessionDepth == 0)
+    {
+        L99DZ200G_EndTransaction();
+    }
 
 #ifdef TEENSYDUINO
     // required delay between SPI transactions (specified 6 uS min - Fig. 15)
@@ -81,6 +307,13 @@ inline void DLK_L99DZ200G::L99DZ200G_EndSPI(void)
     // @ 8 Mhz = 10 uS                      - works
     // @ 4 Mhz = 47 uS                      - works
     // @ 2 Mhz = 56 uS                      - works
+#else
+    if (SessionDepth != 0)
+    {
+        // no end/begin of SPI transaction between frames in a session,
+        // so hold CSN high for its minimum time (Fig. 15)
+        delayMicroseconds(L99DZ200G_CSN_HIGH_US);
+    }
 #endif
 }
 
@@ -108,7 +341,15 @@ uint8_t DLK_L99DZ200G::L99DZ200G_ReadRomAddress(uint8_t addr)
     uint8_t ret;
     uint8_t spi_data[2] = { SPI_DUMMY_BYTE };
 
-    L99DZ200G_StartSPI();
+    if (addr >= L99DZ200G_CFR)
+    {
+        return 0;   // not a ROM read, this frame resets all Control registers
+    }
+
+    if (!L99DZ200G_StartSPI())
+    {
+        return 0;
+    }
     spi_data[0] = SET_SPI_DEV_INFO(addr);
     SPI_dev->transfer(spi_data, sizeof(spi_data));
     ret = spi_data[1];
@@ -117,19 +358,79 @@ uint8_t DLK_L99DZ200G::L99DZ200G_ReadRomAddress(uint8_t addr)
     return ret;
 }
 
+// Read the L99DZ200G Device Information Registers ROM addresses into the cached device information
+uint8_t DLK_L99DZ200G::L99DZ200G_ReadDeviceInfo(void)
+{
+    uint8_t * rom = DeviceInfo.rom;
+    uint8_t ones = 0xFF;
+    uint8_t zeros = 0x00;
+    uint8_t addr;
+
+    memset(rom, 0, sizeof(DeviceInfo.rom));
+
+    L99DZ200G_BeginSession();
+    for (uint8_t i = 0; i < sizeof(RomAddresses); ++i)
+    {
+        addr = pgm_read_byte(&RomAddresses[i]);
+        rom[addr] = L99DZ200G_ReadRomAddress(addr);
+        ones &= rom[addr];
+        zeros |= rom[addr];
+    }
+    L99DZ200G_EndSession();
+
+    DeviceInfo.id_header = rom[ROM_ID_HEADER];
+    DeviceInfo.version = rom[ROM_VERSION];
+    DeviceInfo.product_code = ((uint16_t)rom[ROM_PRODUCT_CODE_1] << 8) | rom[ROM_PRODUCT_CODE_2];
+    DeviceInfo.silicon_version = rom[ROM_SILICON_VERSION];
+    DeviceInfo.spi_frame_id = rom[ROM_SPI_FRAME_ID];
+    DeviceInfo.wd_type = ((uint16_t)rom[ROM_WD_TYPE_1] << 8) | rom[ROM_WD_TYPE_2];
+    DeviceInfo.wd_bit_pos = ((uint16_t)rom[ROM_WD_BIT_POS_1] << 8) | rom[ROM_WD_BIT_POS_2];
+
+    // a missing L99DZ200G reads back all the same (MISO floating high or pulled low)
+    DeviceInfo.valid = (ones != 0xFF) && (zeros != 0x00);
+
+    return DeviceInfo.valid ? L99DZ200G_OK : L99DZ200G_FAIL;
+}
+
+// Get the cached L99DZ200G device information
+const L99DZ200GDeviceInfo * DLK_L99DZ200G::L99DZ200G_GetDeviceInfo(void)
+{
+    return &DeviceInfo;
+}
+
 // Read from specified L99DZ200G register
 uint32_t DLK_L99DZ200G::L99DZ200G_ReadRegister(uint8_t reg)
 {
     uint32_t ret;
+    uint32_t mask;
     uint8_t spi_data[SPI_TRANSACTION_SIZE] = { SPI_DUMMY_BYTE };
 
-    L99DZ200G_StartSPI();
+    if (!L99DZ200G_StartSPI())
+    {
+        return 0;
+    }
     spi_data[0] = SET_SPI_RD(reg);
     SPI_dev->transfer(spi_data, sizeof(spi_data));
-    GlobalStatusRegister = spi_data[0];
+    L99DZ200G_SetGsb(spi_data[0]);
     ArrayToUint32(spi_data, &ret);
     L99DZ200G_EndSPI();
 
+    if (EvLog != NULL)
+    {
+        EvLog->EventLog_Status(reg, ret);
+    }
+
+    if (VerifyPending && !VerifyBusy && (reg == VerifyReg))
+    {
+        L99DZ200G_VerifyCheck(ret, true, VerifyRetries);
+        if (VerifyResult == L99DZ200G_OK)
+        {
+            // the register now holds the verified value (it may have just been rewritten)
+            mask = L99DZ200G_ScrubMask(reg);
+            ret = (ret & ~mask) | (VerifyVal & mask);
+        }
+    }
+
     return ret;
 }
 
@@ -137,13 +438,67 @@ uint32_t DLK_L99DZ200G::L99DZ200G_ReadRegister(uint8_t reg)
 void DLK_L99DZ200G::L99DZ200G_WriteControlRegister(uint8_t reg, uint32_t val)
 {
     uint8_t spi_data[SPI_TRANSACTION_SIZE];
+    uint32_t prev_data;
+    uint32_t changed;
+    int8_t idx;
+    bool verify = false;
+
+    if (!VerifyBusy)
+    {
+        ++VerifyStats.writes;
+        verify = L99DZ200G_VerifySelect(reg);
+        if (verify && VerifyPending && (reg != VerifyReg))
+        {
+            L99DZ200G_FlushVerify();    // only one write waits for verification
+        }
+    }
 
-    L99DZ200G_StartSPI();
+    if (!L99DZ200G_StartSPI())
+    {
+        return;     // not written (shadow image unchanged)
+    }
     Uint32ToArray(val, spi_data);
     spi_data[0] = SET_SPI_WR(reg);
     SPI_dev->transfer(spi_data, sizeof(spi_data));
-    GlobalStatusRegister = spi_data[0];
+    L99DZ200G_SetGsb(spi_data[0]);
+    ArrayToUint32(spi_data, &prev_data);
     L99DZ200G_EndSPI();
+
+    // keep the shadow image of the Control register
+    idx = L99DZ200G_ShadowIndex(reg);
+    if ((EvLog != NULL) && (idx >= 0))
+    {
+        // record writes that change the register (watchdog triggers only toggle the CR1/CFR WDC bit)
+        changed = (Shadow[idx] ^ val) & FULL_REG_MASK;
+        if ((reg == L99DZ200G_CR1) || (reg == L99DZ200G_CFR))
+        {
+            changed &= ~(uint32_t)CR1_WDC_MASK;
+        }
+        if (!(ShadowValid & (1UL << idx)) || changed)
+        {
+            EvLog->EventLog_Write(reg, val & FULL_REG_MASK);
+        }
+    }
+    if (idx >= 0)
+    {
+        Shadow[idx] = val & FULL_REG_MASK;
+        ShadowValid |= (1UL << idx);
+    }
+
+    if (!VerifyBusy)
+    {
+        if (VerifyPending && (reg == VerifyReg))
+        {
+            // the write response is the previous register contents (no rewrite, it was just overwritten)
+            L99DZ200G_VerifyCheck(prev_data, true, 0);
+        }
+        if (verify)
+        {
+            VerifyPending = true;
+            VerifyReg = reg;
+            VerifyVal = val & FULL_REG_MASK;
+        }
+    }
 }
 
 // Modify specified L99DZ200G Control register with specified mask and specified data (read-modify-write)
@@ -151,6 +506,8 @@ void DLK_L99DZ200G::L99DZ200G_ModifyControlRegister(uint8_t reg, uint32_t mask,
 {
     uint32_t tmp_data;
 
+    L99DZ200G_BeginSession();
+
     // read
     tmp_data = L99DZ200G_ReadRegister(reg);
 
@@ -160,6 +517,8 @@ void DLK_L99DZ200G::L99DZ200G_ModifyControlRegister(uint8_t reg, uint32_t mask,
 
     // write
     L99DZ200G_WriteControlRegister(reg, tmp_data);
+
+    L99DZ200G_EndSession();
 }
 
 // Read and clear specified bits in specified L99DZ200G register
@@ -167,11 +526,14 @@ void DLK_L99DZ200G::L99DZ200G_ReadClearRegister(uint8_t reg, uint32_t mask)
 {
     uint8_t spi_data[SPI_TRANSACTION_SIZE] = { SPI_DUMMY_BYTE };
 
-    L99DZ200G_StartSPI();
+    if (!L99DZ200G_StartSPI())
+    {
+        return;
+    }
     Uint32ToArray(mask, spi_data);
     spi_data[0] = SET_SPI_RD_CLR(reg);
     SPI_dev->transfer(spi_data, sizeof(spi_data));
-    GlobalStatusRegister = spi_data[0];
+    L99DZ200G_SetGsb(spi_data[0]);
     L99DZ200G_EndSPI();
 }
 
@@ -191,12 +553,28 @@ void DLK_L99DZ200G::L99DZ200G_Delay(uint16_t msec)
 // Check if watchdog is expired
 bool DLK_L99DZ200G::L99DZ200G_CheckWdogExpired(void)
 {
+    uint32_t late;
+
     if (TIMER_EXPIRED(WdogTick, WdogTriggerTime))
     {
+        // trigger intervals are about 3/4 of the watchdog time
+        late = millis() - WdogTick;
+        if ((EvLog != NULL) && WatchdogRunning && (late > ((WdogTriggerTime * 4) / 3)))
+        {
+            EvLog->EventLog_Add(EVLOG_WDOG_MISS, 0, late);
+        }
         WdogTick = millis();
         if (WatchdogRunning)
         {
-            L99DZ200G_WdogTrigger();
+            if ((SPI_bus != NULL) && SPI_bus->SPIBus_BusyFor(SPI_busDev))
+            {
+                // bus held by another device, trigger as soon as it is released
+                SPI_bus->SPIBus_Request(SPI_busDev, SPIBUS_PRIO_WDOG);
+            }
+            else
+            {
+                L99DZ200G_WdogTrigger();
+            }
         }
         return true;
     }
@@ -209,6 +587,8 @@ void DLK_L99DZ200G::L99DZ200G_WdogTrigger(void)
 {
     uint32_t tmp_data;
 
+    L99DZ200G_BeginSession();
+
 #ifdef WDOG_TRIGGER_CR1
     // read CR1 (optionally, could instead use CONFIG register (L99DZ200G_CFR))
     tmp_data = L99DZ200G_ReadRegister(L99DZ200G_CR1);
@@ -232,6 +612,8 @@ void DLK_L99DZ200G::L99DZ200G_WdogTrigger(void)
     // write CFR
     L99DZ200G_WriteControlRegister(L99DZ200G_CFR, tmp_data);
 #endif
+
+    L99DZ200G_EndSession();
 }
 
 // Set watchdog trigger time - CR2 (CFR)
@@ -245,21 +627,9 @@ void DLK_L99DZ200G::L99DZ200G_SetWdogTime(uint8_t ttime)
     uint32_t tmp_dataCFR;
     uint32_t tmp_dataCR2;
 
-    switch (ttime)
-    {
-        case WDOG_TIME_10MS:
-            WdogTriggerTime = 10;
-            break;
-        case WDOG_TIME_50MS:
-            WdogTriggerTime = 37;       //50;
-            break;
-        case WDOG_TIME_100MS:
-            WdogTriggerTime = 75;       //100;
-            break;
-        case WDOG_TIME_200MS:
-            WdogTriggerTime = 150;      //200;
-            break;
-    }
+    L99DZ200G_SetWdogTriggerTime(ttime);
+
+    L99DZ200G_BeginSession();
 
     // read CFR
     tmp_dataCFR = L99DZ200G_ReadRegister(L99DZ200G_CFR);
@@ -282,9 +652,41 @@ void DLK_L99DZ200G::L99DZ200G_SetWdogTime(uint8_t ttime)
     // write CR2 to modify WDOG time
     L99DZ200G_WriteControlRegister(L99DZ200G_CR2, tmp_dataCR2);
 
+    L99DZ200G_EndSession();
+
     WdogTick = millis();        // reset watchdog tick value
 }
 
+// Set the Global Status Byte of the last frame (recording a change)
+void DLK_L99DZ200G::L99DZ200G_SetGsb(uint8_t gsb)
+{
+    if ((EvLog != NULL) && (gsb != GlobalStatusRegister))
+    {
+        EvLog->EventLog_Add(EVLOG_GSB, gsb, GlobalStatusRegister);
+    }
+    GlobalStatusRegister = gsb;
+}
+
+// Set the watchdog trigger interval for the specified watchdog trigger time
+void DLK_L99DZ200G::L99DZ200G_SetWdogTriggerTime(uint8_t ttime)
+{
+    switch (ttime)
+    {
+        case WDOG_TIME_10MS:
+            WdogTriggerTime = 10;
+            break;
+        case WDOG_TIME_50MS:
+            WdogTriggerTime = 37;       //50;
+            break;
+        case WDOG_TIME_100MS:
+            WdogTriggerTime = 75;       //100;
+            break;
+        case WDOG_TIME_200MS:
+            WdogTriggerTime = 150;      //200;
+            break;
+    }
+}
+
 // Get watchdog trigger time - CR2
 uint8_t DLK_L99DZ200G::L99DZ200G_GetWdogTime(void)
 {
@@ -308,11 +710,17 @@ void DLK_L99DZ200G::L99DZ200G_ResetAllControlRegisters(void)
 {
     uint8_t spi_data[SPI_TRANSACTION_SIZE] = { SPI_DUMMY_BYTE };
 
-    L99DZ200G_StartSPI();
+    if (!L99DZ200G_StartSPI())
+    {
+        return;
+    }
     spi_data[0] = SET_SPI_DEV_INFO(L99DZ200G_CFR);
     SPI_dev->transfer(spi_data, sizeof(spi_data));
-    GlobalStatusRegister = spi_data[0];
+    L99DZ200G_SetGsb(spi_data[0]);
     L99DZ200G_EndSPI();
+
+    VerifyPending = false;      // all Control registers are now defaults
+    ShadowValid = 0;
 }
 
 // Set L99DZ200G V2 Voltage Regulator Configuration - CR1, CFR
@@ -543,6 +951,133 @@ void DLK_L99DZ200G::L99DZ200G_HeaterOutputControl(uint8_t output_type)
     L99DZ200G_HSOutputsControl(output_type, OUT_GH);
 }
 
+// Set several L99DZ200G outputs at once - CR4, CR5, CR6
+uint8_t DLK_L99DZ200G::L99DZ200G_OutputsControl(const L99DZ200GOutputSetting * settings, uint8_t count)
+{
+    uint32_t reg_mask[3] = { 0, 0, 0 };     // CR4, CR5, CR6
+    uint32_t reg_data[3] = { 0, 0, 0 };
+    uint32_t ccm_mask = 0;
+    uint32_t mask;
+    uint32_t tmp_data;
+    uint8_t output_type;
+    uint8_t pos;
+    uint8_t idx;
+
+    // combine the settings into CR4, CR5, CR6 images
+    for (uint8_t i = 0; i < count; ++i)
+    {
+        output_type = settings[i].output_type;
+
+        if (L99DZ200G_OutputField(settings[i].output, &idx, &pos) != L99DZ200G_OK)
+        {
+            return L99DZ200G_FAIL;          // invalid output
+        }
+
+        if (idx == 0)
+        {
+            // HS/LS pair: HI_OUT = HS on, LO_OUT = LS on
+            if ((output_type != OFF_OUT) && (output_type != LO_OUT) && (output_type != HI_OUT))
+            {
+                return L99DZ200G_FAIL;      // invalid output type
+            }
+            mask = 0x3UL << pos;
+            output_type >>= 4;
+        }
+        else if (settings[i].output == OUT_GH)
+        {
+            if (output_type > ON_OUT)
+            {
+                return L99DZ200G_FAIL;      // invalid output type
+            }
+            mask = CR5_GH_MASK;
+        }
+        else
+        {
+            if ((output_type > PWM7_OUT) && (output_type != DIR_OUT))
+            {
+                return L99DZ200G_FAIL;      // invalid output type
+            }
+            mask = 0xFUL << pos;
+
+            // Note: To set OUT_7, OUT_8, or OUT_9 to anything other than OFF_OUT, ON_OUT,
+            //       or DIR_OUT, the OUTn Constant Current Mode *must* be turned off!
+            //       (see 4.21) {this prevents SPI_INV_CMD error}
+            if ((output_type >= TIMER1_OUT) && (output_type <= PWM7_OUT))
+            {
+                switch (settings[i].output)
+                {
+                    case OUT_7:
+                        ccm_mask |= CR9_OUT7_CCM_EN_MASK;
+                        break;
+                    case OUT_8:
+                        ccm_mask |= CR9_OUT8_CCM_EN_MASK;
+                        break;
+                    case OUT_9:
+                        ccm_mask |= CR9_OUT9_CCM_EN_MASK;
+                        break;
+                }
+            }
+        }
+
+        reg_mask[idx] |= mask;
+        reg_data[idx] = (reg_data[idx] & ~mask) | (((uint32_t)output_type << pos) & mask);
+    }
+
+    L99DZ200G_BeginSession();
+
+    if (ccm_mask != 0)
+    {
+        L99DZ200G_ModifyControlRegister(L99DZ200G_CR9, ccm_mask, 0);   // turn CCM off
+    }
+
+    // each affected register read and written once
+    for (idx = 0; idx < 3; ++idx)
+    {
+        if (reg_mask[idx] != 0)
+        {
+            tmp_data = L99DZ200G_ReadRegister(L99DZ200G_CR4 + idx);
+            tmp_data &= ~reg_mask[idx];
+            tmp_data |= reg_data[idx];
+            L99DZ200G_WriteControlRegister(L99DZ200G_CR4 + idx, tmp_data);
+        }
+    }
+
+    L99DZ200G_EndSession();
+
+    return L99DZ200G_OK;
+}
+
+// Get L99DZ200G output control type of an output - CR4, CR5, CR6
+uint8_t DLK_L99DZ200G::L99DZ200G_GetOutputControl(uint8_t output)
+{
+    uint32_t reg_data;
+    uint8_t idx;
+    uint8_t pos;
+    uint8_t field;
+
+    if (L99DZ200G_OutputField(output, &idx, &pos) != L99DZ200G_OK)
+    {
+        return OFF_OUT;                     // invalid output
+    }
+
+    if (L99DZ200G_GetShadowRegister(L99DZ200G_CR4 + idx, &reg_data) != L99DZ200G_OK)
+    {
+        reg_data = L99DZ200G_ReadRegister(L99DZ200G_CR4 + idx);
+    }
+
+    if (idx == 0)
+    {
+        // HS/LS pair: HS on = HI_OUT, LS on = LO_OUT
+        field = (reg_data >> pos) & 0x3;
+        return (field == (HI_OUT >> 4)) ? HI_OUT : ((field == (LO_OUT >> 4)) ? LO_OUT : OFF_OUT);
+    }
+    if (output == OUT_GH)
+    {
+        return (reg_data & CR5_GH_MASK) ? ON_OUT : OFF_OUT;
+    }
+    return (reg_data >> pos) & 0xF;
+}
+
 // Set L99DZ200G PWM Channel Frequency - CR12
 void DLK_L99DZ200G::L99DZ200G_SetPWMFrequency(uint8_t pwm_chan, uint8_t pwm_freq)
 {
@@ -637,13 +1172,120 @@ void DLK_L99DZ200G::L99DZ200G_SetPWMDutyCycle(uint8_t pwm_chan, uint8_t pwm_duty
     L99DZ200G_ModifyControlRegister(reg, reg_mask, reg_data);
 }
 
-// Set Programmable timer Period and OnTime - CR2
-void DLK_L99DZ200G::L99DZ200G_SetTimerConfig(uint8_t timer, uint8_t period, uint8_t restart, uint8_t dir, uint8_t ontime)
+// Set several L99DZ200G PWM Channel Duty Cycles at once (10 bit) - CR13 to CR16
+void DLK_L99DZ200G::L99DZ200G_SetPWMDutyCycles(uint8_t chan_mask, const uint16_t * duty)
 {
-    uint32_t reg_data = 0;
+    uint8_t reg;
+    uint8_t chan;
+    uint16_t dc;
+    uint32_t reg_data;
     uint32_t reg_mask;
+    uint32_t tmp_data;
 
-    switch (timer)
+    L99DZ200G_BeginSession();
+
+    // CR13 = PWM1 (HI), PWM2 (LO) ... CR16 = PWM7 (HI)
+    for (reg = L99DZ200G_CR13; reg <= L99DZ200G_CR16; ++reg)
+    {
+        chan = (reg - L99DZ200G_CR13) * 2;      // index of the HI channel
+        reg_data = 0;
+        reg_mask = 0;
+
+        if (chan_mask & (1 << chan))
+        {
+            dc = (duty[chan] > PWM_DC_MAX) ? PWM_DC_MAX : duty[chan];
+            reg_data |= (uint32_t)dc << HI_PWM_DC_POS;
+            reg_mask |= HI_PWM_DC_MASK;
+        }
+        if ((reg != L99DZ200G_CR16) && (chan_mask & (1 << (chan + 1))))
+        {
+            dc = (duty[chan + 1] > PWM_DC_MAX) ? PWM_DC_MAX : duty[chan + 1];
+            reg_data |= (uint32_t)dc << LO_PWM_DC_POS;
+            reg_mask |= LO_PWM_DC_MASK;
+        }
+
+        if (reg_mask == 0)
+        {
+            continue;   // no channel of this register selected
+        }
+        if (reg_mask != (HI_PWM_DC_MASK | LO_PWM_DC_MASK))
+        {
+            // keep the other channel (or the unused CR16 LO field)
+            if (L99DZ200G_GetShadowRegister(reg, &tmp_data) != L99DZ200G_OK)
+            {
+                tmp_data = L99DZ200G_ReadRegister(reg);
+            }
+            reg_data |= tmp_data & FULL_REG_MASK & ~reg_mask;
+        }
+        L99DZ200G_WriteControlRegister(reg, reg_data);
+    }
+
+    L99DZ200G_EndSession();
+}
+
+// Get the 10 bit PWM duty cycle of a perceptual brightness level
+uint16_t DLK_L99DZ200G::L99DZ200G_BrightnessToDuty(uint8_t level)
+{
+    return pgm_read_word(&PWMGammaTable[level]);
+}
+
+// Get the highest PWM frequency keeping a duty cycle's on time at least PWM_MIN_ON_US
+uint8_t DLK_L99DZ200G::L99DZ200G_BrightnessFrequency(uint16_t duty)
+{
+    if (duty >= PWM_MIN_ON_DUTY(PWM_FREQ_500HZ_VAL))
+    {
+        return PWM_FREQ_500HZ;
+    }
+    if (duty >= PWM_MIN_ON_DUTY(PWM_FREQ_330HZ_VAL))
+    {
+        return PWM_FREQ_330HZ;
+    }
+    if (duty >= PWM_MIN_ON_DUTY(PWM_FREQ_200HZ_VAL))
+    {
+        return PWM_FREQ_200HZ;
+    }
+    return PWM_FREQ_100HZ;
+}
+
+// Set L99DZ200G PWM Channel perceptual brightness - CR12 to CR16
+void DLK_L99DZ200G::L99DZ200G_SetPWMBrightness(uint8_t pwm_chan, uint8_t level)
+{
+    uint8_t pwm_freq;
+    uint8_t freq_pos;
+    uint32_t reg_data;
+    uint16_t duty[PWM_CHAN7];
+
+    if ((pwm_chan < PWM_CHAN1) || (pwm_chan > PWM_CHAN7))
+    {
+        return;
+    }
+
+    duty[pwm_chan - 1] = L99DZ200G_BrightnessToDuty(level);
+    pwm_freq = L99DZ200G_BrightnessFrequency(duty[pwm_chan - 1]);
+
+    // CR12 PWM1 to PWM7 frequency fields are 2 bits apart, PWM1 highest
+    freq_pos = CR12_PWM1_FREQ_POS - ((pwm_chan - PWM_CHAN1) * 2);
+
+    L99DZ200G_BeginSession();
+
+    // only change the frequency when the level needs a different one
+    if ((L99DZ200G_GetShadowRegister(L99DZ200G_CR12, &reg_data) != L99DZ200G_OK) ||
+        (((reg_data >> freq_pos) & 0x03) != pwm_freq))
+    {
+        L99DZ200G_SetPWMFrequency(pwm_chan, pwm_freq);
+    }
+    L99DZ200G_SetPWMDutyCycles(PWM_CHAN_BIT(pwm_chan), duty);
+
+    L99DZ200G_EndSession();
+}
+
+// Set Programmable timer Period and OnTime - CR2
+void DLK_L99DZ200G::L99DZ200G_SetTimerConfig(uint8_t timer, uint8_t period, uint8_t restart, uint8_t dir, uint8_t ontime)
+{
+    uint32_t reg_data = 0;
+    uint32_t reg_mask;
+
+    switch (timer)
     {
         case TYPE_TIMER1:
             reg_mask = CR2_T1_MASK;
@@ -720,8 +1362,13 @@ void DLK_L99DZ200G::L99DZ200G_Set_ECV_DriveVoltage(float target_volts)
     uint32_t reg_data;
     uint32_t reg_mask;
 
-    // read CFR
-    reg_data = L99DZ200G_ReadRegister(L99DZ200G_CFR);
+    L99DZ200G_BeginSession();
+
+    // read CFR (shadow image if valid)
+    if (L99DZ200G_GetShadowRegister(L99DZ200G_CFR, &reg_data) != L99DZ200G_OK)
+    {
+        reg_data = L99DZ200G_ReadRegister(L99DZ200G_CFR);
+    }
     if (reg_data & CFR_ECV_HV_MASK)
     {
         vctrl_max = ECV_1_5_VOLTS;
@@ -745,6 +1392,8 @@ void DLK_L99DZ200G::L99DZ200G_Set_ECV_DriveVoltage(float target_volts)
     reg_mask = CR11_EC_VALUE_MASK;
     reg_data = (reg_data & CR11_EC_VALUE_MASK) << CR11_EC_VALUE_POS;
     L99DZ200G_ModifyControlRegister(L99DZ200G_CR11, reg_mask, reg_data);
+
+    L99DZ200G_EndSession();
 }
 
 // Switch ON/OFF the ECV fast discharge - CR11
@@ -787,8 +1436,11 @@ float DLK_L99DZ200G::L99DZ200G_Get_ECV_DriveVoltage(void)
     float drive_volts;
     uint32_t reg_data;
 
-    // read CFR
-    reg_data = L99DZ200G_ReadRegister(L99DZ200G_CFR);
+    // read CFR (shadow image if valid)
+    if (L99DZ200G_GetShadowRegister(L99DZ200G_CFR, &reg_data) != L99DZ200G_OK)
+    {
+        reg_data = L99DZ200G_ReadRegister(L99DZ200G_CFR);
+    }
     if (reg_data & CFR_ECV_HV_MASK)
     {
         vctrl_max = ECV_1_5_VOLTS;
@@ -1309,12 +1961,14 @@ float DLK_L99DZ200G::L99DZ200G_GetThermalClusterTemp(uint8_t therm_cluster)
     }
 
     // read SRx and convert to temperature
+    L99DZ200G_BeginSession();
     for (uint8_t i = 0; i < 5; ++i)
     {
         reg_data = L99DZ200G_ReadRegister(reg);
         sum += (reg_data & reg_mask) >> reg_pos;
         L99DZ200G_CheckWdogExpired();
     }
+    L99DZ200G_EndSession();
     sum /= 5;
     temp = 350.0 - (0.488 * sum);              // see datasheet: Section 4.37
 
@@ -1354,12 +2008,14 @@ float DLK_L99DZ200G::L99DZ200G_GetPinVoltage(uint8_t volt_item)
     }
 
     // read SRx and convert to averaged voltage
+    L99DZ200G_BeginSession();
     for (uint8_t i = 0; i < 5; ++i)
     {
         reg_data = L99DZ200G_ReadRegister(reg);
         sum += (reg_data & reg_mask) >> reg_pos;
         L99DZ200G_CheckWdogExpired();
     }
+    L99DZ200G_EndSession();
     sum /= 5;                       // average
     volts = VAINVS * sum / 1024;
 
@@ -1399,6 +2055,8 @@ void DLK_L99DZ200G::L99DZ200G_SetChargePumpControl(uint8_t en_dis, uint8_t ltch_
     uint32_t tmp_dataCFR;
     uint32_t tmp_dataCR22;
 
+    L99DZ200G_BeginSession();
+
     // read CFR
     tmp_dataCFR = L99DZ200G_ReadRegister(L99DZ200G_CFR);
 
@@ -1422,6 +2080,8 @@ void DLK_L99DZ200G::L99DZ200G_SetChargePumpControl(uint8_t en_dis, uint8_t ltch_
 
     // write CR22 to modify charge pump control
     L99DZ200G_WriteControlRegister(L99DZ200G_CR22, tmp_dataCR22);
+
+    L99DZ200G_EndSession();
 }
 
 // Switch ON/OFF V1 load current supervision (ICMP) control - CR22 (CFR)
@@ -1430,6 +2090,8 @@ void DLK_L99DZ200G::L99DZ200G_Set_ICMP_Control(uint8_t en_dis)
     uint32_t tmp_dataCFR;
     uint32_t tmp_dataCR22;
 
+    L99DZ200G_BeginSession();
+
     // read CFR
     tmp_dataCFR = L99DZ200G_ReadRegister(L99DZ200G_CFR);
 
@@ -1450,6 +2112,8 @@ void DLK_L99DZ200G::L99DZ200G_Set_ICMP_Control(uint8_t en_dis)
 
     // write CR22 to modify V1 load current supervision control
     L99DZ200G_WriteControlRegister(L99DZ200G_CR22, tmp_dataCR22);
+
+    L99DZ200G_EndSession();
 }
 
 // Set voltage regulator V1 reset threshold (VRTH) - CR2
@@ -3802,3 +4466,693 @@ bool DLK_L99DZ200G::L99DZ200G_WatchdogRunning(void)
     return WatchdogRunning;
 }
 
+// Retrieve the device ID of the L99DZ200G on the shared SPI bus
+uint8_t DLK_L99DZ200G::L99DZ200G_BusDevice(void)
+{
+    return SPI_busDev;
+}
+
+// Retrieve the count of L99DZ200G frames not sent because the shared SPI bus was held
+uint32_t DLK_L99DZ200G::L99DZ200G_BusErrors(void)
+{
+    return BusErrors;
+}
+
+// Retrieve the SPI clock used for L99DZ200G frames
+uint32_t DLK_L99DZ200G::L99DZ200G_GetSPIClock(void)
+{
+    return SPI_Speed;
+}
+
+// Set the fault/event log
+void DLK_L99DZ200G::L99DZ200G_SetEventLog(DLK_EventLog * event_log)
+{
+    EvLog = event_log;
+}
+
+// Set the SPI clock used for L99DZ200G frames
+void DLK_L99DZ200G::L99DZ200G_SetSPIClock(uint32_t spi_speed)
+{
+    SPISettings spi_settings(spi_speed, MSBFIRST, SPI_MODE0);
+    SPI_Settings = spi_settings;
+    SPI_Speed = spi_speed;
+
+    if (SPI_bus != NULL)
+    {
+        SPI_bus->SPIBus_SetSpeed(SPI_busDev, spi_speed);
+    }
+}
+
+// Test L99DZ200G SPI frames at the specified SPI clock - SR2, CR2 to CR16
+uint8_t DLK_L99DZ200G::L99DZ200G_TestSPIClock(uint32_t spi_speed)
+{
+    uint8_t ret = L99DZ200G_OK;
+    uint32_t good_speed = SPI_Speed;
+    uint32_t ref_data[L99DZ200G_CR16 - L99DZ200G_CR2 + 1];
+    uint32_t tmp_data;
+    uint8_t i;
+
+    if (SessionDepth != 0)
+    {
+        return L99DZ200G_FAIL;      // SPI clock can't change inside a session
+    }
+
+    // no write verification of the test frames
+    L99DZ200G_FlushVerify();
+    VerifyBusy = true;
+
+    // clear old SPI errors and get reference values at the known good SPI clock
+    L99DZ200G_ReadClearRegister(L99DZ200G_SR2, SR2_SPI_CLK_CNT | SR2_SPI_INV_CMD);
+    L99DZ200G_BeginSession();
+    for (i = 0; i < sizeof(ref_data) / sizeof(ref_data[0]); ++i)
+    {
+        ref_data[i] = L99DZ200G_ReadRegister(L99DZ200G_CR2 + i) & FULL_REG_MASK;
+    }
+    L99DZ200G_EndSession();
+
+    L99DZ200G_SetSPIClock(spi_speed);
+
+    for (uint8_t pass = 0; (pass < L99DZ200G_SPI_CAL_PASSES) && (ret == L99DZ200G_OK); ++pass)
+    {
+        if (TIMER_EXPIRED(WdogTick, WdogTriggerTime))
+        {
+            // only trigger watchdog at the known good SPI clock
+            L99DZ200G_SetSPIClock(good_speed);
+            L99DZ200G_CheckWdogExpired();
+            L99DZ200G_SetSPIClock(spi_speed);
+        }
+
+        L99DZ200G_BeginSession();
+
+        // known read patterns
+        for (i = 0; i < sizeof(ref_data) / sizeof(ref_data[0]); ++i)
+        {
+            tmp_data = L99DZ200G_ReadRegister(L99DZ200G_CR2 + i) & FULL_REG_MASK;
+            if ((tmp_data != ref_data[i]) || (GlobalStatusRegister & GSB_SPIE_MASK))
+            {
+                ret = L99DZ200G_FAIL;
+                break;
+            }
+        }
+
+        // known write patterns (only once reads are known good): rewrite the PWM duty cycle
+        // registers with their own values, so no register setting is changed
+        for (i = L99DZ200G_CR13; (i <= L99DZ200G_CR16) && (ret == L99DZ200G_OK); ++i)
+        {
+            tmp_data = ref_data[i - L99DZ200G_CR2];
+            L99DZ200G_WriteControlRegister(i, tmp_data);
+            if (((L99DZ200G_ReadRegister(i) & FULL_REG_MASK) != tmp_data) ||
+                (GlobalStatusRegister & GSB_SPIE_MASK))
+            {
+                ret = L99DZ200G_FAIL;
+            }
+        }
+
+        L99DZ200G_EndSession();
+    }
+
+    // back to the known good SPI clock, restore CR13 to CR16 (in case a write frame was corrupted)
+    // and check for SPI errors flagged by the L99DZ200G
+    L99DZ200G_SetSPIClock(good_speed);
+    L99DZ200G_BeginSession();
+    for (i = L99DZ200G_CR13; i <= L99DZ200G_CR16; ++i)
+    {
+        L99DZ200G_WriteControlRegister(i, ref_data[i - L99DZ200G_CR2]);
+    }
+    L99DZ200G_EndSession();
+    VerifyBusy = false;
+    tmp_data = L99DZ200G_ReadRegister(L99DZ200G_SR2);
+    if ((tmp_data & (SR2_SPI_CLK_CNT | SR2_SPI_INV_CMD)) || (GlobalStatusRegister & GSB_SPIE_MASK))
+    {
+        ret = L99DZ200G_FAIL;
+        L99DZ200G_ReadClearRegister(L99DZ200G_SR2, SR2_SPI_CLK_CNT | SR2_SPI_INV_CMD);
+    }
+    L99DZ200G_CheckWdogExpired();
+
+    return ret;
+}
+
+// Find and select the fastest reliable SPI clock - SR2, CR2 to CR16
+uint32_t DLK_L99DZ200G::L99DZ200G_CalibrateSPIClock(uint32_t max_speed)
+{
+    uint8_t step;
+    uint8_t passed = 0;         // number of clock steps that passed
+    uint32_t spi_speed;
+
+    for (step = 0; step < SPI_CLOCK_STEPS; ++step)
+    {
+        spi_speed = pgm_read_dword(&SPIClockSteps[step]);
+        if ((spi_speed > max_speed) || (L99DZ200G_TestSPIClock(spi_speed) != L99DZ200G_OK))
+        {
+            break;
+        }
+        passed = step + 1;
+    }
+
+    if (passed == 0)
+    {
+        return 0;               // no reliable clock, leave SPI clock unchanged
+    }
+
+    // back off from the fastest passing clock by the safety margin
+    step = (passed > L99DZ200G_SPI_CAL_MARGIN) ? (passed - 1 - L99DZ200G_SPI_CAL_MARGIN) : 0;
+    spi_speed = pgm_read_dword(&SPIClockSteps[step]);
+    L99DZ200G_SetSPIClock(spi_speed);
+
+    return spi_speed;
+}
+
+// Set the Control register write verification policy
+void DLK_L99DZ200G::L99DZ200G_SetVerifyPolicy(uint8_t policy, uint8_t nth, uint8_t retries)
+{
+    L99DZ200G_FlushVerify();
+
+    VerifyPolicy = policy;
+    VerifyNth = (nth != 0) ? nth : 1;
+    VerifyRetries = retries;
+    VerifyWriteCnt = 0;
+}
+
+// Retrieve the Control register write verification policy
+uint8_t DLK_L99DZ200G::L99DZ200G_GetVerifyPolicy(void)
+{
+    return VerifyPolicy;
+}
+
+// Verify a pending Control register write now
+uint8_t DLK_L99DZ200G::L99DZ200G_FlushVerify(void)
+{
+    uint32_t reg_data;
+
+    if (!VerifyPending)
+    {
+        return L99DZ200G_OK;
+    }
+
+    VerifyBusy = true;
+    reg_data = L99DZ200G_ReadRegister(VerifyReg);
+    VerifyBusy = false;
+    L99DZ200G_VerifyCheck(reg_data, false, VerifyRetries);
+
+    return VerifyResult;
+}
+
+// Get the Control register write verification statistics
+void DLK_L99DZ200G::L99DZ200G_GetVerifyStats(L99DZ200GVerifyStats * stats)
+{
+    *stats = VerifyStats;
+}
+
+// Clear the Control register write verification statistics
+void DLK_L99DZ200G::L99DZ200G_ClearVerifyStats(void)
+{
+    memset(&VerifyStats, 0, sizeof(VerifyStats));
+}
+
+// Retrieve the shadow image of a Control register
+uint8_t DLK_L99DZ200G::L99DZ200G_GetShadowRegister(uint8_t reg, uint32_t * val)
+{
+    int8_t idx = L99DZ200G_ShadowIndex(reg);
+
+    if ((idx < 0) || !(ShadowValid & (1UL << idx)))
+    {
+        return L99DZ200G_FAIL;
+    }
+
+    *val = Shadow[idx];
+    return L99DZ200G_OK;
+}
+
+// Forget all Control register shadow images
+void DLK_L99DZ200G::L99DZ200G_InvalidateShadow(void)
+{
+    ShadowValid = 0;
+}
+
+// Scrub Control registers against their shadow images - CR1 to CR22, CFR
+uint8_t DLK_L99DZ200G::L99DZ200G_ScrubTick(uint16_t budget_us)
+{
+    uint32_t start_time = micros();
+    uint8_t repaired = 0;
+    uint8_t checked = 0;
+    uint8_t valid_cnt = 0;
+    uint8_t reg;
+    uint32_t mask;
+    uint32_t reg_data;
+    uint32_t diff;
+    uint32_t unlock;
+
+    for (uint8_t i = 0; i < L99DZ200G_SHADOW_REGS; ++i)
+    {
+        if (ShadowValid & (1UL << i))
+        {
+            ++valid_cnt;
+        }
+    }
+    if (valid_cnt == 0)
+    {
+        return 0;               // nothing written yet
+    }
+
+    L99DZ200G_BeginSession();
+
+    do
+    {
+        // next shadowed Control register
+        while (!(ShadowValid & (1UL << ScrubIndex)))
+        {
+            if (++ScrubIndex >= L99DZ200G_SHADOW_REGS)
+            {
+                ScrubIndex = 0;
+                ++ScrubStats.passes;
+            }
+        }
+
+        reg = L99DZ200G_ShadowReg(ScrubIndex);
+        mask = L99DZ200G_ScrubMask(reg);
+        reg_data = L99DZ200G_ReadRegister(reg) & FULL_REG_MASK;
+        ++ScrubStats.checked;
+
+        diff = (reg_data ^ Shadow[ScrubIndex]) & mask;
+        if (diff)
+        {
+            // the watchdog time and CR22 bits need the CFR configuration enable first
+            unlock = L99DZ200G_CfgEnableMask(reg, diff);
+            if (unlock)
+            {
+                L99DZ200G_WriteControlRegister(L99DZ200G_CFR,
+                                               (L99DZ200G_ReadRegister(L99DZ200G_CFR) & FULL_REG_MASK) | unlock);
+            }
+
+            L99DZ200G_WriteControlRegister(reg, (reg_data & ~mask) | (Shadow[ScrubIndex] & mask));
+            ++ScrubStats.repaired;
+            ++repaired;
+        }
+
+        if (++ScrubIndex >= L99DZ200G_SHADOW_REGS)
+        {
+            ScrubIndex = 0;
+            ++ScrubStats.passes;
+        }
+        ++checked;
+    } while ((checked < valid_cnt) && ((budget_us == 0) || ((micros() - start_time) < budget_us)));
+
+    L99DZ200G_EndSession();
+
+    return repaired;
+}
+
+// Get the Control register scrubber statistics
+void DLK_L99DZ200G::L99DZ200G_GetScrubStats(L99DZ200GScrubStats * stats)
+{
+    *stats = ScrubStats;
+}
+
+// Clear the Control register scrubber statistics
+void DLK_L99DZ200G::L99DZ200G_ClearScrubStats(void)
+{
+    memset(&ScrubStats, 0, sizeof(ScrubStats));
+}
+
+// Get the Control register (CR4 + idx) and field position of an output
+uint8_t DLK_L99DZ200G::L99DZ200G_OutputField(uint8_t output, uint8_t * idx, uint8_t * pos)
+{
+    switch (output)
+    {
+        case OUT_1:
+            *pos = CR4_LS_OUT1_POS;
+            *idx = 0;
+            break;
+        case OUT_2:
+            *pos = CR4_LS_OUT2_POS;
+            *idx = 0;
+            break;
+        case OUT_3:
+            *pos = CR4_LS_OUT3_POS;
+            *idx = 0;
+            break;
+        case OUT_6:
+            *pos = CR4_LS_OUT6_POS;
+            *idx = 0;
+            break;
+        case OUT_7:
+            *pos = CR5_HS_OUT7_POS;
+            *idx = 1;
+            break;
+        case OUT_8:
+            *pos = CR5_HS_OUT8_POS;
+            *idx = 1;
+            break;
+        case OUT_10:
+            *pos = CR5_HS_OUT10_POS;
+            *idx = 1;
+            break;
+        case OUT_GH:
+            *pos = CR5_GH_POS;
+            *idx = 1;
+            break;
+        case OUT_9:
+            *pos = CR6_HS_OUT9_POS;
+            *idx = 2;
+            break;
+        case OUT_13:
+            *pos = CR6_HS_OUT13_POS;
+            *idx = 2;
+            break;
+        case OUT_14:
+            *pos = CR6_HS_OUT14_POS;
+            *idx = 2;
+            break;
+        case OUT_15:
+            *pos = CR6_HS_OUT15_POS;
+            *idx = 2;
+            break;
+
+        default:
+            return L99DZ200G_FAIL;          // invalid output
+    }
+    return L99DZ200G_OK;
+}
+
+// Get the shadow index of a Control register (-1 = not shadowed)
+int8_t DLK_L99DZ200G::L99DZ200G_ShadowIndex(uint8_t reg)
+{
+    if ((reg >= L99DZ200G_CR1) && (reg <= L99DZ200G_CR22))
+    {
+        return reg - L99DZ200G_CR1;
+    }
+    else if (reg == L99DZ200G_CFR)
+    {
+        return L99DZ200G_SHADOW_REGS - 1;
+    }
+    return -1;
+}
+
+// Get the Control register of a shadow index
+uint8_t DLK_L99DZ200G::L99DZ200G_ShadowReg(uint8_t idx)
+{
+    return (idx == L99DZ200G_SHADOW_REGS - 1) ? L99DZ200G_CFR : (L99DZ200G_CR1 + idx);
+}
+
+// Get the Control register bits compared/repaired by the scrubber
+uint32_t DLK_L99DZ200G::L99DZ200G_ScrubMask(uint8_t reg)
+{
+    switch (reg)
+    {
+        case L99DZ200G_CR1:
+            // standby request and watchdog trigger (a rewrite would be a trigger)
+            return FULL_REG_MASK & ~(CR1_STBY_MASK | CR1_TRIG_MASK);
+        case L99DZ200G_CR2:
+            // timer restart requests
+            return FULL_REG_MASK & ~(CR2_T1_RESTART_MASK | CR2_T2_RESTART_MASK);
+        case L99DZ200G_CFR:
+            // configuration enables and watchdog trigger (a rewrite would be a trigger)
+            return FULL_REG_MASK & ~(CFR_WD_CFG_EN_MASK | CFR_ICMP_CFG_EN_MASK | CFR_CP_OFF_EN_MASK | CFR_WDC_MASK);
+        default:
+            return FULL_REG_MASK;
+    }
+}
+
+// Get the CFR configuration enable bits needed to change the specified Control register bits
+uint32_t DLK_L99DZ200G::L99DZ200G_CfgEnableMask(uint8_t reg, uint32_t diff)
+{
+    uint32_t unlock = 0;
+
+    if ((reg == L99DZ200G_CR2) && (diff & CR2_WD_TIME_MASK))
+    {
+        unlock |= CFR_WD_CFG_EN_MASK;
+    }
+    else if (reg == L99DZ200G_CR22)
+    {
+        if (diff & CR22_CP_OFF_MASK)
+        {
+            unlock |= CFR_CP_OFF_EN_MASK;
+        }
+        if (diff & CR22_ICMP_MASK)
+        {
+            unlock |= CFR_ICMP_CFG_EN_MASK;
+        }
+    }
+    return unlock;
+}
+
+// Apply a configuration profile, writing only the Control registers that differ - CR1 to CR22, CFR
+uint8_t DLK_L99DZ200G::L99DZ200G_ApplyProfile(const L99DZ200GProfile * profile, bool read_device)
+{
+    uint32_t cur_data[L99DZ200G_SHADOW_REGS];
+    uint32_t new_data[L99DZ200G_SHADOW_REGS];
+    L99DZ200GProfileReg entry;
+    uint32_t unlock = 0;
+    uint32_t tmp_data;
+    uint8_t writes = 0;
+    uint8_t reg;
+    uint8_t i;
+    uint8_t n;
+    const uint8_t cfr_idx = L99DZ200G_SHADOW_REGS - 1;
+
+    L99DZ200G_BeginSession();
+
+    // get current and profile Control register values
+    for (i = 0; i < L99DZ200G_SHADOW_REGS; ++i)
+    {
+        reg = L99DZ200G_ShadowReg(i);
+        memcpy_P(&entry, &profile->reg[i], sizeof(entry));
+        entry.mask &= L99DZ200G_ScrubMask(reg);
+
+        if (!read_device && (ShadowValid & (1UL << i)))
+        {
+            cur_data[i] = Shadow[i];
+        }
+        else if ((entry.mask != 0) || (i == cfr_idx))
+        {
+            // (CFR is always needed, it may have configuration enables to set)
+            cur_data[i] = L99DZ200G_ReadRegister(reg) & FULL_REG_MASK;
+        }
+        else
+        {
+            cur_data[i] = 0;        // not in profile, never written
+        }
+        new_data[i] = (cur_data[i] & ~entry.mask) | (entry.data & entry.mask);
+
+        if (i != cfr_idx)
+        {
+            unlock |= L99DZ200G_CfgEnableMask(reg, cur_data[i] ^ new_data[i]);
+        }
+    }
+
+    // switch off the OUTn fields that change (CR4 to CR6 fields are 4 bit aligned)
+    for (reg = L99DZ200G_CR4; reg <= L99DZ200G_CR6; ++reg)
+    {
+        i = L99DZ200G_ShadowIndex(reg);
+        tmp_data = cur_data[i];
+        for (n = 0; n < 24; n += 4)
+        {
+            if ((cur_data[i] ^ new_data[i]) & (0xFUL << n))
+            {
+                tmp_data &= ~(0xFUL << n);
+            }
+        }
+        if (tmp_data != cur_data[i])
+        {
+            L99DZ200G_WriteControlRegister(reg, tmp_data);
+            cur_data[i] = tmp_data;
+            ++writes;
+        }
+    }
+
+    // configuration (with any configuration enables needed for CR2, CR22)
+    if ((new_data[cfr_idx] != cur_data[cfr_idx]) || unlock)
+    {
+        L99DZ200G_WriteControlRegister(L99DZ200G_CFR, new_data[cfr_idx] | unlock);
+        ++writes;
+    }
+
+    // CR1 to CR3, CR7 to CR22
+    for (i = 0; i < cfr_idx; ++i)
+    {
+        reg = L99DZ200G_ShadowReg(i);
+        if (((reg >= L99DZ200G_CR4) && (reg <= L99DZ200G_CR6)) || (new_data[i] == cur_data[i]))
+        {
+            continue;
+        }
+        L99DZ200G_WriteControlRegister(reg, new_data[i]);
+        ++writes;
+
+        if ((reg == L99DZ200G_CR2) && ((new_data[i] ^ cur_data[i]) & CR2_WD_TIME_MASK))
+        {
+            L99DZ200G_SetWdogTriggerTime((new_data[i] & CR2_WD_TIME_MASK) >> CR2_WD_TIME_POS);
+            WdogTick = millis();        // reset watchdog tick value
+        }
+    }
+
+    // outputs last, with their configuration in place
+    for (reg = L99DZ200G_CR4; reg <= L99DZ200G_CR6; ++reg)
+    {
+        i = L99DZ200G_ShadowIndex(reg);
+        if (new_data[i] != cur_data[i])
+        {
+            L99DZ200G_WriteControlRegister(reg, new_data[i]);
+            ++writes;
+        }
+    }
+
+    L99DZ200G_EndSession();
+
+    return writes;
+}
+
+// Attach to an L99DZ200G that kept running while the MCU restarted
+uint8_t DLK_L99DZ200G::L99DZ200G_WarmAttach(const L99DZ200GProfile * profile)
+{
+    L99DZ200GProfileReg entry;
+    uint16_t dev_crc = 0xFFFF;
+    uint16_t prof_crc = 0xFFFF;
+    uint8_t gsb = 0;
+    uint8_t reg;
+    uint8_t i;
+
+    // only the SPI interface is set up, the L99DZ200G gets no frames until its registers are read
+    if (L99DZ200G_SetupSPI() != L99DZ200G_OK)
+    {
+        return L99DZ200G_FAIL;
+    }
+
+    L99DZ200G_BeginSession();
+
+    // read all Control registers once, checksum the profile fields of each
+    for (i = 0; i < L99DZ200G_SHADOW_REGS; ++i)
+    {
+        reg = L99DZ200G_ShadowReg(i);
+        Shadow[i] = L99DZ200G_ReadRegister(reg) & FULL_REG_MASK;
+        gsb |= GlobalStatusRegister;
+
+        memcpy_P(&entry, &profile->reg[i], sizeof(entry));
+        entry.mask &= L99DZ200G_ScrubMask(reg);
+        dev_crc = L99DZ200G_ChecksumUpdate(dev_crc, Shadow[i] & entry.mask);
+        prof_crc = L99DZ200G_ChecksumUpdate(prof_crc, entry.data & entry.mask);
+    }
+
+    // was reset (or watchdog failed) since initialized, or in fail safe
+    if ((gsb & (GSB_RSTB_MASK | GSB_FS_MASK)) || (dev_crc != prof_crc))
+    {
+        L99DZ200G_EndSession();
+        ShadowValid = 0;
+        return L99DZ200G_FAIL;
+    }
+    ShadowValid = (1UL << L99DZ200G_SHADOW_REGS) - 1;
+
+    // resume watchdog servicing at the running watchdog time
+    L99DZ200G_SetWdogTriggerTime((Shadow[L99DZ200G_ShadowIndex(L99DZ200G_CR2)] & CR2_WD_TIME_MASK) >> CR2_WD_TIME_POS);
+    L99DZ200G_WdogTrigger();
+    WdogTick = millis();        // reset watchdog tick value
+    WatchdogRunning = true;
+
+    L99DZ200G_EndSession();
+
+    return L99DZ200G_OK;
+}
+
+// Add a 24 bit register value to a CRC-16 (CCITT) checksum
+uint16_t DLK_L99DZ200G::L99DZ200G_ChecksumUpdate(uint16_t crc, uint32_t val)
+{
+    for (int8_t n = 16; n >= 0; n -= 8)
+    {
+        crc ^= (uint16_t)((val >> n) & 0xFF) << 8;
+        for (uint8_t bit = 0; bit < 8; ++bit)
+        {
+            crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+// Check if a write to the specified Control register is to be verified
+bool DLK_L99DZ200G::L99DZ200G_VerifySelect(uint8_t reg)
+{
+    switch (VerifyPolicy)
+    {
+        case L99DZ200G_VERIFY_ALWAYS:
+            return true;
+
+        case L99DZ200G_VERIFY_EVERY_NTH:
+            if (++VerifyWriteCnt >= VerifyNth)
+            {
+                VerifyWriteCnt = 0;
+                return true;
+            }
+            return false;
+
+        case L99DZ200G_VERIFY_CRITICAL:
+            return (reg == L99DZ200G_CR1) || (reg == L99DZ200G_CR2) ||
+                   (reg == L99DZ200G_CR4) || (reg == L99DZ200G_CFR);
+
+        default:
+            return false;
+    }
+}
+
+// Compare a register response with the pending verification value (rewrite if mismatched)
+//  Only the bits that read back are compared (see L99DZ200G_ScrubMask()).
+void DLK_L99DZ200G::L99DZ200G_VerifyCheck(uint32_t reg_data, bool piggybacked, uint8_t retries)
+{
+    uint32_t mask = L99DZ200G_ScrubMask(VerifyReg);
+
+    VerifyPending = false;
+    ++VerifyStats.verified;
+    if (piggybacked)
+    {
+        ++VerifyStats.piggybacked;
+    }
+
+    if (((reg_data ^ VerifyVal) & mask) == 0)
+    {
+        VerifyResult = L99DZ200G_OK;
+        return;
+    }
+
+    ++VerifyStats.mismatches;
+    VerifyResult = L99DZ200G_FAIL;
+
+    VerifyBusy = true;
+    while (retries-- > 0)
+    {
+        ++VerifyStats.retries;
+        L99DZ200G_WriteControlRegister(VerifyReg, VerifyVal);
+        if (((L99DZ200G_ReadRegister(VerifyReg) ^ VerifyVal) & mask) == 0)
+        {
+            VerifyResult = L99DZ200G_OK;
+            break;
+        }
+    }
+    VerifyBusy = false;
+
+    if (VerifyResult != L99DZ200G_OK)
+    {
+        ++VerifyStats.failures;
+    }
+}
+
+// Shared SPI bus deferred watchdog trigger
+void DLK_L99DZ200G::L99DZ200G_BusWdogTrigger(void * arg)
+{
+    DLK_L99DZ200G * dev = (DLK_L99DZ200G *)arg;
+
+    if (dev->WatchdogRunning)
+    {
+        dev->L99DZ200G_WdogTrigger();
+    }
+}
+
+// DLK_L99DZ200G_Session Class members
+
+// Constructor - begin L99DZ200G SPI session
+DLK_L99DZ200G_Session::DLK_L99DZ200G_Session(DLK_L99DZ200G & dev) : Dev(dev)
+{
+    Dev.L99DZ200G_BeginSession();
+}
+
+// Destructor - end L99DZ200G SPI session
+DLK_L99DZ200G_Session::~DLK_L99DZ200G_Session(void)
+{
+    Dev.L99DZ200G_EndSession();
+}
@@ -19,12 +19,102 @@
 
 #include "Arduino.h"
 #include "L99DZ200G.h"
+#include "DLK_SPIBus.h"
+#include "DLK_EventLog.h"
 
 #define TIMER_EXPIRED(start, interval)  ((millis() - start) >= interval)
 
 #define SPI_DUMMY_BYTE  0x00
 #define FRAME_CNT       4
 
+#define L99DZ200G_SPI_MAX_CLOCK     4000000     // L99DZ200G maximum SPI clock (bps)
+#define L99DZ200G_CSN_HIGH_US       6           // L99DZ200G minimum CSN high time between frames (uS)
+
+#define L99DZ200G_SPI_CAL_PASSES    8           // SPI clock calibration test passes per clock step
+#define L99DZ200G_SPI_CAL_MARGIN    1           // SPI clock calibration steps backed off from fastest passing clock
+
+// Control register write verification policies
+#define L99DZ200G_VERIFY_NEVER      0           // no write verification
+#define L99DZ200G_VERIFY_ALWAYS     1           // verify every write
+#define L99DZ200G_VERIFY_EVERY_NTH  2           // verify every Nth write
+#define L99DZ200G_VERIFY_CRITICAL   3           // verify writes to CR1, CR2, CR4, CFR only
+
+/**
+ * L99DZ200G Control register write verification statistics.
+ */
+typedef struct
+{
+    uint32_t writes;            ///< Control register writes
+    uint32_t verified;          ///< writes verified
+    uint32_t piggybacked;       ///< writes verified from a later frame's response (no extra frame)
+    uint32_t mismatches;        ///< verified writes that did not read back as written
+    uint32_t retries;           ///< rewrites after a mismatch
+    uint32_t failures;          ///< mismatches still not as written after all retries
+} L99DZ200GVerifyStats;
+
+/**
+ * L99DZ200G output setting for a multi-output update (L99DZ200G_OutputsControl()).
+ */
+typedef struct
+{
+    uint8_t output;             ///< the output: (OUT_1, OUT_2, OUT_3, OUT_6, OUT_7, OUT_8, OUT_9,
+                                ///<              OUT_10, OUT_13, OUT_14, OUT_15, OUT_GH)
+    uint8_t output_type;        ///< the output control type: OUT_1 to OUT_6: (OFF_OUT, LO_OUT, HI_OUT),
+                                ///<  others: as for L99DZ200G_HSOutputsControl()
+} L99DZ200GOutputSetting;
+
+/**
+ * L99DZ200G device information (Device Information Registers ROM contents).
+ */
+typedef struct
+{
+    bool valid;                 ///< true = read from the L99DZ200G
+    uint8_t id_header;          ///< ID header (ROM 0x00)
+    uint8_t version;            ///< version (ROM 0x01)
+    uint16_t product_code;      ///< product code 1 (MSB), product code 2 (LSB) (ROM 0x02, 0x03)
+    uint8_t silicon_version;    ///< silicon version (ROM 0x0a)
+    uint8_t spi_frame_id;       ///< SPI frame ID - SPI frame capabilities (ROM 0x10)
+    uint16_t wd_type;           ///< watchdog type 1 (MSB), watchdog type 2 (LSB) (ROM 0x11, 0x12)
+    uint16_t wd_bit_pos;        ///< watchdog bit position 1 (MSB), 2 (LSB) (ROM 0x13, 0x14)
+    uint8_t rom[ROM_SIZE];      ///< the Device Information Registers ROM by address (0x00 to 0x14),
+                                ///<  only the ROM_xxx addresses above are read (others 0)
+} L99DZ200GDeviceInfo;
+
+#define L99DZ200G_SHADOW_REGS       23          // shadowed Control registers: CR1 to CR22, CFR
+
+/**
+ * L99DZ200G Control register scrubber statistics.
+ */
+typedef struct
+{
+    uint32_t checked;           ///< Control registers compared with their shadow images
+    uint32_t repaired;          ///< Control registers rewritten because they differed
+    uint32_t passes;            ///< complete passes through the shadowed Control registers
+} L99DZ200GScrubStats;
+
+/**
+ * L99DZ200G configuration profile entry for one Control register.
+ */
+typedef struct
+{
+    uint32_t mask;              ///< the Control register bits set by the profile (0 = register not in profile)
+    uint32_t data;              ///< the profile values of those bits
+} L99DZ200GProfileReg;
+
+/**
+ * L99DZ200G configuration profile (placed in PROGMEM). One entry for each of
+ * CR1 to CR22 (in order), then CFR.
+ */
+typedef struct
+{
+    L99DZ200GProfileReg reg[L99DZ200G_SHADOW_REGS];
+} L99DZ200GProfile;
+
+// build a configuration profile field value from an unshifted value
+#define L99DZ200G_PROFILE_FIELD(val, mask, pos)     (((uint32_t)(val) << (pos)) & (mask))
+// configuration profile entry for a Control register not in the profile
+#define L99DZ200G_PROFILE_NONE                      { 0, 0 }
+
 /**
  * DLK_L99DZ200G Arduino L99DZ200G driver library class. Version: "V1.0.2 12/29/2023"
  */
@@ -42,6 +132,18 @@ class DLK_L99DZ200G
          */
         DLK_L99DZ200G(uint32_t spi_speed, uint8_t cs_pin);
 
+        /**
+         *  A constructor that sets up the DLK_L99DZ200G L99DZ200G driver processing code
+         *  on a shared SPI bus.
+         *
+         *  \param spi_bus: the shared SPI bus arbiter the L99DZ200G device is on
+         *  \param spi_speed: the speed (bps) of the SPI interface to the L99DZ200G device
+         *  \param cs_pin: the chip select Arduino pin (~CS) of the SPI interface to the L99DZ200G device
+         *
+         *  \return None.
+         */
+        DLK_L99DZ200G(DLK_SPIBus & spi_bus, uint32_t spi_speed, uint8_t cs_pin);
+
         /**
          * Initialize L99DZ200G.
          *
@@ -50,15 +152,50 @@ class DLK_L99DZ200G
          */
         uint8_t L99DZ200G_Init(void);
 
+        /**
+         * Begin a L99DZ200G SPI session. The SPI bus is set up once and held for all
+         * following L99DZ200G frames until the session is ended; each frame then only
+         * toggles the chip select. Sessions may be nested.
+         *
+         *  \return None.
+         */
+        void L99DZ200G_BeginSession(void);
+
+        /**
+         * End a L99DZ200G SPI session started with L99DZ200G_BeginSession().
+         *
+         *  \return None.
+         */
+        void L99DZ200G_EndSession(void);
+
         /**
          * Read from specified L99DZ200G ROM address.
          *
-         * \param addr: the L99DZ200G ROM address (0x00 to 0x3f) to read from
+         * \param addr: the L99DZ200G ROM address (0x00 to 0x3e) to read from
          *
-         * \return   uint8_t = L99DZ200G ROM adddress value
+         * \return   uint8_t = L99DZ200G ROM adddress value, 0 = address 0x3f (that frame resets
+         *                    all Control registers, it is not sent)
          */
         uint8_t L99DZ200G_ReadRomAddress(uint8_t addr);
 
+        /**
+         * Read the L99DZ200G Device Information Registers ROM addresses (ROM_ID_HEADER to
+         * ROM_WD_BIT_POS_2) in one SPI session into the cached device information (also done
+         * by L99DZ200G_Init()).
+         *
+         * \return   L99DZ200G_OK = device information read
+         * \return   L99DZ200G_FAIL = no L99DZ200G responding (all ROM bytes 0x00 or 0xff)
+         */
+        uint8_t L99DZ200G_ReadDeviceInfo(void);
+
+        /**
+         * Get the cached L99DZ200G device information (no SPI transfers).
+         *
+         * \return   const L99DZ200GDeviceInfo * = the cached device information
+         *           (valid member false = not read from the L99DZ200G)
+         */
+        const L99DZ200GDeviceInfo * L99DZ200G_GetDeviceInfo(void);
+
         /**
          * Read from specified L99DZ200G register.
          *
@@ -214,6 +351,36 @@ class DLK_L99DZ200G
          */
         void L99DZ200G_HSOutputsControl(uint8_t output_type, uint8_t output);
 
+        /**
+         * Set several L99DZ200G outputs at once - CR4, CR5, CR6.
+         *
+         * The settings are combined so each affected Control register is read and written
+         * only once, and all the outputs in the same register switch in the same SPI frame.
+         * (OUT_7, OUT_8 or OUT_9 set to a timer or PWM type first have their Constant
+         * Current Mode turned off, with a single CR9 write.)
+         *
+         * \param settings: the (output, output type) settings
+         * \param count: the number of settings
+         *
+         * \return   L99DZ200G_OK = the outputs were set
+         * \return   L99DZ200G_FAIL = an invalid output or output type (nothing written)
+         */
+        uint8_t L99DZ200G_OutputsControl(const L99DZ200GOutputSetting * settings, uint8_t count);
+
+        /**
+         * Get the L99DZ200G output control type of an output - CR4, CR5, CR6.
+         *
+         * Taken from the Control register shadow image (read from the L99DZ200G if not valid).
+         *
+         * \param output: the output:
+         *                (OUT_1, OUT_2, OUT_3, OUT_6, OUT_7, OUT_8, OUT_9,
+         *                 OUT_10, OUT_13, OUT_14, OUT_15, OUT_GH)
+         *
+         * \return   uint8_t = the output control type (as for L99DZ200G_OutputsControl())
+         *                     {OFF_OUT for an invalid output}
+         */
+        uint8_t L99DZ200G_GetOutputControl(uint8_t output);
+
         /**
          * Set L99DZ200G Heater Output Control - CR5.
          *
@@ -246,6 +413,58 @@ class DLK_L99DZ200G
          */
         void L99DZ200G_SetPWMDutyCycle(uint8_t pwm_chan, uint8_t pwm_duty);
 
+        /**
+         * Set several L99DZ200G PWM Channel Duty Cycles at once (10 bit) - CR13 to CR16.
+         *
+         * Each of CR13 to CR16 holding a selected channel is written once. The other channel
+         * of a register is kept from its shadow image (read from the L99DZ200G if not valid).
+         *
+         * \param chan_mask: the PWM channels to set: PWM_CHAN_BIT(PWM_CHAN1) to
+         *                   PWM_CHAN_BIT(PWM_CHAN7) or'ed together, or PWM_CHAN_ALL
+         * \param duty: the raw duty cycles of PWM_CHAN1 to PWM_CHAN7 (duty[0] to duty[6]):
+         *              (0 to PWM_DC_MAX) {only the selected channels are used}
+         *
+         *  \return None.
+         */
+        void L99DZ200G_SetPWMDutyCycles(uint8_t chan_mask, const uint16_t * duty);
+
+        /**
+         * Set L99DZ200G PWM Channel perceptual brightness - CR12 to CR16.
+         *
+         * The level is converted to a 10 bit duty cycle through a CIE 1931 lightness gamma
+         * table (no run-time math), so equal level steps look like equal brightness steps.
+         * The channel frequency is set to the highest one that keeps the lamp on time at
+         * least PWM_MIN_ON_US (low levels run at lower frequencies so their few duty cycle
+         * steps are not lost in the output switching times). CR12 is only written when the
+         * frequency changes.
+         *
+         * \param pwm_chan: the PWM channel:
+         *              (PWM_CHAN1, PWM_CHAN2, PWM_CHAN3, PWM_CHAN4, PWM_CHAN5, PWM_CHAN6, PWM_CHAN7)
+         * \param level: the perceptual brightness level: (0 to PWM_LEVEL_MAX)
+         *
+         *  \return None.
+         */
+        void L99DZ200G_SetPWMBrightness(uint8_t pwm_chan, uint8_t level);
+
+        /**
+         * Get the 10 bit PWM duty cycle of a perceptual brightness level (gamma table).
+         *
+         * \param level: the perceptual brightness level: (0 to PWM_LEVEL_MAX)
+         *
+         * \return   uint16_t = the raw PWM duty cycle: (0 to PWM_DC_MAX)
+         */
+        static uint16_t L99DZ200G_BrightnessToDuty(uint8_t level);
+
+        /**
+         * Get the PWM frequency L99DZ200G_SetPWMBrightness() uses for a duty cycle.
+         *
+         * \param duty: the raw PWM duty cycle: (0 to PWM_DC_MAX)
+         *
+         * \return   uint8_t = the PWM frequency:
+         *              (PWM_FREQ_100HZ, PWM_FREQ_200HZ, PWM_FREQ_330HZ, PWM_FREQ_500HZ)
+         */
+        static uint8_t L99DZ200G_BrightnessFrequency(uint16_t duty);
+
         /**
          * Set Programmable timer Period and OnTime - CR2.
          *
@@ -1437,19 +1656,257 @@ class DLK_L99DZ200G
          */
         bool L99DZ200G_WatchdogRunning(void);
 
+        /**
+         * Retrieve the device ID of the L99DZ200G on the shared SPI bus.
+         *
+         * @return uint8_t  the shared SPI bus device ID, SPIBUS_NO_DEVICE = not on a shared SPI bus
+         */
+        uint8_t L99DZ200G_BusDevice(void);
+
+        /**
+         * Retrieve the count of L99DZ200G frames not sent because another device held the
+         * shared SPI bus (the frame is skipped: a read returns 0, a write is not applied).
+         *
+         * @return uint32_t  the count of frames not sent
+         */
+        uint32_t L99DZ200G_BusErrors(void);
+
+        /**
+         * Retrieve the SPI clock used for L99DZ200G frames.
+         *
+         * @return uint32_t  the SPI clock (bps)
+         */
+        uint32_t L99DZ200G_GetSPIClock(void);
+
+        /**
+         * Set the fault/event log the driver records GSB changes, SR1 to SR6 changes, Control
+         * register writes and watchdog trigger misses to.
+         *
+         * \param event_log: the event log, NULL = no event recording
+         *
+         *  \return None.
+         */
+        void L99DZ200G_SetEventLog(DLK_EventLog * event_log);
+
+        /**
+         * Set the SPI clock used for L99DZ200G frames.
+         *
+         * \param spi_speed: the SPI clock (bps)
+         *
+         *  \return None.
+         *
+         *  \note Takes effect at the start of the next SPI session (not inside a session).
+         */
+        void L99DZ200G_SetSPIClock(uint32_t spi_speed);
+
+        /**
+         * Test L99DZ200G SPI frames at the specified SPI clock - SR2, CR2 to CR16.
+         *
+         * Reference values of CR2 to CR16 are read at the current SPI clock, then each test
+         * pass re-reads them at the test clock, and rewrites the PWM duty cycle registers CR13
+         * to CR16 with their own values and reads them back (no register setting is changed,
+         * no register bits are used as scratch). Any mismatch, GSB SPI error, or SR2
+         * SPI_CLK_CNT or SPI_INV_CMD flag fails the test. The current SPI clock and CR13 to
+         * CR16 are restored afterwards.
+         *
+         * \param spi_speed: the SPI clock (bps) to test
+         *
+         * \return   L99DZ200G_OK = all SPI frames were correct at the test clock
+         * \return   L99DZ200G_FAIL = SPI errors at the test clock (or called inside a session)
+         *
+         *  \note The watchdog is triggered at the current (known good) SPI clock.
+         */
+        uint8_t L99DZ200G_TestSPIClock(uint32_t spi_speed);
+
+        /**
+         * Find and select the fastest reliable SPI clock - SR2, CR2 to CR16.
+         *
+         * Steps up through the standard SPI clocks (up to max_speed) with
+         * L99DZ200G_TestSPIClock() until one fails, then selects the clock
+         * L99DZ200G_SPI_CAL_MARGIN steps below the fastest passing clock.
+         *
+         * \param max_speed: the fastest SPI clock (bps) to try
+         *
+         * \return   uint32_t = the selected SPI clock (bps), 0 = no clock passed (SPI clock unchanged)
+         *
+         *  \note Should be run at startup with the outputs off, the L99DZ200G SPI clock is
+         *        briefly driven beyond what the wiring may support.
+         */
+        uint32_t L99DZ200G_CalibrateSPIClock(uint32_t max_speed = L99DZ200G_SPI_MAX_CLOCK);
+
+        /**
+         * Set the Control register write verification policy.
+         *
+         * A write selected for verification is checked against the response of the next frame
+         * that addresses the same register (a read, or a write which returns the previous
+         * register contents), so e.g. a later read-modify-write costs no extra frame. A pending
+         * verification is read back explicitly only before a write to another register is
+         * selected for verification, or by L99DZ200G_FlushVerify(). The request/trigger bits
+         * that do not read back as written (CR1 STBY/TRIG, CR2 T1/T2_RESTART, CFR configuration
+         * enables and WDC) are not compared.
+         *
+         * \param policy: the verification policy:
+         *              (L99DZ200G_VERIFY_NEVER, L99DZ200G_VERIFY_ALWAYS,
+         *               L99DZ200G_VERIFY_EVERY_NTH, L99DZ200G_VERIFY_CRITICAL)
+         * \param nth: verify every nth write (L99DZ200G_VERIFY_EVERY_NTH only)
+         * \param retries: the number of times to rewrite a mismatched register (0 = count only)
+         *
+         *  \return None.
+         */
+        void L99DZ200G_SetVerifyPolicy(uint8_t policy, uint8_t nth = 1, uint8_t retries = 0);
+
+        /**
+         * Retrieve the Control register write verification policy.
+         *
+         * @return uint8_t  the verification policy
+         */
+        uint8_t L99DZ200G_GetVerifyPolicy(void);
+
+        /**
+         * Verify a pending Control register write now (explicit read back).
+         *
+         * \return   L99DZ200G_OK = no pending write or the register was as written
+         * \return   L99DZ200G_FAIL = the register was not as written (after any retries)
+         */
+        uint8_t L99DZ200G_FlushVerify(void);
+
+        /**
+         * Get the Control register write verification statistics.
+         *
+         * \param stats: where to put the verification statistics
+         *
+         *  \return None.
+         */
+        void L99DZ200G_GetVerifyStats(L99DZ200GVerifyStats * stats);
+
+        /**
+         * Clear the Control register write verification statistics.
+         *
+         *  \return None.
+         */
+        void L99DZ200G_ClearVerifyStats(void);
+
+        /**
+         * Retrieve the shadow image of a Control register (the last value written to it).
+         *
+         * \param reg: the L99DZ200G Control register (0x01 to 0x16, 0x3f) {CR1 to CR22, Config}
+         * \param val: where to put the shadow image value
+         *
+         * \return   L99DZ200G_OK = the shadow image is valid
+         * \return   L99DZ200G_FAIL = the register is not shadowed or has not been written
+         */
+        uint8_t L99DZ200G_GetShadowRegister(uint8_t reg, uint32_t * val);
+
+        /**
+         * Forget all Control register shadow images (nothing to scrub until written again).
+         *
+         *  \return None.
+         */
+        void L99DZ200G_InvalidateShadow(void);
+
+        /**
+         * Scrub Control registers against their shadow images - CR1 to CR22, CFR.
+         *
+         * Reads the next shadowed Control register(s) in turn and rewrites only those that
+         * differ from their shadow image, until the time budget is used (at least one register,
+         * at most one complete pass per call). Standby request, watchdog trigger, timer restart
+         * and CFR configuration enable bits (WD_CFG_EN, ICMP_CFG_EN, CP_OFF_EN) are not
+         * scrubbed; the CFR configuration enable is set again when CR2 watchdog time or CR22
+         * bits need repairing.
+         *
+         * \param budget_us: the time budget (uS), 0 = one complete pass
+         *
+         * \return   uint8_t = the number of Control registers repaired
+         */
+        uint8_t L99DZ200G_ScrubTick(uint16_t budget_us);
+
+        /**
+         * Get the Control register scrubber statistics.
+         *
+         * \param stats: where to put the scrubber statistics
+         *
+         *  \return None.
+         */
+        void L99DZ200G_GetScrubStats(L99DZ200GScrubStats * stats);
+
+        /**
+         * Clear the Control register scrubber statistics.
+         *
+         *  \return None.
+         */
+        void L99DZ200G_ClearScrubStats(void);
+
+        /**
+         * Apply a configuration profile, writing only the Control registers that differ - CR1 to CR22, CFR.
+         *
+         * The write order is: OUTn fields that change are first switched off (CR4 to CR6), then
+         * CFR (with any configuration enables needed), then CR1 to CR3 and CR7 to CR22, and
+         * finally the CR4 to CR6 output settings. Standby request, watchdog trigger, timer
+         * restart and CFR configuration enable bits are never set from a profile. A changed
+         * CR2 watchdog time also updates the watchdog trigger interval.
+         *
+         * \param profile: the PROGMEM configuration profile
+         * \param read_device: true = diff against registers read from the L99DZ200G,
+         *                     false = diff against the shadow images (read only if not valid)
+         *
+         * \return   uint8_t = the number of Control register writes
+         */
+        uint8_t L99DZ200G_ApplyProfile(const L99DZ200GProfile * profile, bool read_device = false);
+
+        /**
+         * Attach to an L99DZ200G that kept running while the MCU restarted (no outputs touched).
+         * Called instead of L99DZ200G_Init(): only the SPI interface and the Chip Select pin
+         * are set up (the Device Information Registers are not read).
+         *
+         * Reads CR1 to CR22 and CFR once into the shadow images and compares a checksum of the
+         * profile fields read with a checksum of the profile. If they match and the L99DZ200G
+         * has not been reset or entered fail safe, the watchdog trigger interval is taken from
+         * CR2, the watchdog is triggered and watchdog servicing is resumed. Otherwise nothing
+         * is written and the shadow images are forgotten, so a full initialization is needed.
+         *
+         * \param profile: the PROGMEM configuration profile the L99DZ200G was initialized with
+         *
+         * \return   L99DZ200G_OK = attached, watchdog servicing resumed
+         * \return   L99DZ200G_FAIL = the L99DZ200G state does not match (do a full initialization)
+         *
+         * \note The first watchdog trigger is sent right away, so the MCU restart must take longer
+         *       than the early watchdog trigger window and shorter than the watchdog time.
+         */
+        uint8_t L99DZ200G_WarmAttach(const L99DZ200GProfile * profile);
+
     private:
         /// Pointer to SPI device
         SPIClass * SPI_dev;
 
+        /// Pointer to shared SPI bus arbiter (NULL = not on a shared bus)
+        DLK_SPIBus * SPI_bus;
+
+        /// L99DZ200G device ID on shared SPI bus
+        uint8_t SPI_busDev;
+
+        /// Pointer to fault/event log (NULL = no event recording)
+        DLK_EventLog * EvLog;
+
         /// Flag for SPI initialization
         static bool SPI_initted;
 
         /// Chip Select pin number
         uint8_t CS_pin;
 
+#if defined(__AVR__) && !defined(TEENSYDUINO)
+        /// Chip Select pin output port register
+        volatile uint8_t * CS_port;
+
+        /// Chip Select pin output port bit mask
+        uint8_t CS_mask;
+#endif
+
         /// SPI configuration settings
         SPISettings SPI_Settings;
 
+        /// SPI clock of SPI configuration settings (bps)
+        uint32_t SPI_Speed;
+
         /// L99DZ200G operations Global Status Register
         uint8_t GlobalStatusRegister;
 
@@ -1462,11 +1919,151 @@ class DLK_L99DZ200G
         /// L99DZ200G watchdog running status
         bool WatchdogRunning;
 
+        /// L99DZ200G SPI session nesting count
+        uint8_t SessionDepth;
+
+        /// true = the SPI session holds the shared SPI bus
+        bool SessionBus;
+
+        /// count of frames not sent because another device held the shared SPI bus
+        uint32_t BusErrors;
+
+        /// Control register write verification policy
+        uint8_t VerifyPolicy;
+
+        /// verify every Nth Control register write
+        uint8_t VerifyNth;
+
+        /// Control register rewrites after a verification mismatch
+        uint8_t VerifyRetries;
+
+        /// Control register writes since last verification selected (every Nth)
+        uint8_t VerifyWriteCnt;
+
+        /// flag for a Control register write waiting to be verified
+        bool VerifyPending;
+
+        /// flag for verification (read back/rewrite) frames in progress
+        bool VerifyBusy;
+
+        /// Control register waiting to be verified
+        uint8_t VerifyReg;
+
+        /// value written to Control register waiting to be verified
+        uint32_t VerifyVal;
+
+        /// result of last verification
+        uint8_t VerifyResult;
+
+        /// Control register write verification statistics
+        L99DZ200GVerifyStats VerifyStats;
+
+        /// shadow images of the Control registers (last value written)
+        uint32_t Shadow[L99DZ200G_SHADOW_REGS];
+
+        /// cached device information (Device Information Registers ROM)
+        L99DZ200GDeviceInfo DeviceInfo;
+
+        /// bit flags of valid Control register shadow images
+        uint32_t ShadowValid;
+
+        /// shadow index of next Control register to scrub
+        uint8_t ScrubIndex;
+
+        /// Control register scrubber statistics
+        L99DZ200GScrubStats ScrubStats;
+
+        /// Get the shadow index of a Control register (-1 = not shadowed)
+        static int8_t L99DZ200G_ShadowIndex(uint8_t reg);
+
+        /// Get the Control register of a shadow index
+        static uint8_t L99DZ200G_ShadowReg(uint8_t idx);
+
+        /// Get the Control register (CR4 + idx) and field position of an output
+        static uint8_t L99DZ200G_OutputField(uint8_t output, uint8_t * idx, uint8_t * pos);
+
+        /// Get the Control register bits compared/repaired by the scrubber
+        static uint32_t L99DZ200G_ScrubMask(uint8_t reg);
+
+        /// Get the CFR configuration enable bits needed to change the specified Control register bits
+        static uint32_t L99DZ200G_CfgEnableMask(uint8_t reg, uint32_t diff);
+
+        /// Add a 24 bit register value to a CRC-16 (CCITT) checksum
+        static uint16_t L99DZ200G_ChecksumUpdate(uint16_t crc, uint32_t val);
+
+        /// Set the Global Status Byte of the last frame (recording a change)
+        void L99DZ200G_SetGsb(uint8_t gsb);
+
+        /// Set the watchdog trigger interval for the specified watchdog trigger time
+        void L99DZ200G_SetWdogTriggerTime(uint8_t ttime);
+
+        /// Check if a write to the specified Control register is to be verified
+        bool L99DZ200G_VerifySelect(uint8_t reg);
+
+        /// Compare a register response with the pending verification value (rewrite if mismatched)
+        void L99DZ200G_VerifyCheck(uint32_t reg_data, bool piggybacked, uint8_t retries);
+
+        /// Set up the SPI interface and the Chip Select pin (no L99DZ200G frames)
+        uint8_t L99DZ200G_SetupSPI(void);
+
+        /// Set up the SPI bus for L99DZ200G frames
+        inline bool L99DZ200G_BeginTransaction(void);
+
+        /// Release the SPI bus from L99DZ200G frames
+        inline void L99DZ200G_EndTransaction(void);
+
+        /// Drive the Chip Select pin low (selected)
+        inline void L99DZ200G_SelectCS(void);
+
+        /// Drive the Chip Select pin high (deselected)
+        inline void L99DZ200G_DeselectCS(void);
+
         /// Initiate L99DZ200G SPI transaction
-        inline void L99DZ200G_StartSPI(void);
+        inline bool L99DZ200G_StartSPI(void);
 
         /// Terminate L99DZ200G SPI transaction
         inline void L99DZ200G_EndSPI(void);
+
+        /// Shared SPI bus deferred watchdog trigger
+        static void L99DZ200G_BusWdogTrigger(void * arg);
+};
+
+/**
+ * Scoped L99DZ200G SPI session. Holds the SPI bus for the L99DZ200G from construction
+ * until it goes out of scope, so a sequence of frames costs a single SPI transaction.
+ *
+ *     {
+ *         DLK_L99DZ200G_Session session(L99dz200g);
+ *         sr1 = L99dz200g.L99DZ200G_ReadRegister(L99DZ200G_SR1);
+ *         sr2 = L99dz200g.L99DZ200G_ReadRegister(L99DZ200G_SR2);
+ *     }
+ */
+class DLK_L99DZ200G_Session
+{
+    public:
+        /**
+         *  A constructor that begins a L99DZ200G SPI session.
+         *
+         *  \param dev: the L99DZ200G device
+         *
+         *  \return None.
+         */
+        DLK_L99DZ200G_Session(DLK_L99DZ200G & dev);
+
+        /**
+         *  A destructor that ends the L99DZ200G SPI session.
+         *
+         *  \return None.
+         */
+        ~DLK_L99DZ200G_Session(void);
+
+    private:
+        /// the L99DZ200G device of the session
+        DLK_L99DZ200G & Dev;
+
+        // not copyable
+        DLK_L99DZ200G_Session(const DLK_L99DZ200G_Session &);
+        DLK_L99DZ200G_Session & operator=(const DLK_L99DZ200G_Session &);
 };
 #endif  // __DLK_L99DZ200G_H__
 
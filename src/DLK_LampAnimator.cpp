@@ -0,0 +1,469 @@
+/** \file DLK_LampAnimator.cpp */
+/*
+ * NAME: DLK_LampAnimator.cpp
+ *
+ * WHAT:
+ *  Arduino L99DZ200G lamp animation engine functions.
+ *
+ * SPECIAL CONSIDERATIONS:
+ *  None.
+ *
+ * AUTHOR:
+ *  D.L. Karmann
+ *
+ * MODIFIED:
+ *
+ */
+
+#include "DLK_LampAnimator.h"
+
+// DLK_LampAnimator Class members
+
+// Constructor
+DLK_LampAnimator::DLK_LampAnimator(DLK_L99DZ200G & l99dz200g)
+{
+    L99 = &l99dz200g;
+    memset(Patterns, 0, sizeof(Patterns));
+    memset(ChanDuty, 0, sizeof(ChanDuty));
+    LastStep = 0;
+    UpdateCnt = 0;
+}
+
+// Stop any patterns of the outputs and set them to a fixed output type
+uint8_t DLK_LampAnimator::LampAnim_Set(uint16_t outputs, uint8_t output_type)
+{
+    L99DZ200GOutputSetting settings[LAMPANIM_MAX_OUTPUTS];
+    uint8_t cnt;
+
+    if ((outputs == 0) || (outputs & ~LAMPANIM_VALID_OUTS))
+    {
+        return L99DZ200G_FAIL;
+    }
+
+    LampAnim_Claim(outputs);
+
+    cnt = LampAnim_AddSettings(settings, 0, outputs, output_type);
+    return L99->L99DZ200G_OutputsControl(settings, cnt);
+}
+
+// Stop any patterns of the outputs, leaving them as they are
+void DLK_LampAnimator::LampAnim_Release(uint16_t outputs)
+{
+    LampAnim_Claim(outputs);
+}
+
+// Run the outputs at a steady PWM level
+uint8_t DLK_LampAnimator::LampAnim_Level(uint16_t outputs, uint8_t pwm_chan, uint16_t duty)
+{
+    L99DZ200GOutputSetting settings[LAMPANIM_MAX_OUTPUTS];
+    LampPattern * pat;
+    uint8_t cnt;
+
+    if ((outputs == 0) || (outputs & ~LAMPANIM_VALID_OUTS) ||
+        (pwm_chan < PWM_CHAN1) || (pwm_chan > PWM_CHAN7) ||
+        ((pat = LampAnim_Claim(outputs)) == NULL))
+    {
+        return L99DZ200G_FAIL;
+    }
+
+    pat->outputs = outputs;
+    pat->pattern = LAMPANIM_LEVEL;
+    pat->pwm_chan = pwm_chan;
+    pat->to = (duty > PWM_DC_MAX) ? PWM_DC_MAX : duty;
+    ChanDuty[pwm_chan - 1] = pat->to;
+
+    cnt = LampAnim_AddSettings(settings, 0, outputs, PWM1_OUT + pwm_chan - 1);
+
+    L99->L99DZ200G_BeginSession();
+    L99->L99DZ200G_SetPWMDutyCycles(PWM_CHAN_BIT(pwm_chan), ChanDuty);
+    L99->L99DZ200G_OutputsControl(settings, cnt);
+    L99->L99DZ200G_EndSession();
+
+    return L99DZ200G_OK;
+}
+
+// Flash the outputs from a L99DZ200G timer
+uint8_t DLK_LampAnimator::LampAnim_Flash(uint16_t outputs, uint8_t timer, uint8_t period, uint8_t ontime)
+{
+    L99DZ200GOutputSetting settings[LAMPANIM_MAX_OUTPUTS];
+    LampPattern * pat;
+    uint8_t cnt;
+
+    if ((outputs == 0) || (outputs & ~LAMPANIM_VALID_OUTS) ||
+        ((timer != TYPE_TIMER1) && (timer != TYPE_TIMER2)) ||
+        ((pat = LampAnim_Claim(outputs)) == NULL))
+    {
+        return L99DZ200G_FAIL;
+    }
+
+    pat->outputs = outputs;
+    pat->pattern = LAMPANIM_FLASH;
+
+    cnt = LampAnim_AddSettings(settings, 0, outputs, (timer == TYPE_TIMER1) ? TIMER1_OUT : TIMER2_OUT);
+
+    L99->L99DZ200G_BeginSession();
+    L99->L99DZ200G_SetTimerConfig(timer, period, DISABLE, DISABLE, ontime);
+    L99->L99DZ200G_OutputsControl(settings, cnt);
+    L99->L99DZ200G_EndSession();
+
+    return L99DZ200G_OK;
+}
+
+// Blink the outputs, starting on
+uint8_t DLK_LampAnimator::LampAnim_Blink(uint16_t outputs, uint16_t on_ms, uint16_t off_ms, uint8_t count)
+{
+    L99DZ200GOutputSetting settings[LAMPANIM_MAX_OUTPUTS];
+    LampPattern * pat;
+    uint8_t cnt;
+
+    if ((outputs == 0) || (outputs & ~LAMPANIM_VALID_OUTS) || (on_ms == 0) || (off_ms == 0) ||
+        ((pat = LampAnim_Claim(outputs)) == NULL))
+    {
+        return L99DZ200G_FAIL;
+    }
+
+    pat->outputs = outputs;
+    pat->pattern = LAMPANIM_BLINK;
+    pat->count = count;
+    pat->time1 = on_ms;
+    pat->time2 = off_ms;
+    pat->on_mask = outputs;
+    pat->start = millis();
+
+    cnt = LampAnim_AddSettings(settings, 0, outputs, ON_OUT);
+    return L99->L99DZ200G_OutputsControl(settings, cnt);
+}
+
+// Fade the outputs from the last PWM channel duty cycle to a new level
+uint8_t DLK_LampAnimator::LampAnim_Fade(uint16_t outputs, uint8_t pwm_chan, uint16_t duty, uint16_t fade_ms)
+{
+    L99DZ200GOutputSetting settings[LAMPANIM_MAX_OUTPUTS];
+    LampPattern * pat;
+    uint8_t cnt;
+
+    if (fade_ms == 0)
+    {
+        return LampAnim_Level(outputs, pwm_chan, duty);
+    }
+
+    if ((outputs == 0) || (outputs & ~LAMPANIM_VALID_OUTS) ||
+        (pwm_chan < PWM_CHAN1) || (pwm_chan > PWM_CHAN7) ||
+        ((pat = LampAnim_Claim(outputs)) == NULL))
+    {
+        return L99DZ200G_FAIL;
+    }
+
+    pat->outputs = outputs;
+    pat->pattern = LAMPANIM_FADE;
+    pat->pwm_chan = pwm_chan;
+    pat->from = ChanDuty[pwm_chan - 1];
+    pat->to = (duty > PWM_DC_MAX) ? PWM_DC_MAX : duty;
+    pat->time1 = fade_ms;
+    pat->start = millis();
+
+    cnt = LampAnim_AddSettings(settings, 0, outputs, PWM1_OUT + pwm_chan - 1);
+
+    L99->L99DZ200G_BeginSession();
+    L99->L99DZ200G_SetPWMDutyCycles(PWM_CHAN_BIT(pwm_chan), ChanDuty);
+    L99->L99DZ200G_OutputsControl(settings, cnt);
+    L99->L99DZ200G_EndSession();
+
+    return L99DZ200G_OK;
+}
+
+// Breathe the outputs, ramping the PWM duty cycle from 0 up to a level and back
+uint8_t DLK_LampAnimator::LampAnim_Breathe(uint16_t outputs, uint8_t pwm_chan, uint16_t duty, uint16_t period_ms)
+{
+    L99DZ200GOutputSetting settings[LAMPANIM_MAX_OUTPUTS];
+    LampPattern * pat;
+    uint8_t cnt;
+
+    if ((outputs == 0) || (outputs & ~LAMPANIM_VALID_OUTS) ||
+        (pwm_chan < PWM_CHAN1) || (pwm_chan > PWM_CHAN7) || (period_ms < (2 * LAMPANIM_STEP_MS)) ||
+        ((pat = LampAnim_Claim(outputs)) == NULL))
+    {
+        return L99DZ200G_FAIL;
+    }
+
+    pat->outputs = outputs;
+    pat->pattern = LAMPANIM_BREATHE;
+    pat->pwm_chan = pwm_chan;
+    pat->to = (duty > PWM_DC_MAX) ? PWM_DC_MAX : duty;
+    pat->time1 = period_ms;
+    pat->start = millis();
+    ChanDuty[pwm_chan - 1] = 0;
+
+    cnt = LampAnim_AddSettings(settings, 0, outputs, PWM1_OUT + pwm_chan - 1);
+
+    L99->L99DZ200G_BeginSession();
+    L99->L99DZ200G_SetPWMDutyCycles(PWM_CHAN_BIT(pwm_chan), ChanDuty);
+    L99->L99DZ200G_OutputsControl(settings, cnt);
+    L99->L99DZ200G_EndSession();
+
+    return L99DZ200G_OK;
+}
+
+// Sweep the outputs, turning them on one after another in OUTn order
+uint8_t DLK_LampAnimator::LampAnim_Sweep(uint16_t outputs, uint16_t step_ms, uint16_t hold_ms, uint8_t count)
+{
+    L99DZ200GOutputSetting settings[LAMPANIM_MAX_OUTPUTS];
+    LampPattern * pat;
+    uint8_t cnt;
+
+    if ((outputs == 0) || (outputs & ~LAMPANIM_VALID_OUTS) || (step_ms == 0) ||
+        ((pat = LampAnim_Claim(outputs)) == NULL))
+    {
+        return L99DZ200G_FAIL;
+    }
+
+    pat->outputs = outputs;
+    pat->pattern = LAMPANIM_SWEEP;
+    pat->count = count;
+    pat->time1 = step_ms;
+    pat->time2 = hold_ms;
+    pat->on_mask = LampAnim_SweepMask(outputs, 0, step_ms);
+    pat->start = millis();
+
+    cnt = LampAnim_AddSettings(settings, 0, pat->on_mask, ON_OUT);
+    cnt = LampAnim_AddSettings(settings, cnt, outputs & ~pat->on_mask, OFF_OUT);
+    return L99->L99DZ200G_OutputsControl(settings, cnt);
+}
+
+// Get the pattern running on an output
+uint8_t DLK_LampAnimator::LampAnim_Pattern(uint8_t output)
+{
+    for (uint8_t i = 0; i < LAMPANIM_MAX_PATTERNS; ++i)
+    {
+        if ((Patterns[i].pattern != LAMPANIM_NONE) && (Patterns[i].outputs & LAMPANIM_OUT(output)))
+        {
+            return Patterns[i].pattern;
+        }
+    }
+    return LAMPANIM_NONE;
+}
+
+// Step the MCU stepped patterns
+void DLK_LampAnimator::LampAnim_Tick(void)
+{
+    L99DZ200GOutputSetting settings[LAMPANIM_MAX_OUTPUTS];
+    LampPattern * pat;
+    uint32_t now;
+    uint32_t elapsed;
+    uint32_t cycle;
+    uint16_t on;
+    uint16_t duty;
+    uint16_t changed;
+    uint8_t chan_mask = 0;
+    uint8_t cnt = 0;
+    uint8_t n;
+    bool done;
+
+    if (!TIMER_EXPIRED(LastStep, LAMPANIM_STEP_MS))
+    {
+        return;
+    }
+    now = millis();
+    LastStep = now;
+
+    for (uint8_t i = 0; i < LAMPANIM_MAX_PATTERNS; ++i)
+    {
+        pat = &Patterns[i];
+        elapsed = now - pat->start;
+
+        switch (pat->pattern)
+        {
+            case LAMPANIM_BLINK:
+            case LAMPANIM_SWEEP:
+                if (pat->pattern == LAMPANIM_BLINK)
+                {
+                    cycle = (uint32_t)pat->time1 + pat->time2;
+                }
+                else
+                {
+                    // each output a step, the hold time, then a step all off
+                    n = 0;
+                    for (uint16_t mask = pat->outputs; mask != 0; mask &= mask - 1)
+                    {
+                        ++n;
+                    }
+                    cycle = ((uint32_t)(n + 1) * pat->time1) + pat->time2;
+                }
+
+                done = false;
+                if (elapsed >= cycle)
+                {
+                    if ((pat->count != 0) && (--pat->count == 0))
+                    {
+                        done = true;
+                    }
+                    else
+                    {
+                        pat->start += cycle * (elapsed / cycle);
+                        elapsed %= cycle;
+                    }
+                }
+
+                if (done)
+                {
+                    on = 0;
+                }
+                else if (pat->pattern == LAMPANIM_BLINK)
+                {
+                    on = (elapsed < pat->time1) ? pat->outputs : 0;
+                }
+                else
+                {
+                    on = LampAnim_SweepMask(pat->outputs, elapsed, pat->time1);
+                    if ((on == pat->outputs) && (elapsed >= (cycle - pat->time1)))
+                    {
+                        on = 0;     // the all off step
+                    }
+                }
+
+                changed = on ^ pat->on_mask;
+                cnt = LampAnim_AddSettings(settings, cnt, changed & on, ON_OUT);
+                cnt = LampAnim_AddSettings(settings, cnt, changed & ~on, OFF_OUT);
+                pat->on_mask = on;
+
+                if (done)
+                {
+                    pat->outputs = 0;
+                    pat->pattern = LAMPANIM_NONE;
+                }
+                break;
+
+            case LAMPANIM_FADE:
+                if (elapsed >= pat->time1)
+                {
+                    duty = pat->to;
+                    pat->pattern = LAMPANIM_LEVEL;  // now held by the L99DZ200G
+                }
+                else
+                {
+                    duty = pat->from + (int16_t)(((int32_t)pat->to - pat->from) * (int32_t)elapsed / pat->time1);
+                }
+                if (duty != ChanDuty[pat->pwm_chan - 1])
+                {
+                    ChanDuty[pat->pwm_chan - 1] = duty;
+                    chan_mask |= PWM_CHAN_BIT(pat->pwm_chan);
+                }
+                break;
+
+            case LAMPANIM_BREATHE:
+                elapsed %= pat->time1;
+                cycle = pat->time1 / 2;
+                if (elapsed < cycle)
+                {
+                    duty = (uint32_t)pat->to * elapsed / cycle;
+                }
+                else
+                {
+                    duty = (uint32_t)pat->to * (pat->time1 - elapsed) / (pat->time1 - cycle);
+                }
+                if (duty != ChanDuty[pat->pwm_chan - 1])
+                {
+                    ChanDuty[pat->pwm_chan - 1] = duty;
+                    chan_mask |= PWM_CHAN_BIT(pat->pwm_chan);
+                }
+                break;
+
+            default:
+                break;      // free, or run by the L99DZ200G
+        }
+    }
+
+    if ((chan_mask == 0) && (cnt == 0))
+    {
+        return;     // nothing changed, no SPI transfers
+    }
+
+    L99->L99DZ200G_BeginSession();
+    if (chan_mask != 0)
+    {
+        L99->L99DZ200G_SetPWMDutyCycles(chan_mask, ChanDuty);
+    }
+    if (cnt != 0)
+    {
+        L99->L99DZ200G_OutputsControl(settings, cnt);
+    }
+    L99->L99DZ200G_EndSession();
+
+    ++UpdateCnt;
+}
+
+// Check if any pattern needs LampAnim_Tick() calls
+bool DLK_LampAnimator::LampAnim_Stepping(void)
+{
+    for (uint8_t i = 0; i < LAMPANIM_MAX_PATTERNS; ++i)
+    {
+        switch (Patterns[i].pattern)
+        {
+            case LAMPANIM_BLINK:
+            case LAMPANIM_FADE:
+            case LAMPANIM_BREATHE:
+            case LAMPANIM_SWEEP:
+                return true;
+        }
+    }
+    return false;
+}
+
+// Get the count of LampAnim_Tick() steps that needed SPI transfers
+uint32_t DLK_LampAnimator::LampAnim_Updates(void)
+{
+    return UpdateCnt;
+}
+
+// Release the outputs from any patterns, get a free pattern slot
+DLK_LampAnimator::LampPattern * DLK_LampAnimator::LampAnim_Claim(uint16_t outputs)
+{
+    LampPattern * free_pat = NULL;
+
+    for (uint8_t i = 0; i < LAMPANIM_MAX_PATTERNS; ++i)
+    {
+        Patterns[i].outputs &= ~outputs;
+        Patterns[i].on_mask &= ~outputs;
+        if (Patterns[i].outputs == 0)
+        {
+            Patterns[i].pattern = LAMPANIM_NONE;
+        }
+        if ((Patterns[i].pattern == LAMPANIM_NONE) && (free_pat == NULL))
+        {
+            free_pat = &Patterns[i];
+        }
+    }
+    return free_pat;
+}
+
+// Add (output, output type) settings for the outputs in the mask
+uint8_t DLK_LampAnimator::LampAnim_AddSettings(L99DZ200GOutputSetting * settings, uint8_t cnt,
+                                               uint16_t outputs, uint8_t output_type)
+{
+    for (uint8_t output = OUT_7; output <= OUT_15; ++output)
+    {
+        if (outputs & LAMPANIM_OUT(output))
+        {
+            settings[cnt].output = output;
+            settings[cnt].output_type = output_type;
+            ++cnt;
+        }
+    }
+    return cnt;
+}
+
+// Get the outputs of a sweep that are on at the specified time in its cycle
+uint16_t DLK_LampAnimator::LampAnim_SweepMask(uint16_t outputs, uint32_t elapsed, uint16_t step_ms)
+{
+    uint32_t steps = (elapsed / step_ms) + 1;     // outputs on
+    uint16_t on = 0;
+
+    for (uint8_t output = OUT_7; (output <= OUT_15) && (steps != 0); ++output)
+    {
+        if (outputs & LAMPANIM_OUT(output))
+        {
+            on |= LAMPANIM_OUT(output);
+            --steps;
+        }
+    }
+    return on;
+}
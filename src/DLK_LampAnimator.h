@@ -0,0 +1,249 @@
+/** \file DLK_LampAnimator.h */
+/*
+ * NAME: DLK_LampAnimator.h
+ *
+ * WHAT:
+ *  Header file for DLK_LampAnimator Arduino L99DZ200G lamp animation engine class.
+ *
+ *  Lamp patterns are mapped onto the L99DZ200G's own output generators wherever the
+ *  hardware can run them by itself:
+ *   - Level:   steady dimmed lamp (PWMn_OUT, CR12 to CR16) - no SPI traffic once set
+ *   - Flash:   short periodic flash (TIMER1_OUT/TIMER2_OUT, CR2) - no SPI traffic once set
+ *   - Fade:    PWM duty ramp to a level, then held as a Level - SPI traffic only while ramping
+ *  Patterns the L99DZ200G cannot generate (slower than its PWM, longer on times than its
+ *  timers) are stepped from LampAnim_Tick(), which only writes when an output or duty
+ *  actually changes, with all changes of a step batched in one SPI session:
+ *   - Blink:   on/off with any on and off times
+ *   - Breathe: continuous PWM duty ramp up and down
+ *   - Sweep:   outputs turned on one after another (in OUTn order), then all off
+ *
+ *  Outputs are given as a mask of LAMPANIM_OUT(OUT_n) bits, so a group of lamps runs one
+ *  pattern in step (e.g. both mirror arrows switch in the same SPI frame).
+ *
+ * SPECIAL CONSIDERATIONS:
+ *  Only the High-Side outputs OUT7, OUT8, OUT9, OUT10, OUT13, OUT14, OUT15 can be animated
+ *  (they are the outputs that can use the PWM and timer generators).
+ *  Outputs sharing a PWM channel or timer share its setting; starting a pattern on a channel
+ *  or timer changes it for every output using it.
+ *
+ * AUTHOR:
+ *  D.L. Karmann
+ *
+ */
+#ifndef __DLK_LAMPANIMATOR_H__
+#define __DLK_LAMPANIMATOR_H__
+
+#include "Arduino.h"
+#include "DLK_L99DZ200G.h"
+
+#define LAMPANIM_MAX_PATTERNS   4       // patterns running at the same time
+#define LAMPANIM_STEP_MS        20      // MCU stepped pattern update interval (mS)
+#define LAMPANIM_MAX_OUTPUTS    7       // outputs that can be animated
+
+// output mask bit of an output (OUT_7 ... OUT_15)
+#define LAMPANIM_OUT(output)    (1U << (output))
+// outputs that can be animated
+#define LAMPANIM_VALID_OUTS     (LAMPANIM_OUT(OUT_7) | LAMPANIM_OUT(OUT_8) | LAMPANIM_OUT(OUT_9) | \
+                                 LAMPANIM_OUT(OUT_10) | LAMPANIM_OUT(OUT_13) | LAMPANIM_OUT(OUT_14) | \
+                                 LAMPANIM_OUT(OUT_15))
+
+// lamp patterns
+#define LAMPANIM_NONE           0       // (free pattern slot)
+#define LAMPANIM_LEVEL          1       // hardware PWM level
+#define LAMPANIM_FLASH          2       // hardware timer flash
+#define LAMPANIM_BLINK          3       // MCU stepped on/off
+#define LAMPANIM_FADE           4       // MCU stepped PWM ramp, then LAMPANIM_LEVEL
+#define LAMPANIM_BREATHE        5       // MCU stepped PWM ramp up/down
+#define LAMPANIM_SWEEP          6       // MCU stepped sequential turn on
+
+/**
+ * DLK_LampAnimator Arduino L99DZ200G lamp animation engine class.
+ */
+class DLK_LampAnimator
+{
+    public:
+        // Constructor
+        /**
+         *  A constructor that sets up the lamp animation engine.
+         *
+         *  \param l99dz200g: the L99DZ200G driving the lamps
+         *
+         *  \return None.
+         */
+        DLK_LampAnimator(DLK_L99DZ200G & l99dz200g);
+
+        /**
+         * Stop any patterns of the outputs and set them to a fixed output type.
+         *
+         * \param outputs: the LAMPANIM_OUT() output mask
+         * \param output_type: the output control type (e.g. OFF_OUT, ON_OUT)
+         *
+         * \return   L99DZ200G_OK = the outputs were set
+         * \return   L99DZ200G_FAIL = invalid outputs
+         */
+        uint8_t LampAnim_Set(uint16_t outputs, uint8_t output_type);
+
+        /**
+         * Stop any patterns of the outputs, leaving them as they are (e.g. to hand them
+         * over to another controller).
+         *
+         * \param outputs: the LAMPANIM_OUT() output mask
+         *
+         *  \return None.
+         */
+        void LampAnim_Release(uint16_t outputs);
+
+        /**
+         * Run the outputs at a steady PWM level (no SPI traffic once set).
+         *
+         * \param outputs: the LAMPANIM_OUT() output mask
+         * \param pwm_chan: the PWM channel: (PWM_CHAN1 to PWM_CHAN7)
+         * \param duty: the raw PWM duty cycle: (0 to PWM_DC_MAX)
+         *
+         * \return   L99DZ200G_OK = the pattern was started
+         * \return   L99DZ200G_FAIL = invalid parameter or no free pattern slot
+         */
+        uint8_t LampAnim_Level(uint16_t outputs, uint8_t pwm_chan, uint16_t duty);
+
+        /**
+         * Flash the outputs from a L99DZ200G timer (no SPI traffic once set).
+         *
+         * \param outputs: the LAMPANIM_OUT() output mask
+         * \param timer: which Timer: (TYPE_TIMER1, TYPE_TIMER2)
+         * \param period: the flash period: (T_10MS, T_20MS, T_50MS, T_100MS, T_200MS, T_500MS, T_1S, T_2S)
+         * \param ontime: the flash on time: (TON_100US, TON_300US, TON_1MS, TON_10MS, TON_20MS)
+         *
+         * \return   L99DZ200G_OK = the pattern was started
+         * \return   L99DZ200G_FAIL = invalid parameter or no free pattern slot
+         */
+        uint8_t LampAnim_Flash(uint16_t outputs, uint8_t timer, uint8_t period, uint8_t ontime);
+
+        /**
+         * Blink the outputs (stepped by LampAnim_Tick()), starting on.
+         *
+         * \param outputs: the LAMPANIM_OUT() output mask
+         * \param on_ms: the on time (mS)
+         * \param off_ms: the off time (mS)
+         * \param count: the number of blinks, then the outputs are left off (0 = forever)
+         *
+         * \return   L99DZ200G_OK = the pattern was started
+         * \return   L99DZ200G_FAIL = invalid parameter or no free pattern slot
+         */
+        uint8_t LampAnim_Blink(uint16_t outputs, uint16_t on_ms, uint16_t off_ms, uint8_t count);
+
+        /**
+         * Fade the outputs from the last PWM channel duty cycle set by this engine to a
+         * new level (stepped by LampAnim_Tick()), then hold it as a steady level.
+         *
+         * \param outputs: the LAMPANIM_OUT() output mask
+         * \param pwm_chan: the PWM channel: (PWM_CHAN1 to PWM_CHAN7)
+         * \param duty: the final raw PWM duty cycle: (0 to PWM_DC_MAX)
+         * \param fade_ms: the fade time (mS)
+         *
+         * \return   L99DZ200G_OK = the pattern was started
+         * \return   L99DZ200G_FAIL = invalid parameter or no free pattern slot
+         */
+        uint8_t LampAnim_Fade(uint16_t outputs, uint8_t pwm_chan, uint16_t duty, uint16_t fade_ms);
+
+        /**
+         * Breathe the outputs, ramping the PWM duty cycle from 0 up to a level and back
+         * (stepped by LampAnim_Tick()).
+         *
+         * \param outputs: the LAMPANIM_OUT() output mask
+         * \param pwm_chan: the PWM channel: (PWM_CHAN1 to PWM_CHAN7)
+         * \param duty: the peak raw PWM duty cycle: (0 to PWM_DC_MAX)
+         * \param period_ms: the breathing period (mS)
+         *
+         * \return   L99DZ200G_OK = the pattern was started
+         * \return   L99DZ200G_FAIL = invalid parameter or no free pattern slot
+         */
+        uint8_t LampAnim_Breathe(uint16_t outputs, uint8_t pwm_chan, uint16_t duty, uint16_t period_ms);
+
+        /**
+         * Sweep the outputs, turning them on one after another in OUTn order, holding them
+         * all on, then all off for one step (stepped by LampAnim_Tick()).
+         *
+         * \param outputs: the LAMPANIM_OUT() output mask
+         * \param step_ms: the time between outputs turning on (mS)
+         * \param hold_ms: the time all the outputs stay on (mS)
+         * \param count: the number of sweeps, then the outputs are left off (0 = forever)
+         *
+         * \return   L99DZ200G_OK = the pattern was started
+         * \return   L99DZ200G_FAIL = invalid parameter or no free pattern slot
+         */
+        uint8_t LampAnim_Sweep(uint16_t outputs, uint16_t step_ms, uint16_t hold_ms, uint8_t count);
+
+        /**
+         * Get the pattern running on an output.
+         *
+         * \param output: the output: (OUT_7, OUT_8, OUT_9, OUT_10, OUT_13, OUT_14, OUT_15)
+         *
+         * \return   uint8_t = the pattern (LAMPANIM_NONE = none)
+         */
+        uint8_t LampAnim_Pattern(uint8_t output);
+
+        /**
+         * Step the MCU stepped patterns (call often from loop()). Does nothing until the next
+         * LAMPANIM_STEP_MS step, and makes no SPI transfers unless an output or duty changes.
+         *
+         *  \return None.
+         */
+        void LampAnim_Tick(void);
+
+        /**
+         * Check if any pattern needs LampAnim_Tick() calls.
+         *
+         * \return   true = an MCU stepped pattern is running
+         * \return   false = all patterns (if any) run in the L99DZ200G
+         */
+        bool LampAnim_Stepping(void);
+
+        /**
+         * Get the count of LampAnim_Tick() steps that needed SPI transfers.
+         *
+         * \return   uint32_t = the count of steps with SPI updates
+         */
+        uint32_t LampAnim_Updates(void);
+
+    private:
+        /// a running lamp pattern
+        typedef struct
+        {
+            uint16_t outputs;       ///< LAMPANIM_OUT() mask of the outputs (0 = free)
+            uint8_t pattern;        ///< the pattern (LAMPANIM_...)
+            uint8_t pwm_chan;       ///< the PWM channel (fade, breathe, level)
+            uint8_t count;          ///< blink/sweep cycles left (0 = forever)
+            uint16_t from;          ///< fade start duty cycle
+            uint16_t to;            ///< fade end/breathe peak duty cycle
+            uint16_t time1;         ///< blink on, fade, breathe period, sweep step time (mS)
+            uint16_t time2;         ///< blink off, sweep hold time (mS)
+            uint16_t on_mask;       ///< blink/sweep outputs currently on
+            uint32_t start;         ///< pattern (cycle) start time (mS)
+        } LampPattern;
+
+        /// L99DZ200G driving the lamps
+        DLK_L99DZ200G * L99;
+
+        /// the running patterns
+        LampPattern Patterns[LAMPANIM_MAX_PATTERNS];
+
+        /// last duty cycle set on each PWM channel
+        uint16_t ChanDuty[PWM_CHAN7];
+
+        /// time (mS) of the last step
+        uint32_t LastStep;
+
+        /// count of steps with SPI updates
+        uint32_t UpdateCnt;
+
+        /// Release the outputs from any patterns, get a free pattern slot (NULL = none)
+        LampPattern * LampAnim_Claim(uint16_t outputs);
+
+        /// Add (output, output type) settings for the outputs in the mask
+        static uint8_t LampAnim_AddSettings(L99DZ200GOutputSetting * settings, uint8_t cnt,
+                                            uint16_t outputs, uint8_t output_type);
+
+        /// Get the outputs of a sweep that are on at the specified time in its cycle
+        static uint16_t LampAnim_SweepMask(uint16_t outputs, uint32_t elapsed, uint16_t step_ms);
+};
+#endif  // __DLK_LAMPANIMATOR_H__
@@ -0,0 +1,237 @@
+/** \file DLK_LoadShedder.cpp */
+/*
+ * NAME: DLK_LoadShedder.cpp
+ *
+ * WHAT:
+ *  Arduino L99DZ200G supply voltage load-shedding functions.
+ *
+ * SPECIAL CONSIDERATIONS:
+ *  None.
+ *
+ * AUTHOR:
+ *  D.L. Karmann
+ *
+ * MODIFIED:
+ *
+ */
+
+#include "DLK_LoadShedder.h"
+
+// DLK_LoadShedder Class members
+
+// Constructor
+DLK_LoadShedder::DLK_LoadShedder(DLK_L99DZ200G & l99dz200g)
+{
+    L99 = &l99dz200g;
+    LoadCount = 0;
+    Level = 0;
+    ShedVolts = LOADSHED_SHED_V;
+    ClassVolts = LOADSHED_CLASS_V;
+    HystVolts = LOADSHED_HYST_V;
+    Vs = 0;
+    LastStep = 0;
+    LowTime = 0;
+}
+
+// Set the VSREG early warning threshold and forget any shed loads - CR3
+void DLK_LoadShedder::LoadShed_Begin(float ew_volts)
+{
+    L99->L99DZ200G_Set_VSREG_EarlyEarningThreshold(ew_volts);
+    L99->L99DZ200G_ClearVoltageStatus(VSREG_EW);
+
+    for (uint8_t i = 0; i < LoadCount; ++i)
+    {
+        if (Loads[i].shed && (Loads[i].handler != NULL))
+        {
+            Loads[i].handler(Loads[i].output, false, Loads[i].arg);
+        }
+        Loads[i].shed = false;
+    }
+    Level = 0;
+    LowTime = millis();
+}
+
+// Add a load (or change the priority class of an added load)
+uint8_t DLK_LoadShedder::LoadShed_AddLoad(uint8_t output, uint8_t priority, LoadShedHandler handler, void * arg)
+{
+    uint8_t i;
+
+    if ((priority < LOADSHED_PRIO_1) || (priority > LOADSHED_PRIO_MAX))
+    {
+        return L99DZ200G_FAIL;
+    }
+
+    for (i = 0; i < LoadCount; ++i)
+    {
+        if (Loads[i].output == output)
+        {
+            break;
+        }
+    }
+    if (i == LoadCount)
+    {
+        if (LoadCount >= LOADSHED_MAX_LOADS)
+        {
+            return L99DZ200G_FAIL;
+        }
+        ++LoadCount;
+        Loads[i].output = output;
+        Loads[i].saved_type = OFF_OUT;
+        Loads[i].shed = false;
+    }
+    Loads[i].priority = priority;
+    Loads[i].handler = handler;
+    Loads[i].arg = arg;
+
+    return L99DZ200G_OK;
+}
+
+// Set the load-shedding voltages
+void DLK_LoadShedder::LoadShed_SetThresholds(float shed_v, float class_v, float hyst_v)
+{
+    ShedVolts = shed_v;
+    ClassVolts = class_v;
+    HystVolts = hyst_v;
+}
+
+// Run a load-shedding step
+void DLK_LoadShedder::LoadShed_Tick(void)
+{
+    uint8_t level = 0;
+    bool early_warn;
+
+    if (!TIMER_EXPIRED(LastStep, LOADSHED_STEP_MS))
+    {
+        return;
+    }
+    LastStep = millis();
+
+    if (LoadCount == 0)
+    {
+        return;
+    }
+
+    L99->L99DZ200G_BeginSession();
+
+    Vs = L99->L99DZ200G_GetPinVoltage(VS_V);
+    early_warn = (L99->L99DZ200G_GetVoltageStatus(VSREG_EW) != L99DZ200G_OK);
+    if (early_warn)
+    {
+        L99->L99DZ200G_ClearVoltageStatus(VSREG_EW);
+    }
+
+    // classes VS is below the shed voltage of
+    for (uint8_t prio = LOADSHED_PRIO_1; prio <= LOADSHED_PRIO_MAX; ++prio)
+    {
+        if (Vs < (ShedVolts - ((prio - 1) * ClassVolts)))
+        {
+            level = prio;
+        }
+    }
+    if (early_warn && (level == 0))
+    {
+        level = LOADSHED_PRIO_1;
+    }
+
+    if (level >= Level)
+    {
+        // shed at once
+        Level = level;
+        LowTime = LastStep;
+    }
+    else if (Vs < (ShedVolts - ((Level - 1) * ClassVolts) + HystVolts))
+    {
+        LowTime = LastStep;     // not above the hysteresis yet
+    }
+    else if (TIMER_EXPIRED(LowTime, LOADSHED_RESTORE_MS))
+    {
+        // restore one class at a time
+        --Level;
+        LowTime = LastStep;
+    }
+
+    LoadShed_Apply(Level);
+
+    L99->L99DZ200G_EndSession();
+}
+
+// Get the number of priority classes shed
+uint8_t DLK_LoadShedder::LoadShed_Level(void)
+{
+    return Level;
+}
+
+// Check if a load is shed
+bool DLK_LoadShedder::LoadShed_IsShed(uint8_t output)
+{
+    for (uint8_t i = 0; i < LoadCount; ++i)
+    {
+        if (Loads[i].output == output)
+        {
+            return Loads[i].shed;
+        }
+    }
+    return false;
+}
+
+// Get the last VS supply voltage read
+float DLK_LoadShedder::LoadShed_Voltage(void)
+{
+    return Vs;
+}
+
+// Shed the loads of the first level classes and restore the others
+void DLK_LoadShedder::LoadShed_Apply(uint8_t level)
+{
+    L99DZ200GOutputSetting settings[LOADSHED_MAX_LOADS];
+    uint8_t cnt = 0;
+    uint8_t output_type;
+
+    for (uint8_t i = 0; i < LoadCount; ++i)
+    {
+        if (Loads[i].handler != NULL)
+        {
+            // its owner keeps it off (never written here)
+            if (Loads[i].shed != (Loads[i].priority <= level))
+            {
+                Loads[i].shed = !Loads[i].shed;
+                Loads[i].handler(Loads[i].output, Loads[i].shed, Loads[i].arg);
+            }
+        }
+        else if (Loads[i].priority <= level)
+        {
+            // shed (again, if it was turned back on)
+            output_type = L99->L99DZ200G_GetOutputControl(Loads[i].output);
+            if (!Loads[i].shed)
+            {
+                Loads[i].saved_type = output_type;
+                Loads[i].shed = true;
+            }
+            else if (output_type != OFF_OUT)
+            {
+                Loads[i].saved_type = output_type;
+            }
+            if (output_type != OFF_OUT)
+            {
+                settings[cnt].output = Loads[i].output;
+                settings[cnt].output_type = OFF_OUT;
+                ++cnt;
+            }
+        }
+        else if (Loads[i].shed)
+        {
+            Loads[i].shed = false;
+            if (Loads[i].saved_type != OFF_OUT)
+            {
+                settings[cnt].output = Loads[i].output;
+                settings[cnt].output_type = Loads[i].saved_type;
+                ++cnt;
+            }
+        }
+    }
+
+    if (cnt != 0)
+    {
+        L99->L99DZ200G_OutputsControl(settings, cnt);
+    }
+}
@@ -0,0 +1,192 @@
+/** \file DLK_LoadShedder.h */
+/*
+ * NAME: DLK_LoadShedder.h
+ *
+ * WHAT:
+ *  Header file for DLK_LoadShedder Arduino L99DZ200G supply voltage load-shedding class.
+ *
+ *  Each load (output) is given a priority class, LOADSHED_PRIO_1 (shed first) to
+ *  LOADSHED_PRIO_4 (shed last). Loads that must ride through supply dips (motors) are
+ *  simply not added. Every LOADSHED_STEP_MS the VS supply voltage and the VSREG early
+ *  warning status are read:
+ *   - class n is shed when VS falls below the shed voltage less (n - 1) class steps
+ *   - a VSREG early warning (threshold set by LoadShed_Begin()) sheds at least class 1,
+ *     catching fast dips between two steps
+ *   - the last shed class is restored when VS has been at least the hysteresis above its
+ *     shed voltage for LOADSHED_RESTORE_MS, then the next one, and so on
+ *  A shed load's output control type is saved and written back when it is restored.
+ *
+ * SPECIAL CONSIDERATIONS:
+ *  Loads are shed with one L99DZ200G_OutputsControl() call per step. A shed load that is
+ *  turned back on by another writer is turned off again at the next step and its new
+ *  output control type is the one restored.
+ *  A load driven by a controller of its own (heater regulator, ...) is added with a
+ *  LoadShedHandler instead: the shedder then never writes its output, it only tells the
+ *  handler when the load is shed and restored so the controller keeps it off itself.
+ *  Output control types are taken from the Control register shadow images, so a step with
+ *  nothing to shed or restore only reads VS and SR2.
+ *
+ * AUTHOR:
+ *  D.L. Karmann
+ *
+ */
+#ifndef __DLK_LOADSHEDDER_H__
+#define __DLK_LOADSHEDDER_H__
+
+#include "Arduino.h"
+#include "DLK_L99DZ200G.h"
+
+#define LOADSHED_MAX_LOADS      12      // loads managed
+#define LOADSHED_STEP_MS        20      // supply voltage check interval (mS)
+#define LOADSHED_RESTORE_MS     1000    // time VS must stay restored before a class is restored (mS)
+#define LOADSHED_SHED_V         10.5F   // default voltage class 1 is shed below (V)
+#define LOADSHED_CLASS_V        0.5F    // default voltage step between classes (V)
+#define LOADSHED_HYST_V         0.8F    // default restore hysteresis (V)
+
+// load priority classes
+#define LOADSHED_PRIO_1         1       // shed first (e.g. heater)
+#define LOADSHED_PRIO_2         2       // (e.g. lamps)
+#define LOADSHED_PRIO_3         3
+#define LOADSHED_PRIO_4         4       // shed last
+#define LOADSHED_PRIO_MAX       LOADSHED_PRIO_4
+
+// a load's owner handler: shed = true: keep the output off, false: the load is restored
+typedef void (* LoadShedHandler)(uint8_t output, bool shed, void * arg);
+
+/**
+ * A load managed by the load shedder.
+ */
+typedef struct
+{
+    uint8_t output;         ///< the output: (OUT_1, OUT_2, OUT_3, OUT_6 to OUT_10, OUT_13 to OUT_15, OUT_GH)
+    uint8_t priority;       ///< the priority class: (LOADSHED_PRIO_1 to LOADSHED_PRIO_MAX)
+    uint8_t saved_type;     ///< the output control type to restore
+    bool shed;              ///< true = the load is shed
+    LoadShedHandler handler;    ///< the owner handler (NULL = the shedder switches the output)
+    void * arg;             ///< the owner handler argument
+} LoadShedLoad;
+
+/**
+ * DLK_LoadShedder Arduino L99DZ200G supply voltage load-shedding class.
+ */
+class DLK_LoadShedder
+{
+    public:
+        // Constructor
+        /**
+         *  A constructor that sets up the load shedder.
+         *
+         *  \param l99dz200g: the L99DZ200G driving the loads
+         *
+         *  \return None.
+         */
+        DLK_LoadShedder(DLK_L99DZ200G & l99dz200g);
+
+        /**
+         * Set the VSREG early warning threshold and forget any shed loads (call after the
+         * L99DZ200G is initialized) - CR3.
+         *
+         * The early warning only adds to the VS steps when its threshold is above the class 1
+         * shed voltage (LoadShed_SetThresholds()).
+         *
+         * \param ew_volts: the VSREG early warning threshold voltage (0.0 to 10 V)
+         *
+         *  \return None.
+         */
+        void LoadShed_Begin(float ew_volts);
+
+        /**
+         * Add a load (or change the priority class of an added load).
+         *
+         * \param output: the output:
+         *                (OUT_1, OUT_2, OUT_3, OUT_6, OUT_7, OUT_8, OUT_9,
+         *                 OUT_10, OUT_13, OUT_14, OUT_15, OUT_GH)
+         * \param priority: the priority class: (LOADSHED_PRIO_1 to LOADSHED_PRIO_MAX)
+         * \param handler: the owner handler called when the load is shed and restored
+         *                 (NULL = the shedder switches the output itself)
+         * \param arg: the owner handler argument
+         *
+         * \return   L99DZ200G_OK = the load was added
+         * \return   L99DZ200G_FAIL = invalid priority class or no room for the load
+         */
+        uint8_t LoadShed_AddLoad(uint8_t output, uint8_t priority, LoadShedHandler handler = NULL,
+                                 void * arg = NULL);
+
+        /**
+         * Set the load-shedding voltages.
+         *
+         * \param shed_v: the VS voltage class 1 is shed below (V)
+         * \param class_v: the VS voltage step between classes (V)
+         * \param hyst_v: the VS voltage above a class's shed voltage to restore it (V)
+         *
+         *  \return None.
+         */
+        void LoadShed_SetThresholds(float shed_v, float class_v, float hyst_v);
+
+        /**
+         * Run a load-shedding step (call often from loop()). Does nothing until the next
+         * LOADSHED_STEP_MS step.
+         *
+         *  \return None.
+         */
+        void LoadShed_Tick(void);
+
+        /**
+         * Get the number of priority classes shed.
+         *
+         * \return   uint8_t = the classes shed: (0 to LOADSHED_PRIO_MAX)
+         */
+        uint8_t LoadShed_Level(void);
+
+        /**
+         * Check if a load is shed.
+         *
+         * \param output: the output
+         *
+         * \return   true = the load is shed
+         * \return   false = the load is not shed (or not managed)
+         */
+        bool LoadShed_IsShed(uint8_t output);
+
+        /**
+         * Get the last VS supply voltage read.
+         *
+         * \return   float = the VS voltage (V)
+         */
+        float LoadShed_Voltage(void);
+
+    private:
+        /// L99DZ200G driving the loads
+        DLK_L99DZ200G * L99;
+
+        /// managed loads
+        LoadShedLoad Loads[LOADSHED_MAX_LOADS];
+
+        /// number of managed loads
+        uint8_t LoadCount;
+
+        /// number of priority classes shed
+        uint8_t Level;
+
+        /// VS voltage class 1 is shed below (V)
+        float ShedVolts;
+
+        /// VS voltage step between classes (V)
+        float ClassVolts;
+
+        /// restore hysteresis (V)
+        float HystVolts;
+
+        /// last VS voltage read (V)
+        float Vs;
+
+        /// time (mS) of the last step
+        uint32_t LastStep;
+
+        /// time (mS) VS was last too low to restore a class
+        uint32_t LowTime;
+
+        /// Shed the loads of the first level classes and restore the others
+        void LoadShed_Apply(uint8_t level);
+};
+#endif  // __DLK_LOADSHEDDER_H__
@@ -0,0 +1,146 @@
+/** \file DLK_Logger.cpp */
+/*
+ * NAME: DLK_Logger.cpp
+ *
+ * WHAT:
+ *  Arduino non-blocking buffered logging functions.
+ *
+ * SPECIAL CONSIDERATIONS:
+ *  None.
+ *
+ * AUTHOR:
+ *  D.L. Karmann
+ *
+ * MODIFIED:
+ *
+ */
+
+#include <stdio.h>
+#include "DLK_Logger.h"
+
+// severity letters (LOG_ERROR to LOG_DEBUG)
+static const char LogLevelChars[] = "EWID";
+
+// DLK_Logger Class members
+
+// Constructor
+DLK_Logger::DLK_Logger(void)
+{
+    Head = 0;
+    Tail = 0;
+    Level = LOG_INFO;
+    DroppedCnt = 0;
+    ReportedCnt = 0;
+    LinePos = 0;
+    LineLen = 0;
+}
+
+// Log a message
+void DLK_Logger::Log_Msg(uint8_t level, PGM_P fmt, uint32_t a1, uint32_t a2, uint32_t a3, uint32_t a4)
+{
+    uint8_t next = (Head + 1) & (LOG_SIZE - 1);
+    LogMsg * msg = &Msgs[Head];
+
+    if (level > Level)
+    {
+        return;         // filtered out
+    }
+    if (next == Tail)
+    {
+        ++DroppedCnt;   // log full, lose the newest message
+        return;
+    }
+
+    msg->fmt = fmt;
+    msg->time = millis();
+    msg->args[0] = a1;
+    msg->args[1] = a2;
+    msg->args[2] = a3;
+    msg->args[3] = a4;
+    msg->level = level;
+    Head = next;
+}
+
+// Set the least severe messages kept
+void DLK_Logger::Log_SetLevel(uint8_t level)
+{
+    Level = (level > LOG_DEBUG) ? LOG_DEBUG : level;
+}
+
+// Get the least severe messages kept
+uint8_t DLK_Logger::Log_Level(void)
+{
+    return Level;
+}
+
+// Write logged messages, only as much as the output device can take without blocking
+bool DLK_Logger::Log_Drain(Print & out)
+{
+    int avail;
+    uint8_t cnt;
+
+    if (LinePos >= LineLen)
+    {
+        // current message done, get the next one
+        if (DroppedCnt != ReportedCnt)
+        {
+            LineLen = snprintf_P(Line, sizeof(Line), PSTR("Log: %lu message(s) dropped\r\n"),
+                                 (unsigned long)(DroppedCnt - ReportedCnt));
+            ReportedCnt = DroppedCnt;
+        }
+        else if (Tail != Head)
+        {
+            Log_Format(&Msgs[Tail]);
+            Tail = (Tail + 1) & (LOG_SIZE - 1);
+        }
+        else
+        {
+            return false;   // nothing to write
+        }
+        if (LineLen >= sizeof(Line))
+        {
+            LineLen = sizeof(Line) - 1;
+        }
+        LinePos = 0;
+    }
+
+    avail = out.availableForWrite();
+    if (avail <= 0)
+    {
+        return true;
+    }
+    cnt = LineLen - LinePos;
+    if (cnt > avail)
+    {
+        cnt = avail;
+    }
+    out.write((const uint8_t *)&Line[LinePos], cnt);
+    LinePos += cnt;
+    return LinePos < LineLen;
+}
+
+// Get the count of lost messages
+uint32_t DLK_Logger::Log_Dropped(void)
+{
+    return DroppedCnt;
+}
+
+// Format a logged message (a truncated message still ends the line)
+void DLK_Logger::Log_Format(LogMsg * msg)
+{
+    int len;
+
+    len = snprintf_P(Line, sizeof(Line), PSTR("%lu %c "), (unsigned long)msg->time,
+                     LogLevelChars[msg->level]);
+    len += snprintf_P(&Line[len], sizeof(Line) - 2 - len, msg->fmt, (unsigned long)msg->args[0],
+                      (unsigned long)msg->args[1], (unsigned long)msg->args[2],
+                      (unsigned long)msg->args[3]);
+    if (len > (int)(sizeof(Line) - 3))
+    {
+        len = sizeof(Line) - 3;
+    }
+    Line[len++] = '\r';
+    Line[len++] = '\n';
+    Line[len] = '\0';
+    LineLen = len;
+}
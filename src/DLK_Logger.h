@@ -0,0 +1,147 @@
+/** \file DLK_Logger.h */
+/*
+ * NAME: DLK_Logger.h
+ *
+ * WHAT:
+ *  Header file for DLK_Logger Arduino non-blocking buffered logging class.
+ *
+ *  A log message is a PROGMEM printf format string and up to LOG_MAX_ARGS 32 bit
+ *  arguments. Logging a message only copies them (with the time and the severity) into a
+ *  fixed RAM ring buffer; messages less severe than the log level are not kept at all.
+ *  Log_Drain() (called from loop()) formats the messages and writes them only as fast as
+ *  the output has room for (availableForWrite()), so a full Serial transmit buffer never
+ *  delays the caller. Messages logged while the ring buffer is full are dropped, counted,
+ *  and the count is reported in the log.
+ *
+ *  Each message is written as: "<millis()> <E|W|I|D> <message>\r\n"
+ *
+ *      Logger.Log_Msg(LOG_WARN, PSTR("SR1: 0x%06lX"), sr1);
+ *      LOG_W(Logger, "SR1: 0x%06lX", sr1);     // the same
+ *
+ * SPECIAL CONSIDERATIONS:
+ *  Every argument is passed as a 32 bit value, so the format conversions must be long
+ *  ones (%lu, %ld, %lX, %08lX, ...); strings and floats are not supported.
+ *  Messages are logged from loop() context only (not from interrupt handlers).
+ *
+ * AUTHOR:
+ *  D.L. Karmann
+ *
+ */
+#ifndef __DLK_LOGGER_H__
+#define __DLK_LOGGER_H__
+
+#include "Arduino.h"
+
+#ifndef LOG_SIZE
+#define LOG_SIZE                8       // messages in the ring buffer (power of 2)
+#endif
+#define LOG_MAX_ARGS            4       // arguments per message
+#define LOG_LINE_SIZE           80      // formatted message buffer size
+
+// severity levels
+#define LOG_ERROR               0
+#define LOG_WARN                1
+#define LOG_INFO                2
+#define LOG_DEBUG               3
+
+// log a message with a format string literal (placed in PROGMEM)
+#define LOG_E(log, fmt, ...)    (log).Log_Msg(LOG_ERROR, PSTR(fmt), ##__VA_ARGS__)
+#define LOG_W(log, fmt, ...)    (log).Log_Msg(LOG_WARN, PSTR(fmt), ##__VA_ARGS__)
+#define LOG_I(log, fmt, ...)    (log).Log_Msg(LOG_INFO, PSTR(fmt), ##__VA_ARGS__)
+#define LOG_D(log, fmt, ...)    (log).Log_Msg(LOG_DEBUG, PSTR(fmt), ##__VA_ARGS__)
+
+/**
+ * DLK_Logger Arduino non-blocking buffered logging class.
+ */
+class DLK_Logger
+{
+    public:
+        // Constructor
+        /**
+         *  A constructor that sets up an empty log keeping messages up to LOG_INFO.
+         *
+         *  \return None.
+         */
+        DLK_Logger(void);
+
+        /**
+         * Log a message (never blocks, does no output).
+         *
+         * \param level: the severity: (LOG_ERROR, LOG_WARN, LOG_INFO, LOG_DEBUG)
+         * \param fmt: the PROGMEM printf format string (32 bit conversions only)
+         * \param a1 - a4: the arguments
+         *
+         *  \return None.
+         */
+        void Log_Msg(uint8_t level, PGM_P fmt, uint32_t a1 = 0, uint32_t a2 = 0,
+                     uint32_t a3 = 0, uint32_t a4 = 0);
+
+        /**
+         * Set the least severe messages kept.
+         *
+         * \param level: the severity: (LOG_ERROR, LOG_WARN, LOG_INFO, LOG_DEBUG)
+         *
+         *  \return None.
+         */
+        void Log_SetLevel(uint8_t level);
+
+        /**
+         * Get the least severe messages kept.
+         *
+         * \return   uint8_t = the severity: (LOG_ERROR, LOG_WARN, LOG_INFO, LOG_DEBUG)
+         */
+        uint8_t Log_Level(void);
+
+        /**
+         * Write logged messages without blocking on the output device (call often from
+         * loop()).
+         *
+         * \param out: the output device (e.g. Serial)
+         *
+         * \return   true = a message is partly written (do not write other output yet)
+         * \return   false = no message is being written
+         */
+        bool Log_Drain(Print & out);
+
+        /**
+         * Get the count of messages lost because the log was full.
+         *
+         * \return   uint32_t = the count of lost messages
+         */
+        uint32_t Log_Dropped(void);
+
+    private:
+        /// a logged message
+        typedef struct
+        {
+            PGM_P fmt;
+            uint32_t time;
+            uint32_t args[LOG_MAX_ARGS];
+            uint8_t level;
+        } LogMsg;
+
+        /// the logged messages
+        LogMsg Msgs[LOG_SIZE];
+
+        /// the log ring buffer indexes
+        uint8_t Head;
+        uint8_t Tail;
+
+        /// least severe messages kept
+        uint8_t Level;
+
+        /// the count of messages lost because the log was full
+        uint32_t DroppedCnt;
+
+        /// the count of lost messages already reported
+        uint32_t ReportedCnt;
+
+        /// the formatted message being written
+        char Line[LOG_LINE_SIZE];
+        uint8_t LinePos;
+        uint8_t LineLen;
+
+        /// Format a logged message
+        void Log_Format(LogMsg * msg);
+};
+#endif  // __DLK_LOGGER_H__
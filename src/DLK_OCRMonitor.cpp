@@ -0,0 +1,331 @@
+/** \file DLK_OCRMonitor.cpp */
+/*
+ * NAME: DLK_OCRMonitor.cpp
+ *
+ * WHAT:
+ *  Arduino L99DZ200G overcurrent autorecovery monitor functions.
+ *
+ * SPECIAL CONSIDERATIONS:
+ *  None.
+ *
+ * AUTHOR:
+ *  D.L. Karmann
+ *
+ * MODIFIED:
+ *
+ */
+
+#include "DLK_OCRMonitor.h"
+
+// autorecovery outputs, their SR4 alerts and recovery group (CR8 fields)
+static const uint8_t OcrMonOuts[OCRMON_OUTPUTS] =
+    { OUT_1, OUT_2, OUT_3, OUT_6, OUT_7, OUT_8, OUT_15 };
+static const uint32_t OcrMonAlerts[OCRMON_OUTPUTS] =
+{
+    SR4_OUT1H_OCRAL | SR4_OUT1L_OCRAL,
+    SR4_OUT2H_OCRAL | SR4_OUT2L_OCRAL,
+    SR4_OUT3H_OCRAL | SR4_OUT3L_OCRAL,
+    SR4_OUT6H_OCRAL | SR4_OUT6L_OCRAL,
+    SR4_OUT7_OCRAL,
+    SR4_OUT8_OCRAL,
+    SR4_OUT15_OCRAL
+};
+static const uint8_t OcrMonGroup[OCRMON_OUTPUTS] = { 0, 0, 0, 0, 1, 2, 3 };
+static const uint32_t OcrMonGroupMask[4] =
+{
+    CR8_OUT1_2_3_6_TIME_MASK | CR8_OUT1_2_3_6_FREQ_MASK,
+    CR8_OUT7_TIME_MASK | CR8_OUT7_FREQ_MASK,
+    CR8_OUT8_TIME_MASK | CR8_OUT8_FREQ_MASK,
+    CR8_OUT15_TIME_MASK | CR8_OUT15_FREQ_MASK
+};
+static const uint8_t OcrMonTimePos[4] =
+    { CR8_OUT1_2_3_6_TIME_POS, CR8_OUT7_TIME_POS, CR8_OUT8_TIME_POS, CR8_OUT15_TIME_POS };
+static const uint8_t OcrMonFreqPos[4] =
+    { CR8_OUT1_2_3_6_FREQ_POS, CR8_OUT7_FREQ_POS, CR8_OUT8_FREQ_POS, CR8_OUT15_FREQ_POS };
+
+// DLK_OCRMonitor Class members
+
+// Constructor
+DLK_OCRMonitor::DLK_OCRMonitor(DLK_L99DZ200G & l99dz200g)
+{
+    L99 = &l99dz200g;
+    Outputs = 0;
+    memset(Stats, 0, sizeof(Stats));
+    NormalCr8 = 0;
+    memset(GroupClass, OCRMON_NORMAL, sizeof(GroupClass));
+    Bucket = 0;
+    BucketStart = 0;
+    LastStep = 0;
+}
+
+// Start monitoring outputs - CR8
+void DLK_OCRMonitor::OcrMon_Begin(uint16_t outputs)
+{
+    uint32_t reg_data;
+
+    if (L99->L99DZ200G_GetShadowRegister(L99DZ200G_CR8, &reg_data) != L99DZ200G_OK)
+    {
+        reg_data = L99->L99DZ200G_ReadRegister(L99DZ200G_CR8);
+    }
+    NormalCr8 = reg_data & (OcrMonGroupMask[0] | OcrMonGroupMask[1] |
+                            OcrMonGroupMask[2] | OcrMonGroupMask[3]);
+    memset(GroupClass, OCRMON_NORMAL, sizeof(GroupClass));
+
+    Outputs = outputs & OCRMON_ALL_OUTS;
+    memset(Stats, 0, sizeof(Stats));
+    for (uint8_t i = 0; i < OCRMON_OUTPUTS; ++i)
+    {
+        Stats[i].output_type = L99->L99DZ200G_GetOutputControl(OcrMonOuts[i]);
+    }
+
+    // drop alerts from before monitoring
+    L99->L99DZ200G_ReadClearRegister(L99DZ200G_SR4, OcrMonAlerts[0] | OcrMonAlerts[1] |
+                                     OcrMonAlerts[2] | OcrMonAlerts[3] | OcrMonAlerts[4] |
+                                     OcrMonAlerts[5] | OcrMonAlerts[6]);
+
+    Bucket = 0;
+    BucketStart = millis();
+    LastStep = BucketStart;
+}
+
+// Run a monitor step
+void DLK_OCRMonitor::OcrMon_Tick(void)
+{
+    L99DZ200GOutputSetting settings[OCRMON_OUTPUTS];
+    uint8_t cnt = 0;
+    uint32_t alerts;
+    uint8_t output_type;
+    uint8_t prev_class;
+    uint16_t window;
+    bool changed = false;
+    OcrMonStats * st;
+
+    if (!TIMER_EXPIRED(LastStep, OCRMON_STEP_MS))
+    {
+        return;
+    }
+    LastStep = millis();
+
+    if (Outputs == 0)
+    {
+        return;
+    }
+
+    L99->L99DZ200G_BeginSession();
+
+    alerts = L99->L99DZ200G_ReadRegister(L99DZ200G_SR4) & FULL_REG_MASK;
+    alerts &= OcrMonAlerts[0] | OcrMonAlerts[1] | OcrMonAlerts[2] | OcrMonAlerts[3] |
+              OcrMonAlerts[4] | OcrMonAlerts[5] | OcrMonAlerts[6];
+    if (alerts != 0)
+    {
+        L99->L99DZ200G_ReadClearRegister(L99DZ200G_SR4, alerts);
+    }
+
+    // start the next long window bucket
+    if (TIMER_EXPIRED(BucketStart, OCRMON_BUCKET_MS))
+    {
+        BucketStart = LastStep;
+        Bucket = (Bucket + 1) % OCRMON_BUCKETS;
+        for (uint8_t i = 0; i < OCRMON_OUTPUTS; ++i)
+        {
+            Stats[i].buckets[Bucket] = 0;
+        }
+    }
+
+    for (uint8_t i = 0; i < OCRMON_OUTPUTS; ++i)
+    {
+        if ((Outputs & OCRMON_OUT(OcrMonOuts[i])) == 0)
+        {
+            continue;
+        }
+        st = &Stats[i];
+
+        // turn-on
+        output_type = L99->L99DZ200G_GetOutputControl(OcrMonOuts[i]);
+        if ((output_type != OFF_OUT) && (st->output_type == OFF_OUT))
+        {
+            st->on_time = LastStep;
+        }
+        st->output_type = output_type;
+
+        st->history <<= 1;
+        if (alerts & OcrMonAlerts[i])
+        {
+            if (st->alerts < 0xFFFF)
+            {
+                ++st->alerts;
+            }
+            if ((output_type != OFF_OUT) && ((LastStep - st->on_time) < OCRMON_INRUSH_MS))
+            {
+                if (st->inrush_alerts < 0xFFFF)
+                {
+                    ++st->inrush_alerts;
+                }
+            }
+            else
+            {
+                st->history |= 1;
+                if (st->buckets[Bucket] < 0xFF)
+                {
+                    ++st->buckets[Bucket];
+                }
+            }
+        }
+
+        if (st->out_class == OCRMON_SHORT)
+        {
+            continue;       // kept until OcrMon_Reset()
+        }
+
+        window = OcrMon_WindowAlerts(OcrMonOuts[i]);
+        if (__builtin_popcountl(st->history) >= OCRMON_SHORT_ALERTS)
+        {
+            // persistent: output off, stop recovering into the short
+            st->out_class = OCRMON_SHORT;
+            L99->L99DZ200G_Set_OCR_AutorecoveryControl(OcrMonOuts[i], DISABLE);
+            settings[cnt].output = OcrMonOuts[i];
+            settings[cnt].output_type = OFF_OUT;
+            ++cnt;
+            changed = true;
+            continue;
+        }
+
+        prev_class = st->out_class;
+        if ((window >= OCRMON_OVERLOAD_ALERTS) ||
+            ((st->out_class == OCRMON_OVERLOAD) && (window != 0)))
+        {
+            st->out_class = OCRMON_OVERLOAD;
+        }
+        else
+        {
+            st->out_class = (st->inrush_alerts != 0) ? OCRMON_INRUSH : OCRMON_NORMAL;
+        }
+        changed |= (st->out_class != prev_class);
+    }
+
+    if (cnt != 0)
+    {
+        L99->L99DZ200G_OutputsControl(settings, cnt);
+    }
+    if (changed)
+    {
+        OcrMon_UpdateGroups();
+    }
+
+    L99->L99DZ200G_EndSession();
+}
+
+// Clear an output's statistics and class - CR7
+void DLK_OCRMonitor::OcrMon_Reset(uint8_t output)
+{
+    int8_t i = OcrMon_Index(output);
+
+    if (i < 0)
+    {
+        return;
+    }
+
+    if (Stats[i].out_class == OCRMON_SHORT)
+    {
+        L99->L99DZ200G_Set_OCR_AutorecoveryControl(output, ENABLE);
+    }
+    memset(&Stats[i], 0, sizeof(OcrMonStats));
+    Stats[i].output_type = L99->L99DZ200G_GetOutputControl(output);
+    OcrMon_UpdateGroups();
+}
+
+// Get an output's class
+uint8_t DLK_OCRMonitor::OcrMon_Class(uint8_t output)
+{
+    int8_t i = OcrMon_Index(output);
+
+    return (i < 0) ? OCRMON_NORMAL : Stats[i].out_class;
+}
+
+// Get an output's overcurrent recovery statistics
+const OcrMonStats * DLK_OCRMonitor::OcrMon_Stats(uint8_t output)
+{
+    int8_t i = OcrMon_Index(output);
+
+    return (i < 0) ? NULL : &Stats[i];
+}
+
+// Get an output's alert steps in the long window
+uint16_t DLK_OCRMonitor::OcrMon_WindowAlerts(uint8_t output)
+{
+    int8_t i = OcrMon_Index(output);
+    uint16_t sum = 0;
+
+    if (i < 0)
+    {
+        return 0;
+    }
+    for (uint8_t b = 0; b < OCRMON_BUCKETS; ++b)
+    {
+        sum += Stats[i].buckets[b];
+    }
+    return sum;
+}
+
+// Get the statistics index of an output (-1 = not an autorecovery output)
+int8_t DLK_OCRMonitor::OcrMon_Index(uint8_t output)
+{
+    for (uint8_t i = 0; i < OCRMON_OUTPUTS; ++i)
+    {
+        if (OcrMonOuts[i] == output)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Set the CR8 settings of the recovery groups for their outputs' classes
+void DLK_OCRMonitor::OcrMon_UpdateGroups(void)
+{
+    uint8_t group_class[4] = { OCRMON_NORMAL, OCRMON_NORMAL, OCRMON_NORMAL, OCRMON_NORMAL };
+    uint32_t reg_mask = 0;
+    uint32_t reg_data = 0;
+    uint8_t g;
+
+    // worst class of each group's outputs still recovering
+    for (uint8_t i = 0; i < OCRMON_OUTPUTS; ++i)
+    {
+        g = OcrMonGroup[i];
+        if ((Stats[i].out_class != OCRMON_SHORT) && (Stats[i].out_class > group_class[g]))
+        {
+            group_class[g] = Stats[i].out_class;
+        }
+    }
+
+    for (g = 0; g < 4; ++g)
+    {
+        if (group_class[g] == GroupClass[g])
+        {
+            continue;
+        }
+        GroupClass[g] = group_class[g];
+        reg_mask |= OcrMonGroupMask[g];
+
+        switch (group_class[g])
+        {
+            case OCRMON_INRUSH:
+                reg_data |= ((uint32_t)OCR_TON_88US << OcrMonTimePos[g]) |
+                            ((uint32_t)OCR_FREQ_4_4KHZ << OcrMonFreqPos[g]);
+                break;
+            case OCRMON_OVERLOAD:
+                reg_data |= ((uint32_t)OCR_TON_64US << OcrMonTimePos[g]) |
+                            ((uint32_t)OCR_FREQ_1_7KHZ << OcrMonFreqPos[g]);
+                break;
+
+            default:
+                reg_data |= NormalCr8 & OcrMonGroupMask[g];
+                break;
+        }
+    }
+
+    if (reg_mask != 0)
+    {
+        L99->L99DZ200G_ModifyControlRegister(L99DZ200G_CR8, reg_mask, reg_data);
+    }
+}
@@ -0,0 +1,183 @@
+/** \file DLK_OCRMonitor.h */
+/*
+ * NAME: DLK_OCRMonitor.h
+ *
+ * WHAT:
+ *  Header file for DLK_OCRMonitor Arduino L99DZ200G overcurrent autorecovery monitor class.
+ *
+ *  The overcurrent recovery alerts (SR4) of the outputs with autorecovery (OUT1, OUT2, OUT3,
+ *  OUT6, OUT7, OUT8, OUT15) are read every OCRMON_STEP_MS. An alert within
+ *  OCRMON_INRUSH_MS of an output turning on is counted as turn-on inrush (cold lamp);
+ *  other alerts are counted over two sliding windows:
+ *   - short window: the last 32 steps (one bit per step)
+ *   - long window: OCRMON_BUCKETS buckets of OCRMON_BUCKET_MS
+ *  and each output is classed:
+ *   - OCRMON_NORMAL: no alerts
+ *   - OCRMON_INRUSH: alerts only at turn-on
+ *   - OCRMON_OVERLOAD: at least OCRMON_OVERLOAD_ALERTS steps with alerts in the long window
+ *                      (kept until the long window is clear)
+ *   - OCRMON_SHORT: at least OCRMON_SHORT_ALERTS steps with alerts in the short window;
+ *                   the output is turned off and its autorecovery disabled (kept until
+ *                   OcrMon_Reset())
+ *  The autorecovery on time and frequency (CR8) of each recovery group (OUT1/2/3/6, OUT7,
+ *  OUT8, OUT15) follows the worst class of its outputs not shorted:
+ *   - OCRMON_NORMAL: the settings when OcrMon_Begin() was called
+ *   - OCRMON_INRUSH: longest on time, highest frequency (the cold filament warms up fast
+ *                    and leaves recovery sooner)
+ *   - OCRMON_OVERLOAD: shortest on time, lowest frequency (least L99DZ200G heating)
+ *
+ * SPECIAL CONSIDERATIONS:
+ *  Each step reads SR4 once (and clears the alerts seen); output turn-ons are taken from the
+ *  Control register shadow images. CR8 is only written when a group's class changes.
+ *
+ * AUTHOR:
+ *  D.L. Karmann
+ *
+ */
+#ifndef __DLK_OCRMONITOR_H__
+#define __DLK_OCRMONITOR_H__
+
+#include "Arduino.h"
+#include "DLK_L99DZ200G.h"
+
+#define OCRMON_OUTPUTS          7       // outputs with overcurrent autorecovery
+#define OCRMON_STEP_MS          100     // alert check interval (mS)
+#define OCRMON_INRUSH_MS        500     // turn-on inrush time (mS)
+#define OCRMON_BUCKETS          10      // long window buckets
+#define OCRMON_BUCKET_MS        6000    // long window bucket time (mS)
+#define OCRMON_OVERLOAD_ALERTS  5       // long window alert steps for OCRMON_OVERLOAD
+#define OCRMON_SHORT_ALERTS     16      // short window alert steps (of 32) for OCRMON_SHORT
+
+// monitored output mask bit of an output (OUT_1 ... OUT_15)
+#define OCRMON_OUT(output)      (1U << (output))
+#define OCRMON_ALL_OUTS         (OCRMON_OUT(OUT_1) | OCRMON_OUT(OUT_2) | OCRMON_OUT(OUT_3) | \
+                                 OCRMON_OUT(OUT_6) | OCRMON_OUT(OUT_7) | OCRMON_OUT(OUT_8) | \
+                                 OCRMON_OUT(OUT_15))
+
+// output classes
+#define OCRMON_NORMAL           0       // no overcurrent recovery alerts
+#define OCRMON_INRUSH           1       // alerts at turn-on only
+#define OCRMON_OVERLOAD         2       // repeated alerts while on
+#define OCRMON_SHORT            3       // persistent alerts, output off
+
+/**
+ * Overcurrent recovery statistics of an output.
+ */
+typedef struct
+{
+    uint32_t history;               ///< short window, 1 bit per step (bit 0 = last step)
+    uint8_t buckets[OCRMON_BUCKETS];    ///< long window alert steps per bucket
+    uint16_t alerts;                ///< alert steps since OcrMon_Begin()/OcrMon_Reset()
+    uint16_t inrush_alerts;         ///< alert steps within the turn-on inrush time
+    uint32_t on_time;               ///< time (mS) the output last turned on
+    uint8_t output_type;            ///< output control type at the last step
+    uint8_t out_class;              ///< output class (OCRMON_...)
+} OcrMonStats;
+
+/**
+ * DLK_OCRMonitor Arduino L99DZ200G overcurrent autorecovery monitor class.
+ */
+class DLK_OCRMonitor
+{
+    public:
+        // Constructor
+        /**
+         *  A constructor that sets up the overcurrent autorecovery monitor.
+         *
+         *  \param l99dz200g: the L99DZ200G driving the loads
+         *
+         *  \return None.
+         */
+        DLK_OCRMonitor(DLK_L99DZ200G & l99dz200g);
+
+        /**
+         * Start monitoring outputs (call after the autorecovery is configured). The present
+         * autorecovery on times and frequencies are kept as the normal settings - CR8.
+         *
+         * \param outputs: the outputs to monitor: OCRMON_OUT(OUT_1), OCRMON_OUT(OUT_2),
+         *                 OCRMON_OUT(OUT_3), OCRMON_OUT(OUT_6), OCRMON_OUT(OUT_7),
+         *                 OCRMON_OUT(OUT_8), OCRMON_OUT(OUT_15) or'ed together, or
+         *                 OCRMON_ALL_OUTS
+         *
+         *  \return None.
+         */
+        void OcrMon_Begin(uint16_t outputs);
+
+        /**
+         * Run a monitor step (call often from loop()). Does nothing until the next
+         * OCRMON_STEP_MS step.
+         *
+         *  \return None.
+         */
+        void OcrMon_Tick(void);
+
+        /**
+         * Clear an output's statistics and class, re-enabling its autorecovery if it was
+         * shorted (the output is left off) - CR7.
+         *
+         * \param output: the output: (OUT_1, OUT_2, OUT_3, OUT_6, OUT_7, OUT_8, OUT_15)
+         *
+         *  \return None.
+         */
+        void OcrMon_Reset(uint8_t output);
+
+        /**
+         * Get an output's class.
+         *
+         * \param output: the output: (OUT_1, OUT_2, OUT_3, OUT_6, OUT_7, OUT_8, OUT_15)
+         *
+         * \return   uint8_t = the class:
+         *                     (OCRMON_NORMAL, OCRMON_INRUSH, OCRMON_OVERLOAD, OCRMON_SHORT)
+         */
+        uint8_t OcrMon_Class(uint8_t output);
+
+        /**
+         * Get an output's overcurrent recovery statistics.
+         *
+         * \param output: the output: (OUT_1, OUT_2, OUT_3, OUT_6, OUT_7, OUT_8, OUT_15)
+         *
+         * \return   const OcrMonStats * = the statistics (NULL for an invalid output)
+         */
+        const OcrMonStats * OcrMon_Stats(uint8_t output);
+
+        /**
+         * Get an output's alert steps in the long window (not counting turn-on inrush).
+         *
+         * \param output: the output: (OUT_1, OUT_2, OUT_3, OUT_6, OUT_7, OUT_8, OUT_15)
+         *
+         * \return   uint16_t = the alert steps
+         */
+        uint16_t OcrMon_WindowAlerts(uint8_t output);
+
+    private:
+        /// L99DZ200G driving the loads
+        DLK_L99DZ200G * L99;
+
+        /// monitored outputs (OCRMON_OUT() bits)
+        uint16_t Outputs;
+
+        /// statistics of each output
+        OcrMonStats Stats[OCRMON_OUTPUTS];
+
+        /// normal CR8 autorecovery on time and frequency fields
+        uint32_t NormalCr8;
+
+        /// class the CR8 settings of each recovery group are set for
+        uint8_t GroupClass[4];
+
+        /// present long window bucket
+        uint8_t Bucket;
+
+        /// time (mS) the present bucket started
+        uint32_t BucketStart;
+
+        /// time (mS) of the last step
+        uint32_t LastStep;
+
+        /// Get the statistics index of an output (-1 = not an autorecovery output)
+        static int8_t OcrMon_Index(uint8_t output);
+
+        /// Set the CR8 settings of the recovery groups for their outputs' classes
+        void OcrMon_UpdateGroups(void);
+};
+#endif  // __DLK_OCRMONITOR_H__
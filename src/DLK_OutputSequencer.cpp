@@ -0,0 +1,339 @@
+/** \file DLK_OutputSequencer.cpp */
+/*
+ * NAME: DLK_OutputSequencer.cpp
+ *
+ * WHAT:
+ *  Arduino L99DZ200G staggered output turn-on functions.
+ *
+ * SPECIAL CONSIDERATIONS:
+ *  None.
+ *
+ * AUTHOR:
+ *  D.L. Karmann
+ *
+ * MODIFIED:
+ *
+ */
+
+#include "DLK_OutputSequencer.h"
+
+// DLK_OutputSequencer Class members
+
+// Constructor
+DLK_OutputSequencer::DLK_OutputSequencer(DLK_L99DZ200G & l99dz200g)
+{
+    L99 = &l99dz200g;
+    StepCount = 0;
+    StartTime = 0;
+    Faults = 0;
+}
+
+// Start a turn-on sequence
+uint8_t DLK_OutputSequencer::OutSeq_Start(const OutSeqStep * steps, uint8_t count)
+{
+    if ((count == 0) || (count > OUTSEQ_MAX_STEPS))
+    {
+        return L99DZ200G_FAIL;
+    }
+
+    OutSeq_Stop();
+
+    memcpy(Steps, steps, count * sizeof(OutSeqStep));
+    memset(StepState, OUTSEQ_WAIT, sizeof(StepState));
+    memset(StepRaised, 0, sizeof(StepRaised));
+    StepCount = count;
+    Faults = 0;
+    StartTime = millis();
+
+    OutSeq_Tick();      // steps at offset 0 turn on now
+    return L99DZ200G_OK;
+}
+
+// Run a turn-on sequence to its end
+uint8_t DLK_OutputSequencer::OutSeq_Run(const OutSeqStep * steps, uint8_t count)
+{
+    if (OutSeq_Start(steps, count) != L99DZ200G_OK)
+    {
+        return L99DZ200G_FAIL;
+    }
+
+    while (OutSeq_Busy())
+    {
+        L99->L99DZ200G_Delay(1);
+        OutSeq_Tick();
+    }
+
+    return (Faults == 0) ? L99DZ200G_OK : L99DZ200G_FAIL;
+}
+
+// Step the running sequence
+void DLK_OutputSequencer::OutSeq_Tick(void)
+{
+    L99DZ200GOutputSetting settings[OUTSEQ_MAX_STEPS];
+    uint8_t on_steps[OUTSEQ_MAX_STEPS];
+    uint8_t cnt = 0;
+    uint8_t restore_cnt = 0;
+    uint32_t elapsed;
+
+    if (StepCount == 0)
+    {
+        return;
+    }
+
+    elapsed = millis() - StartTime;
+
+    // find steps to turn on and inrush windows that ended
+    for (uint8_t i = 0; i < StepCount; ++i)
+    {
+        if ((StepState[i] == OUTSEQ_WAIT) && (elapsed >= Steps[i].offset_ms))
+        {
+            on_steps[cnt] = i;
+            settings[cnt].output = Steps[i].output;
+            settings[cnt].output_type = Steps[i].output_type;
+            ++cnt;
+        }
+        else if ((StepState[i] == OUTSEQ_INRUSH) &&
+                 (elapsed >= ((uint32_t)Steps[i].offset_ms + Steps[i].inrush_ms)))
+        {
+            ++restore_cnt;
+        }
+    }
+
+    if ((cnt == 0) && (restore_cnt == 0))
+    {
+        return;         // nothing to do (no SPI traffic)
+    }
+
+    L99->L99DZ200G_BeginSession();
+
+    if (restore_cnt != 0)
+    {
+        for (uint8_t i = 0; i < StepCount; ++i)
+        {
+            if ((StepState[i] == OUTSEQ_INRUSH) &&
+                (elapsed >= ((uint32_t)Steps[i].offset_ms + Steps[i].inrush_ms)))
+            {
+                OutSeq_Restore(i);
+            }
+        }
+    }
+
+    if (cnt != 0)
+    {
+        // protect the outputs before they see their inrush, then turn them on together
+        for (uint8_t i = 0; i < cnt; ++i)
+        {
+            OutSeq_Raise(on_steps[i]);
+            StepState[on_steps[i]] = OUTSEQ_INRUSH;
+        }
+        if (L99->L99DZ200G_OutputsControl(settings, cnt) != L99DZ200G_OK)
+        {
+            // invalid output or output type, nothing was turned on
+            for (uint8_t i = 0; i < cnt; ++i)
+            {
+                Faults |= OUTSEQ_OUT(settings[i].output);
+            }
+        }
+    }
+
+    L99->L99DZ200G_EndSession();
+
+    // sequence done when every step is done
+    for (uint8_t i = 0; i < StepCount; ++i)
+    {
+        if (StepState[i] != OUTSEQ_DONE)
+        {
+            return;
+        }
+    }
+    StepCount = 0;
+}
+
+// Stop the running sequence, restoring any inrush protections now
+void DLK_OutputSequencer::OutSeq_Stop(void)
+{
+    if (StepCount == 0)
+    {
+        return;
+    }
+
+    L99->L99DZ200G_BeginSession();
+    for (uint8_t i = 0; i < StepCount; ++i)
+    {
+        if (StepState[i] == OUTSEQ_INRUSH)
+        {
+            OutSeq_Restore(i);
+        }
+    }
+    L99->L99DZ200G_EndSession();
+
+    StepCount = 0;
+}
+
+// Check if a sequence is running
+bool DLK_OutputSequencer::OutSeq_Busy(void)
+{
+    return StepCount != 0;
+}
+
+// Get the outputs that faulted in the last sequence
+uint32_t DLK_OutputSequencer::OutSeq_Faults(void)
+{
+    return Faults;
+}
+
+// Set the inrush protection of a step's output
+void DLK_OutputSequencer::OutSeq_Raise(uint8_t step)
+{
+    uint8_t output = Steps[step].output;
+    uint32_t mask;
+    uint32_t reg_data;
+
+    // overcurrent threshold in low current mode -> high current mode
+    mask = OutSeq_OcMask(output);
+    if (mask != 0)
+    {
+        if (L99->L99DZ200G_GetShadowRegister(L99DZ200G_CR9, &reg_data) != L99DZ200G_OK)
+        {
+            reg_data = L99->L99DZ200G_ReadRegister(L99DZ200G_CR9);
+        }
+        if (reg_data & mask)
+        {
+            L99->L99DZ200G_OvercurrentThresholdControl(output, HI_CURRENT_MODE);
+            StepRaised[step] |= OUTSEQ_RAISED_OC;
+        }
+    }
+
+    // overcurrent autorecovery disabled -> enabled
+    mask = OutSeq_OcrMask(output);
+    if (mask != 0)
+    {
+        if (L99->L99DZ200G_GetShadowRegister(L99DZ200G_CR7, &reg_data) != L99DZ200G_OK)
+        {
+            reg_data = L99->L99DZ200G_ReadRegister(L99DZ200G_CR7);
+        }
+        if ((reg_data & mask) == 0)
+        {
+            L99->L99DZ200G_Set_OCR_AutorecoveryControl(output, ENABLE);
+            StepRaised[step] |= OUTSEQ_RAISED_OCR;
+        }
+    }
+}
+
+// Restore the inrush protection of a step's output and check it for overcurrent shutdown
+void DLK_OutputSequencer::OutSeq_Restore(uint8_t step)
+{
+    uint8_t output = Steps[step].output;
+    uint8_t ocs_item1 = 0;
+    uint8_t ocs_item2 = 0;
+
+    if (StepRaised[step] & OUTSEQ_RAISED_OC)
+    {
+        L99->L99DZ200G_OvercurrentThresholdControl(output, LO_CURRENT_MODE);
+    }
+    if (StepRaised[step] & OUTSEQ_RAISED_OCR)
+    {
+        L99->L99DZ200G_Set_OCR_AutorecoveryControl(output, DISABLE);
+    }
+    StepRaised[step] = 0;
+    StepState[step] = OUTSEQ_DONE;
+
+    switch (output)
+    {
+        case OUT_1:
+            ocs_item1 = OUT_1_HS;
+            ocs_item2 = OUT_1_LS;
+            break;
+        case OUT_2:
+            ocs_item1 = OUT_2_HS;
+            ocs_item2 = OUT_2_LS;
+            break;
+        case OUT_3:
+            ocs_item1 = OUT_3_HS;
+            ocs_item2 = OUT_3_LS;
+            break;
+        case OUT_6:
+            ocs_item1 = OUT_6_HS;
+            ocs_item2 = OUT_6_LS;
+            break;
+        case OUT_7:
+            ocs_item1 = OUT_7_OC;
+            break;
+        case OUT_8:
+            ocs_item1 = OUT_8_OC;
+            break;
+        case OUT_9:
+            ocs_item1 = OUT_9_OC;
+            break;
+        case OUT_10:
+            ocs_item1 = OUT_10_OC;
+            break;
+        case OUT_13:
+            ocs_item1 = OUT_13_OC;
+            break;
+        case OUT_14:
+            ocs_item1 = OUT_14_OC;
+            break;
+        case OUT_15:
+            ocs_item1 = OUT_15_OC;
+            break;
+        default:
+            return;     // no overcurrent shutdown status (OUT_GH)
+    }
+
+    // still shut down after the inrush window -> a real fault
+    if (L99->L99DZ200G_GetOvercurrentShutdownStatus(ocs_item1) != L99DZ200G_OK)
+    {
+        L99->L99DZ200G_ClearOvercurrentShutdownStatus(ocs_item1);
+        Faults |= OUTSEQ_OUT(output);
+    }
+    if ((ocs_item2 != 0) && (L99->L99DZ200G_GetOvercurrentShutdownStatus(ocs_item2) != L99DZ200G_OK))
+    {
+        L99->L99DZ200G_ClearOvercurrentShutdownStatus(ocs_item2);
+        Faults |= OUTSEQ_OUT(output);
+    }
+}
+
+// Get the CR9 overcurrent threshold mask of an output (0 = none)
+uint32_t DLK_OutputSequencer::OutSeq_OcMask(uint8_t output)
+{
+    switch (output)
+    {
+        case OUT_9:
+            return CR9_OUT9_OC_MASK;
+        case OUT_10:
+            return CR9_OUT10_OC_MASK;
+        case OUT_13:
+            return CR9_OUT13_OC_MASK;
+        case OUT_14:
+            return CR9_OUT14_OC_MASK;
+        case OUT_15:
+            return CR9_OUT15_OC_MASK;
+        default:
+            return 0;
+    }
+}
+
+// Get the CR7 overcurrent autorecovery mask of an output (0 = none)
+uint32_t DLK_OutputSequencer::OutSeq_OcrMask(uint8_t output)
+{
+    switch (output)
+    {
+        case OUT_1:
+            return CR7_OUT1_OCR_MASK;
+        case OUT_2:
+            return CR7_OUT2_OCR_MASK;
+        case OUT_3:
+            return CR7_OUT3_OCR_MASK;
+        case OUT_6:
+            return CR7_OUT6_OCR_MASK;
+        case OUT_7:
+            return CR7_OUT7_OCR_MASK;
+        case OUT_8:
+            return CR7_OUT8_OCR_MASK;
+        case OUT_15:
+            return CR7_OUT15_OCR_MASK;
+        default:
+            return 0;
+    }
+}
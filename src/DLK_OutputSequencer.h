@@ -0,0 +1,164 @@
+/** \file DLK_OutputSequencer.h */
+/*
+ * NAME: DLK_OutputSequencer.h
+ *
+ * WHAT:
+ *  Header file for DLK_OutputSequencer Arduino L99DZ200G staggered output turn-on class.
+ *
+ *  Turning on several bulb or heater loads at the same time adds up their inrush currents
+ *  and can trip the overcurrent shutdown of the outputs. The sequencer turns a load group
+ *  on step by step, each step at its own offset from the start of the sequence, and
+ *  protects each output against its own inrush for the step's inrush window:
+ *   - OUT9, OUT10, OUT13, OUT14, OUT15: overcurrent threshold set to high current mode
+ *     (L99DZ200G_OvercurrentThresholdControl, CR9)
+ *   - OUT1, OUT2, OUT3, OUT6, OUT7, OUT8, OUT15: overcurrent autorecovery enabled
+ *     (L99DZ200G_Set_OCR_AutorecoveryControl, CR7)
+ *  Only protections that were not already set are changed, and they are restored when
+ *  the inrush window ends. An output still in overcurrent shutdown after its inrush
+ *  window is reported as faulted and its shutdown status is cleared.
+ *
+ * SPECIAL CONSIDERATIONS:
+ *  Steps with the same offset are switched on in the same SPI frame(s).
+ *  The sequence is stepped by OutSeq_Tick() (call often from loop()) or run to its end
+ *  by OutSeq_Run().
+ *
+ * AUTHOR:
+ *  D.L. Karmann
+ *
+ */
+#ifndef __DLK_OUTPUTSEQUENCER_H__
+#define __DLK_OUTPUTSEQUENCER_H__
+
+#include "Arduino.h"
+#include "DLK_L99DZ200G.h"
+
+#define OUTSEQ_MAX_STEPS        8       // steps in a sequence
+
+// output fault mask bit of an output (OUT_1 ... OUT_GH)
+#define OUTSEQ_OUT(output)      (1UL << (output))
+
+// step states
+#define OUTSEQ_WAIT             0       // waiting for its offset
+#define OUTSEQ_INRUSH           1       // turned on, inrush protection set
+#define OUTSEQ_DONE             2       // inrush protection restored
+
+// inrush protections changed by a step
+#define OUTSEQ_RAISED_OC        0x01    // overcurrent threshold set to high current mode
+#define OUTSEQ_RAISED_OCR       0x02    // overcurrent autorecovery enabled
+
+/**
+ * One step of an output turn-on sequence.
+ */
+typedef struct
+{
+    uint8_t output;         ///< the output: (OUT_1, OUT_2, OUT_3, OUT_6 to OUT_10, OUT_13 to OUT_15, OUT_GH)
+    uint8_t output_type;    ///< the output control type (as for L99DZ200G_OutputsControl())
+    uint16_t offset_ms;     ///< turn on time from the start of the sequence (mS)
+    uint16_t inrush_ms;     ///< time the inrush protection is kept after turn on (mS)
+} OutSeqStep;
+
+/**
+ * DLK_OutputSequencer Arduino L99DZ200G staggered output turn-on class.
+ */
+class DLK_OutputSequencer
+{
+    public:
+        // Constructor
+        /**
+         *  A constructor that sets up the output turn-on sequencer.
+         *
+         *  \param l99dz200g: the L99DZ200G driving the loads
+         *
+         *  \return None.
+         */
+        DLK_OutputSequencer(DLK_L99DZ200G & l99dz200g);
+
+        /**
+         * Start a turn-on sequence (a running sequence is stopped first).
+         *
+         * \param steps: the sequence steps (copied)
+         * \param count: the number of steps: (1 to OUTSEQ_MAX_STEPS)
+         *
+         * \return   L99DZ200G_OK = the sequence was started
+         * \return   L99DZ200G_FAIL = invalid count
+         */
+        uint8_t OutSeq_Start(const OutSeqStep * steps, uint8_t count);
+
+        /**
+         * Run a turn-on sequence to its end (servicing the watchdog while waiting).
+         *
+         * \param steps: the sequence steps
+         * \param count: the number of steps: (1 to OUTSEQ_MAX_STEPS)
+         *
+         * \return   L99DZ200G_OK = all the outputs turned on
+         * \return   L99DZ200G_FAIL = invalid count or an output faulted (see OutSeq_Faults())
+         */
+        uint8_t OutSeq_Run(const OutSeqStep * steps, uint8_t count);
+
+        /**
+         * Step the running sequence (call often from loop()). Makes no SPI transfers
+         * unless a step turns on or an inrush window ends.
+         *
+         *  \return None.
+         */
+        void OutSeq_Tick(void);
+
+        /**
+         * Stop the running sequence, restoring any inrush protections now (outputs already
+         * turned on are left on).
+         *
+         *  \return None.
+         */
+        void OutSeq_Stop(void);
+
+        /**
+         * Check if a sequence is running.
+         *
+         * \return   true = a sequence is running
+         * \return   false = no sequence is running
+         */
+        bool OutSeq_Busy(void);
+
+        /**
+         * Get the outputs that faulted in the last sequence.
+         *
+         * \return   uint32_t = OUTSEQ_OUT() mask of the outputs that were in overcurrent
+         *                      shutdown after their inrush window or could not be set
+         */
+        uint32_t OutSeq_Faults(void);
+
+    private:
+        /// L99DZ200G driving the loads
+        DLK_L99DZ200G * L99;
+
+        /// the sequence steps
+        OutSeqStep Steps[OUTSEQ_MAX_STEPS];
+
+        /// state of each step (OUTSEQ_WAIT, ...)
+        uint8_t StepState[OUTSEQ_MAX_STEPS];
+
+        /// inrush protections changed by each step (OUTSEQ_RAISED_...)
+        uint8_t StepRaised[OUTSEQ_MAX_STEPS];
+
+        /// number of sequence steps
+        uint8_t StepCount;
+
+        /// time (mS) the sequence started
+        uint32_t StartTime;
+
+        /// outputs that faulted
+        uint32_t Faults;
+
+        /// Set the inrush protection of a step's output
+        void OutSeq_Raise(uint8_t step);
+
+        /// Restore the inrush protection of a step's output and check it for overcurrent shutdown
+        void OutSeq_Restore(uint8_t step);
+
+        /// Get the CR9 overcurrent threshold mask of an output (0 = none)
+        static uint32_t OutSeq_OcMask(uint8_t output);
+
+        /// Get the CR7 overcurrent autorecovery mask of an output (0 = none)
+        static uint32_t OutSeq_OcrMask(uint8_t output);
+};
+#endif  // __DLK_OUTPUTSEQUENCER_H__
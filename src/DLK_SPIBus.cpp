@@ -0,0 +1,290 @@
+/** \file DLK_SPIBus.cpp */
+/*
+ * NAME: DLK_SPIBus.cpp
+ *
+ * WHAT:
+ *  Arduino shared SPI bus arbiter functions.
+ *
+ * SPECIAL CONSIDERATIONS:
+ *  Bus ownership is changed with interrupts masked so a device may also check/request
+ *  the bus from an interrupt handler.
+ *
+ * AUTHOR:
+ *  D.L. Karmann
+ *
+ * MODIFIED:
+ *
+ */
+
+#include <SPI.h>
+#include "DLK_SPIBus.h"
+
+#ifdef __AVR__
+#define SPIBUS_LOCK()       uint8_t sreg_save = SREG; cli()
+#define SPIBUS_UNLOCK()     SREG = sreg_save
+#else
+#define SPIBUS_LOCK()       noInterrupts()
+#define SPIBUS_UNLOCK()     interrupts()
+#endif
+
+// DLK_SPIBus Class members
+
+// Constructor
+DLK_SPIBus::DLK_SPIBus(SPIClass & spi)
+{
+    SPI_dev = &spi;
+    SPI_initted = false;
+    DevCount = 0;
+    Owner = SPIBUS_NO_DEVICE;
+    Depth = 0;
+    Servicing = false;
+}
+
+// Initialize the SPI peripheral (once)
+void DLK_SPIBus::SPIBus_Begin(void)
+{
+    if (!SPI_initted)
+    {
+        SPI_dev->begin();
+        SPI_initted = true;
+    }
+}
+
+// Get the SPI peripheral owned by the arbiter
+SPIClass * DLK_SPIBus::SPIBus_SPI(void)
+{
+    return SPI_dev;
+}
+
+// Register a device on the bus
+uint8_t DLK_SPIBus::SPIBus_AddDevice(uint32_t spi_speed, uint8_t priority)
+{
+    uint8_t dev;
+
+    if (DevCount >= SPIBUS_MAX_DEVICES)
+    {
+        return SPIBUS_NO_DEVICE;
+    }
+
+    dev = DevCount++;
+    if (spi_speed == SPIBUS_EXTERNAL)
+    {
+        DevExternal[dev] = true;
+    }
+    else
+    {
+        SPISettings spi_settings(spi_speed, MSBFIRST, SPI_MODE0);
+        DevSettings[dev] = spi_settings;
+        DevExternal[dev] = false;
+    }
+    DevPriority[dev] = priority;
+    DevRequest[dev] = SPIBUS_NO_REQUEST;
+    DevHandler[dev] = NULL;
+    DevHandlerArg[dev] = NULL;
+    memset(&DevStats[dev], 0, sizeof(SPIBusStats));
+
+    return dev;
+}
+
+// Set the handler called when a queued request of the device gets the bus
+void DLK_SPIBus::SPIBus_SetPendingHandler(uint8_t dev, SPIBusHandler handler, void * arg)
+{
+    if (dev < DevCount)
+    {
+        DevHandler[dev] = handler;
+        DevHandlerArg[dev] = arg;
+    }
+}
+
+// Change the SPI clock of a device
+void DLK_SPIBus::SPIBus_SetSpeed(uint8_t dev, uint32_t spi_speed)
+{
+    if ((dev < DevCount) && !DevExternal[dev] && (spi_speed != SPIBUS_EXTERNAL))
+    {
+        SPISettings spi_settings(spi_speed, MSBFIRST, SPI_MODE0);
+        DevSettings[dev] = spi_settings;
+    }
+}
+
+// Acquire the bus for a device
+bool DLK_SPIBus::SPIBus_Acquire(uint8_t dev)
+{
+    bool acquired = false;
+    bool nested = false;
+
+    if (dev >= DevCount)
+    {
+        return false;
+    }
+
+    SPIBUS_LOCK();
+    if (Owner == SPIBUS_NO_DEVICE)
+    {
+        Owner = dev;
+        Depth = 1;
+        acquired = true;
+    }
+    else if (Owner == dev)
+    {
+        ++Depth;        // batching frames under the current transaction
+        nested = true;
+    }
+    SPIBUS_UNLOCK();
+
+    if (nested)
+    {
+        return true;
+    }
+
+    if (!acquired)
+    {
+        ++DevStats[dev].contentions;
+        return false;
+    }
+
+    ++DevStats[dev].transactions;
+    AcquireTime = micros();
+    if (!DevExternal[dev])
+    {
+        SPI_dev->beginTransaction(DevSettings[dev]);
+    }
+    return true;
+}
+
+// Release the bus held by a device
+void DLK_SPIBus::SPIBus_Release(uint8_t dev)
+{
+    uint32_t hold;
+
+    if ((dev != Owner) || (Depth == 0))
+    {
+        return;
+    }
+
+    if (--Depth != 0)
+    {
+        return;         // still batching
+    }
+
+    if (!DevExternal[dev])
+    {
+        SPI_dev->endTransaction();
+    }
+
+    hold = micros() - AcquireTime;
+    DevStats[dev].hold_us += hold;
+    if (hold > DevStats[dev].max_hold_us)
+    {
+        DevStats[dev].max_hold_us = hold;
+    }
+
+    Owner = SPIBUS_NO_DEVICE;
+
+    SPIBus_ServicePending();
+}
+
+// Queue a request for a device, serviced by its pending handler
+void DLK_SPIBus::SPIBus_Request(uint8_t dev, uint8_t priority)
+{
+    if ((dev >= DevCount) || (DevHandler[dev] == NULL))
+    {
+        return;
+    }
+
+    if (SPIBus_BusyFor(dev))
+    {
+        ++DevStats[dev].contentions;
+    }
+
+    SPIBUS_LOCK();
+    if ((DevRequest[dev] == SPIBUS_NO_REQUEST) || (priority > DevRequest[dev]))
+    {
+        DevRequest[dev] = priority;
+    }
+    SPIBUS_UNLOCK();
+
+    if (Owner == SPIBUS_NO_DEVICE)
+    {
+        SPIBus_ServicePending();
+    }
+}
+
+// Check if the bus is held by a device other than the specified device
+bool DLK_SPIBus::SPIBus_BusyFor(uint8_t dev)
+{
+    uint8_t owner = Owner;
+
+    return (owner != SPIBUS_NO_DEVICE) && (owner != dev);
+}
+
+// Get the number of registered devices
+uint8_t DLK_SPIBus::SPIBus_DeviceCount(void)
+{
+    return DevCount;
+}
+
+// Get the bus statistics for a device
+void DLK_SPIBus::SPIBus_GetStats(uint8_t dev, SPIBusStats * stats)
+{
+    if (dev < DevCount)
+    {
+        *stats = DevStats[dev];
+    }
+    else
+    {
+        memset(stats, 0, sizeof(SPIBusStats));
+    }
+}
+
+// Clear the bus statistics of all devices
+void DLK_SPIBus::SPIBus_ClearStats(void)
+{
+    for (uint8_t i = 0; i < DevCount; ++i)
+    {
+        memset(&DevStats[i], 0, sizeof(SPIBusStats));
+    }
+}
+
+// Service queued requests, highest priority first
+void DLK_SPIBus::SPIBus_ServicePending(void)
+{
+    uint8_t dev;
+    uint8_t prio;
+
+    if (Servicing)
+    {
+        return;         // already servicing (handler released the bus)
+    }
+    Servicing = true;
+
+    while (Owner == SPIBUS_NO_DEVICE)
+    {
+        // find highest priority queued request
+        dev = SPIBUS_NO_DEVICE;
+        prio = 0;
+        for (uint8_t i = 0; i < DevCount; ++i)
+        {
+            if ((DevRequest[i] != SPIBUS_NO_REQUEST) &&
+                ((dev == SPIBUS_NO_DEVICE) || (DevRequest[i] > prio) ||
+                 ((DevRequest[i] == prio) && (DevPriority[i] > DevPriority[dev]))))
+            {
+                dev = i;
+                prio = DevRequest[i];
+            }
+        }
+        if (dev == SPIBUS_NO_DEVICE)
+        {
+            break;      // nothing queued
+        }
+
+        DevRequest[dev] = SPIBUS_NO_REQUEST;
+        ++DevStats[dev].deferred;
+        if (SPIBus_Acquire(dev))
+        {
+            DevHandler[dev](DevHandlerArg[dev]);
+            SPIBus_Release(dev);
+        }
+    }
+
+    Servicing = false;
+}
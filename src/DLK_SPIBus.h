@@ -0,0 +1,239 @@
+/** \file DLK_SPIBus.h */
+/*
+ * NAME: DLK_SPIBus.h
+ *
+ * WHAT:
+ *  Header file for DLK_SPIBus Arduino shared SPI bus arbiter class.
+ *
+ *  The arbiter owns the SPI peripheral for all devices on the bus (e.g. the L99DZ200G
+ *  and a MCP2515 CAN controller). Each device is registered with its own SPI clock and
+ *  a priority. Only one device may hold the bus at a time; a device that finds the bus
+ *  held by another device is counted as contention. A device with a pending handler may
+ *  queue a request instead, which is serviced (highest priority first) as soon as the
+ *  bus is released.
+ *
+ *  The same device may acquire the bus again while holding it, so multiple frames can be
+ *  batched under one SPI transaction.
+ *
+ * SPECIAL CONSIDERATIONS:
+ *  Devices whose library does its own beginTransaction()/endTransaction() (e.g. the
+ *  DLK_MCP2515 library) are registered with SPIBUS_EXTERNAL as the SPI clock; the arbiter
+ *  then only tracks bus ownership and statistics for them.
+ *
+ * AUTHOR:
+ *  D.L. Karmann
+ *
+ */
+#ifndef __DLK_SPIBUS_H__
+#define __DLK_SPIBUS_H__
+
+#include <SPI.h>
+
+#include "Arduino.h"
+
+#define SPIBUS_MAX_DEVICES  4
+#define SPIBUS_NO_DEVICE    0xFF
+#define SPIBUS_EXTERNAL     0           // device library handles its own SPI transactions
+
+// device/request priorities (highest serviced first)
+#define SPIBUS_PRIO_LOW     0
+#define SPIBUS_PRIO_NORMAL  1
+#define SPIBUS_PRIO_HIGH    2
+#define SPIBUS_PRIO_WDOG    3           // watchdog trigger, always serviced first
+
+#define SPIBUS_NO_REQUEST   0xFF
+
+/**
+ * Pending bus request handler, called with the bus acquired for the device.
+ *
+ * \param arg: the handler argument given to SPIBus_SetPendingHandler()
+ */
+typedef void (*SPIBusHandler)(void * arg);
+
+/**
+ * Shared SPI bus statistics for a device.
+ */
+typedef struct
+{
+    uint32_t transactions;      ///< times the bus was acquired
+    uint32_t hold_us;           ///< total time the bus was held (uS)
+    uint32_t max_hold_us;       ///< longest time the bus was held (uS)
+    uint32_t contentions;       ///< times the bus was held by another device when requested
+    uint32_t deferred;          ///< queued requests serviced when the bus was released
+} SPIBusStats;
+
+/**
+ * DLK_SPIBus Arduino shared SPI bus arbiter class.
+ */
+class DLK_SPIBus
+{
+    public:
+        // Constructor
+        /**
+         *  A constructor that sets up the shared SPI bus arbiter.
+         *
+         *  \param spi: the SPI peripheral owned by the arbiter
+         *
+         *  \return None.
+         */
+        DLK_SPIBus(SPIClass & spi);
+
+        /**
+         * Initialize the SPI peripheral (once).
+         *
+         *  \return None.
+         */
+        void SPIBus_Begin(void);
+
+        /**
+         * Get the SPI peripheral owned by the arbiter.
+         *
+         * \return   SPIClass * = the SPI peripheral
+         */
+        SPIClass * SPIBus_SPI(void);
+
+        /**
+         * Register a device on the bus.
+         *
+         * \param spi_speed: the maximum SPI clock (bps) of the device or SPIBUS_EXTERNAL
+         * \param priority: the device priority:
+         *              (SPIBUS_PRIO_LOW, SPIBUS_PRIO_NORMAL, SPIBUS_PRIO_HIGH)
+         *
+         * \return   uint8_t = the device ID, SPIBUS_NO_DEVICE = no room for device
+         */
+        uint8_t SPIBus_AddDevice(uint32_t spi_speed, uint8_t priority);
+
+        /**
+         * Set the handler called when a queued request of the device gets the bus.
+         *
+         * \param dev: the device ID
+         * \param handler: the pending request handler
+         * \param arg: the argument passed to the handler
+         *
+         *  \return None.
+         */
+        void SPIBus_SetPendingHandler(uint8_t dev, SPIBusHandler handler, void * arg);
+
+        /**
+         * Change the SPI clock of a device (takes effect the next time it acquires the bus).
+         *
+         * \param dev: the device ID
+         * \param spi_speed: the maximum SPI clock (bps) of the device
+         *
+         *  \return None.
+         */
+        void SPIBus_SetSpeed(uint8_t dev, uint32_t spi_speed);
+
+        /**
+         * Acquire the bus for a device (begins the device SPI transaction).
+         *
+         * \param dev: the device ID
+         *
+         * \return   true = the bus is held by the device
+         * \return   false = the bus is held by another device
+         */
+        bool SPIBus_Acquire(uint8_t dev);
+
+        /**
+         * Release the bus held by a device (ends the device SPI transaction) and
+         * service any queued requests.
+         *
+         * \param dev: the device ID
+         *
+         *  \return None.
+         */
+        void SPIBus_Release(uint8_t dev);
+
+        /**
+         * Queue a request for a device to be serviced by its pending handler when the bus
+         * is released (serviced immediately if the bus is free).
+         *
+         * \param dev: the device ID
+         * \param priority: the request priority:
+         *              (SPIBUS_PRIO_LOW, SPIBUS_PRIO_NORMAL, SPIBUS_PRIO_HIGH, SPIBUS_PRIO_WDOG)
+         *
+         *  \return None.
+         */
+        void SPIBus_Request(uint8_t dev, uint8_t priority);
+
+        /**
+         * Check if the bus is held by a device other than the specified device.
+         *
+         * \param dev: the device ID
+         *
+         * \return   true = the bus is held by another device
+         * \return   false = the bus is free or held by the device
+         */
+        bool SPIBus_BusyFor(uint8_t dev);
+
+        /**
+         * Get the number of registered devices.
+         *
+         * \return   uint8_t = the number of registered devices
+         */
+        uint8_t SPIBus_DeviceCount(void);
+
+        /**
+         * Get the bus statistics for a device.
+         *
+         * \param dev: the device ID
+         * \param stats: where to put the device bus statistics
+         *
+         *  \return None.
+         */
+        void SPIBus_GetStats(uint8_t dev, SPIBusStats * stats);
+
+        /**
+         * Clear the bus statistics of all devices.
+         *
+         *  \return None.
+         */
+        void SPIBus_ClearStats(void);
+
+    private:
+        /// Pointer to SPI device
+        SPIClass * SPI_dev;
+
+        /// Flag for SPI initialization
+        bool SPI_initted;
+
+        /// number of registered devices
+        uint8_t DevCount;
+
+        /// device holding the bus
+        volatile uint8_t Owner;
+
+        /// nested acquire count of device holding the bus
+        uint8_t Depth;
+
+        /// time (uS) the bus was acquired
+        uint32_t AcquireTime;
+
+        /// flag for servicing queued requests
+        bool Servicing;
+
+        /// SPI configuration settings of each device
+        SPISettings DevSettings[SPIBUS_MAX_DEVICES];
+
+        /// true = device handles its own SPI transactions
+        bool DevExternal[SPIBUS_MAX_DEVICES];
+
+        /// priority of each device
+        uint8_t DevPriority[SPIBUS_MAX_DEVICES];
+
+        /// queued request priority of each device (SPIBUS_NO_REQUEST = none)
+        volatile uint8_t DevRequest[SPIBUS_MAX_DEVICES];
+
+        /// pending request handler of each device
+        SPIBusHandler DevHandler[SPIBUS_MAX_DEVICES];
+
+        /// pending request handler argument of each device
+        void * DevHandlerArg[SPIBUS_MAX_DEVICES];
+
+        /// bus statistics of each device
+        SPIBusStats DevStats[SPIBUS_MAX_DEVICES];
+
+        /// Service queued requests, highest priority first
+        void SPIBus_ServicePending(void);
+};
+#endif  // __DLK_SPIBUS_H__
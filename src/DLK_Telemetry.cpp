@@ -0,0 +1,249 @@
+/** \file DLK_Telemetry.cpp */
+/*
+ * NAME: DLK_Telemetry.cpp
+ *
+ * WHAT:
+ *  Arduino L99DZ200G binary telemetry streaming functions.
+ *
+ * SPECIAL CONSIDERATIONS:
+ *  None.
+ *
+ * AUTHOR:
+ *  D.L. Karmann
+ *
+ * MODIFIED:
+ *
+ */
+
+#include "DLK_Telemetry.h"
+
+// status register and field of each filtered ADC value (TEMP_CL1 to TEMP_CL6, VSREG, VS, VWU)
+static const uint8_t TelemAdcReg[TELEM_ADC_COUNT] =
+{
+    L99DZ200G_SR7, L99DZ200G_SR7, L99DZ200G_SR8, L99DZ200G_SR8, L99DZ200G_SR9, L99DZ200G_SR9,
+    L99DZ200G_SR10, L99DZ200G_SR11, L99DZ200G_SR11
+};
+static const uint8_t TelemAdcPos[TELEM_ADC_COUNT] =
+{
+    ODD_TEMP_CL_POS, EVEN_TEMP_CL_POS, ODD_TEMP_CL_POS, EVEN_TEMP_CL_POS, ODD_TEMP_CL_POS, EVEN_TEMP_CL_POS,
+    VS_REG_POS, VS_POS, VWU_POS
+};
+
+// DLK_Telemetry Class members
+
+// Constructor
+DLK_Telemetry::DLK_Telemetry(DLK_L99DZ200G & l99dz200g)
+{
+    L99 = &l99dz200g;
+    Out = NULL;
+    Period = 0;
+    LastFrame = 0;
+    Seq = 0;
+    Dropped = 0;
+    memset(Filt, 0, sizeof(Filt));
+    FiltValid = false;
+    Handler = NULL;
+    HandlerArg = NULL;
+    FrameLen = 0;
+    FramePos = 0;
+}
+
+// Start streaming telemetry frames
+void DLK_Telemetry::Telem_Start(Print & out, uint16_t period_ms)
+{
+    Out = &out;
+    Period = (period_ms < TELEM_MIN_PERIOD_MS) ? TELEM_MIN_PERIOD_MS : period_ms;
+    Seq = 0xFFFF;           // first frame is 0
+    Dropped = 0;
+    FiltValid = false;
+    FrameLen = 0;
+    FramePos = 0;
+    LastFrame = millis();       // first frame one period from now
+}
+
+// Stop streaming telemetry frames
+void DLK_Telemetry::Telem_Stop(void)
+{
+    Out = NULL;
+    FrameLen = 0;
+    FramePos = 0;
+}
+
+// Check if telemetry frames are being streamed
+bool DLK_Telemetry::Telem_Running(void)
+{
+    return Out != NULL;
+}
+
+// Set the application channel handler
+void DLK_Telemetry::Telem_SetChannelHandler(TelemChannelHandler handler, void * arg)
+{
+    Handler = handler;
+    HandlerArg = arg;
+}
+
+// Run a telemetry step
+void DLK_Telemetry::Telem_Tick(void)
+{
+    int room;
+
+    if (Out == NULL)
+    {
+        return;
+    }
+
+    if (TIMER_EXPIRED(LastFrame, Period))
+    {
+        LastFrame += Period;
+        if (TIMER_EXPIRED(LastFrame, Period))
+        {
+            LastFrame = millis();       // fell behind, do not catch up with a burst
+        }
+
+        if (FramePos < FrameLen)
+        {
+            ++Seq;                      // the receiver sees the gap
+            if (Dropped < 0xFFFF)
+            {
+                ++Dropped;
+            }
+        }
+        else
+        {
+            Telem_Build();
+        }
+    }
+
+    // write as much of the frame as the output has room for
+    if (FramePos < FrameLen)
+    {
+        room = Out->availableForWrite();
+        if (room > (FrameLen - FramePos))
+        {
+            room = FrameLen - FramePos;
+        }
+        if (room > 0)
+        {
+            Out->write(&Frame[FramePos], room);
+            FramePos += room;
+        }
+    }
+}
+
+// Get the sequence number of the last frame built
+uint16_t DLK_Telemetry::Telem_Sequence(void)
+{
+    return Seq;
+}
+
+// Get the number of frames dropped
+uint16_t DLK_Telemetry::Telem_Dropped(void)
+{
+    return Dropped;
+}
+
+// Read the L99DZ200G status and build the next frame - SR1 to SR12
+void DLK_Telemetry::Telem_Build(void)
+{
+    uint8_t payload[TELEM_PAYLOAD_SIZE];
+    uint32_t sr[TELEM_SR_COUNT];
+    uint32_t now;
+    uint16_t val;
+    uint16_t crc;
+    uint8_t len = 0;
+
+    L99->L99DZ200G_BeginSession();
+    for (uint8_t i = 0; i < TELEM_SR_COUNT; ++i)
+    {
+        sr[i] = L99->L99DZ200G_ReadRegister(L99DZ200G_SR1 + i) & FULL_REG_MASK;
+    }
+    L99->L99DZ200G_EndSession();
+
+    ++Seq;
+    now = millis();
+    payload[len++] = TELEM_FRAME_STATUS;
+    payload[len++] = Seq & 0xFF;
+    payload[len++] = Seq >> 8;
+    for (uint8_t b = 0; b < 4; ++b)
+    {
+        payload[len++] = now >> (8 * b);
+    }
+    payload[len++] = L99->L99DZ200G_GlobalStatusByte();
+    for (uint8_t i = 0; i < TELEM_SR_COUNT; ++i)
+    {
+        payload[len++] = sr[i] & 0xFF;
+        payload[len++] = (sr[i] >> 8) & 0xFF;
+        payload[len++] = sr[i] >> 16;
+    }
+
+    // 10 bit ADC fields, low-pass filtered in 1/16 counts
+    for (uint8_t i = 0; i < TELEM_ADC_COUNT; ++i)
+    {
+        val = ((sr[TelemAdcReg[i] - L99DZ200G_SR1] >> TelemAdcPos[i]) & 0x3FF) << 4;
+        if (FiltValid)
+        {
+            Filt[i] = Filt[i] + (((int16_t)(val - Filt[i])) >> TELEM_FILTER_SHIFT);
+        }
+        else
+        {
+            Filt[i] = val;
+        }
+        payload[len++] = Filt[i] & 0xFF;
+        payload[len++] = Filt[i] >> 8;
+    }
+    FiltValid = true;
+
+    for (uint8_t ch = 0; ch < TELEM_CHANNELS; ++ch)
+    {
+        val = (Handler != NULL) ? Handler(ch, HandlerArg) : 0;
+        payload[len++] = val & 0xFF;
+        payload[len++] = val >> 8;
+    }
+
+    crc = Telem_Crc16(0xFFFF, payload, len);
+    payload[len++] = crc & 0xFF;
+    payload[len++] = crc >> 8;
+
+    FrameLen = Telem_Cobs(payload, len, Frame);
+    Frame[FrameLen++] = 0x00;       // frame delimiter
+    FramePos = 0;
+}
+
+// Add bytes to a CRC-16 (CCITT)
+uint16_t DLK_Telemetry::Telem_Crc16(uint16_t crc, const uint8_t * data, uint8_t len)
+{
+    while (len--)
+    {
+        crc ^= (uint16_t)*data++ << 8;
+        for (uint8_t b = 0; b < 8; ++b)
+        {
+            crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+// COBS encode a payload (up to 254 bytes, returns the encoded length without the delimiter)
+uint8_t DLK_Telemetry::Telem_Cobs(const uint8_t * src, uint8_t len, uint8_t * dst)
+{
+    uint8_t code_pos = 0;
+    uint8_t code = 1;
+    uint8_t out = 1;
+
+    for (uint8_t i = 0; i < len; ++i)
+    {
+        if (src[i] == 0x00)
+        {
+            dst[code_pos] = code;
+            code_pos = out++;
+            code = 1;
+        }
+        else
+        {
+            dst[out++] = src[i];
+            ++code;
+        }
+    }
+    dst[code_pos] = code;
+    return out;
+}
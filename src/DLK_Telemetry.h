@@ -0,0 +1,189 @@
+/** \file DLK_Telemetry.h */
+/*
+ * NAME: DLK_Telemetry.h
+ *
+ * WHAT:
+ *  Header file for DLK_Telemetry Arduino L99DZ200G binary telemetry streaming class.
+ *
+ *  Every telemetry period the L99DZ200G status is read (SR1 to SR12 in one SPI session) and
+ *  sent as one binary frame instead of ASCII hex text. Frame payload (little-endian):
+ *   - frame type (TELEM_FRAME_STATUS) (1)
+ *   - sequence number (2), a gap shows dropped frames
+ *   - millis() when the frame was built (4)
+ *   - GSB (1)
+ *   - SR1 to SR12 (3 each)
+ *   - thermal clusters TEMP_CL1 to TEMP_CL6 ADC counts, filtered (2 each)
+ *   - VSREG, VS, VWU ADC counts, filtered (2 each)
+ *   - TELEM_CHANNELS application channels, e.g. motor positions (2 each)
+ *   - CRC-16/CCITT of all the bytes before (init 0xFFFF, polynomial 0x1021) (2)
+ *  Filtered ADC counts are in 1/16 counts (first order low-pass filter, time constant
+ *  of 4 frames): Celsius = 350 - (0.488 * counts), Volts = 22 * counts / 1024.
+ *
+ *  Frames are COBS encoded (Consistent Overhead Byte Stuffing, no 0x00 bytes) and each one
+ *  is followed by a 0x00 delimiter, so a receiver can resynchronize at any 0x00. See
+ *  extras/TelemetryDecoder for a host decoder.
+ *
+ * SPECIAL CONSIDERATIONS:
+ *  Telem_Tick() never blocks: a frame is written only as the output has room
+ *  (availableForWrite()) over the following ticks. A frame due while the previous one is
+ *  still being written is dropped (counted, and the sequence number skips).
+ *  Other output to the same Print while streaming corrupts the frame being written (the
+ *  receiver drops it on the CRC).
+ *
+ * AUTHOR:
+ *  D.L. Karmann
+ *
+ */
+#ifndef __DLK_TELEMETRY_H__
+#define __DLK_TELEMETRY_H__
+
+#include "Arduino.h"
+#include "DLK_L99DZ200G.h"
+
+#define TELEM_CHANNELS          4       // application channels per frame
+#define TELEM_MIN_PERIOD_MS     10      // shortest telemetry period (mS)
+#define TELEM_FILTER_SHIFT      2       // ADC count filter time constant (2^n frames)
+#define TELEM_SR_COUNT          12      // SR1 to SR12
+#define TELEM_ADC_COUNT         9       // TEMP_CL1 to TEMP_CL6, VSREG, VS, VWU
+
+// frame types
+#define TELEM_FRAME_STATUS      1       // L99DZ200G status frame (version 1)
+
+// frame payload size (with the CRC) and COBS encoded size (with the delimiter)
+#define TELEM_PAYLOAD_SIZE      (8 + (TELEM_SR_COUNT * 3) + (TELEM_ADC_COUNT * 2) + (TELEM_CHANNELS * 2) + 2)
+#define TELEM_FRAME_SIZE        (TELEM_PAYLOAD_SIZE + 2)
+
+/**
+ * Telemetry application channel handler.
+ *
+ * \param channel: the channel: (0 to TELEM_CHANNELS - 1)
+ * \param arg: the handler argument
+ *
+ * \return   uint16_t = the channel value
+ */
+typedef uint16_t (*TelemChannelHandler)(uint8_t channel, void * arg);
+
+/**
+ * DLK_Telemetry Arduino L99DZ200G binary telemetry streaming class.
+ */
+class DLK_Telemetry
+{
+    public:
+        // Constructor
+        /**
+         *  A constructor that sets up the (stopped) telemetry stream.
+         *
+         *  \param l99dz200g: the L99DZ200G to report
+         *
+         *  \return None.
+         */
+        DLK_Telemetry(DLK_L99DZ200G & l99dz200g);
+
+        /**
+         * Start streaming telemetry frames (restarts the sequence number and filters).
+         *
+         * \param out: where to write the frames (must support availableForWrite(), e.g. Serial)
+         * \param period_ms: the telemetry period (TELEM_MIN_PERIOD_MS to 65535 mS)
+         *
+         *  \return None.
+         */
+        void Telem_Start(Print & out, uint16_t period_ms);
+
+        /**
+         * Stop streaming telemetry frames (a frame being written is abandoned).
+         *
+         *  \return None.
+         */
+        void Telem_Stop(void);
+
+        /**
+         * Check if telemetry frames are being streamed.
+         *
+         * \return   true = streaming
+         * \return   false = stopped
+         */
+        bool Telem_Running(void);
+
+        /**
+         * Set the handler giving the application channel values (called for each channel as
+         * a frame is built).
+         *
+         * \param handler: the channel handler, NULL = channels sent as 0
+         * \param arg: the handler argument
+         *
+         *  \return None.
+         */
+        void Telem_SetChannelHandler(TelemChannelHandler handler, void * arg);
+
+        /**
+         * Run a telemetry step (call often from loop()). Writes what the output has room for,
+         * and builds the next frame when due - SR1 to SR12.
+         *
+         *  \return None.
+         */
+        void Telem_Tick(void);
+
+        /**
+         * Get the sequence number of the last frame built.
+         *
+         * \return   uint16_t = the sequence number
+         */
+        uint16_t Telem_Sequence(void);
+
+        /**
+         * Get the number of frames dropped (output too slow) since Telem_Start().
+         *
+         * \return   uint16_t = the frames dropped (saturates at 65535)
+         */
+        uint16_t Telem_Dropped(void);
+
+    private:
+        /// L99DZ200G to report
+        DLK_L99DZ200G * L99;
+
+        /// telemetry output (NULL = stopped)
+        Print * Out;
+
+        /// telemetry period (mS)
+        uint16_t Period;
+
+        /// time (mS) the last frame was due
+        uint32_t LastFrame;
+
+        /// sequence number of the last frame
+        uint16_t Seq;
+
+        /// frames dropped
+        uint16_t Dropped;
+
+        /// filtered ADC counts (1/16 counts)
+        uint16_t Filt[TELEM_ADC_COUNT];
+
+        /// true = filters hold a value
+        bool FiltValid;
+
+        /// application channel handler
+        TelemChannelHandler Handler;
+
+        /// application channel handler argument
+        void * HandlerArg;
+
+        /// COBS encoded frame being written
+        uint8_t Frame[TELEM_FRAME_SIZE];
+
+        /// bytes in the frame being written
+        uint8_t FrameLen;
+
+        /// bytes of the frame written
+        uint8_t FramePos;
+
+        /// Read the L99DZ200G status and build the next frame
+        void Telem_Build(void);
+
+        /// Add bytes to a CRC-16 (CCITT)
+        static uint16_t Telem_Crc16(uint16_t crc, const uint8_t * data, uint8_t len);
+
+        /// COBS encode a payload (returns the encoded length, without the delimiter)
+        static uint8_t Telem_Cobs(const uint8_t * src, uint8_t len, uint8_t * dst);
+};
+#endif  // __DLK_TELEMETRY_H__
@@ -0,0 +1,183 @@
+/** \file DLK_ThermalDerating.cpp */
+/*
+ * NAME: DLK_ThermalDerating.cpp
+ *
+ * WHAT:
+ *  Arduino L99DZ200G thermal derating manager functions.
+ *
+ * SPECIAL CONSIDERATIONS:
+ *  None.
+ *
+ * AUTHOR:
+ *  D.L. Karmann
+ *
+ * MODIFIED:
+ *
+ */
+
+#include "DLK_ThermalDerating.h"
+
+// DLK_ThermalDerating Class members
+
+// Constructor
+DLK_ThermalDerating::DLK_ThermalDerating(DLK_L99DZ200G & l99dz200g)
+{
+    L99 = &l99dz200g;
+    memset(ChanCluster, DERATE_NO_CLUSTER, sizeof(ChanCluster));
+    memset(Nominal, 0, sizeof(Nominal));
+    memset(Written, 0, sizeof(Written));
+    memset(TwLimit, 100, sizeof(TwLimit));
+    memset(Limit, 100, sizeof(Limit));
+    for (uint8_t cl = TEMP_CL1; cl <= TEMP_CL6; ++cl)
+    {
+        Temp[cl] = 0;
+    }
+    LastStep = 0;
+}
+
+// Map a PWM channel to the thermal cluster of the outputs it drives
+void DLK_ThermalDerating::Derate_MapChannel(uint8_t pwm_chan, uint8_t therm_cluster)
+{
+    if ((pwm_chan < PWM_CHAN1) || (pwm_chan > PWM_CHAN7) ||
+        ((therm_cluster > TEMP_CL6) && (therm_cluster != DERATE_NO_CLUSTER)))
+    {
+        return;
+    }
+    ChanCluster[pwm_chan - 1] = therm_cluster;
+}
+
+// Set the nominal duty cycle of a PWM channel (written derated) - CR13 to CR16
+void DLK_ThermalDerating::Derate_SetDuty(uint8_t pwm_chan, uint16_t duty)
+{
+    if ((pwm_chan < PWM_CHAN1) || (pwm_chan > PWM_CHAN7))
+    {
+        return;
+    }
+    Nominal[pwm_chan - 1] = (duty > PWM_DC_MAX) ? PWM_DC_MAX : duty;
+    Written[pwm_chan - 1] = PWM_DC_MAX + 1;     // force write
+    Derate_Update();
+}
+
+// Run a derating step
+void DLK_ThermalDerating::Derate_Tick(void)
+{
+    uint8_t used = 0;
+    uint8_t temp_limit;
+    float temp;
+
+    if (!TIMER_EXPIRED(LastStep, DERATE_STEP_MS))
+    {
+        return;
+    }
+    LastStep = millis();
+
+    // mapped clusters
+    for (uint8_t i = 0; i < PWM_CHAN7; ++i)
+    {
+        if (ChanCluster[i] != DERATE_NO_CLUSTER)
+        {
+            used |= 1 << ChanCluster[i];
+        }
+    }
+    if (used == 0)
+    {
+        return;
+    }
+
+    L99->L99DZ200G_BeginSession();
+
+    for (uint8_t cl = TEMP_CL1; cl <= TEMP_CL6; ++cl)
+    {
+        if ((used & (1 << cl)) == 0)
+        {
+            continue;
+        }
+
+        // thermal warning: step the limit down, else let it recover
+        if (L99->L99DZ200G_GetThermalWarningStatus(TW_CL1_ITEM + cl) != L99DZ200G_OK)
+        {
+            L99->L99DZ200G_ClearThermalWarningStatus(TW_CL1_ITEM + cl);
+            TwLimit[cl] = (TwLimit[cl] > (DERATE_MIN_PCT + DERATE_TW_STEP_PCT)) ?
+                          (TwLimit[cl] - DERATE_TW_STEP_PCT) : DERATE_MIN_PCT;
+        }
+        else
+        {
+            TwLimit[cl] = (TwLimit[cl] < (100 - DERATE_RECOVER_PCT)) ?
+                          (TwLimit[cl] + DERATE_RECOVER_PCT) : 100;
+        }
+
+        // temperature: linear between DERATE_START_C and DERATE_FULL_C
+        temp = L99->L99DZ200G_GetThermalClusterTemp(cl);
+        Temp[cl] = temp;
+        if (temp <= DERATE_START_C)
+        {
+            temp_limit = 100;
+        }
+        else if (temp >= DERATE_FULL_C)
+        {
+            temp_limit = DERATE_MIN_PCT;
+        }
+        else
+        {
+            temp_limit = 100 - (uint8_t)(((temp - DERATE_START_C) * (100 - DERATE_MIN_PCT)) /
+                                         (DERATE_FULL_C - DERATE_START_C));
+        }
+
+        Limit[cl] = (temp_limit < TwLimit[cl]) ? temp_limit : TwLimit[cl];
+    }
+
+    Derate_Update();
+
+    L99->L99DZ200G_EndSession();
+}
+
+// Get the power limit of a thermal cluster
+uint8_t DLK_ThermalDerating::Derate_Limit(uint8_t therm_cluster)
+{
+    return (therm_cluster <= TEMP_CL6) ? Limit[therm_cluster] : 100;
+}
+
+// Get the last temperature read of a thermal cluster
+float DLK_ThermalDerating::Derate_Temp(uint8_t therm_cluster)
+{
+    return (therm_cluster <= TEMP_CL6) ? Temp[therm_cluster] : 0;
+}
+
+// Check if any thermal cluster is derated
+bool DLK_ThermalDerating::Derate_Active(void)
+{
+    for (uint8_t i = 0; i < PWM_CHAN7; ++i)
+    {
+        if ((ChanCluster[i] != DERATE_NO_CLUSTER) && (Limit[ChanCluster[i]] < 100))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Write the derated duty cycles that changed
+void DLK_ThermalDerating::Derate_Update(void)
+{
+    uint16_t duty[PWM_CHAN7];
+    uint8_t chan_mask = 0;
+
+    for (uint8_t i = 0; i < PWM_CHAN7; ++i)
+    {
+        duty[i] = Nominal[i];
+        if (ChanCluster[i] != DERATE_NO_CLUSTER)
+        {
+            duty[i] = ((uint32_t)Nominal[i] * Limit[ChanCluster[i]]) / 100;
+        }
+        if (duty[i] != Written[i])
+        {
+            chan_mask |= PWM_CHAN_BIT(i + 1);
+            Written[i] = duty[i];
+        }
+    }
+
+    if (chan_mask != 0)
+    {
+        L99->L99DZ200G_SetPWMDutyCycles(chan_mask, duty);
+    }
+}
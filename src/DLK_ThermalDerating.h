@@ -0,0 +1,143 @@
+/** \file DLK_ThermalDerating.h */
+/*
+ * NAME: DLK_ThermalDerating.h
+ *
+ * WHAT:
+ *  Header file for DLK_ThermalDerating Arduino L99DZ200G thermal derating manager class.
+ *
+ *  PWM channels are mapped to the thermal cluster holding the outputs they drive. The
+ *  application sets each channel's nominal duty cycle through the manager, which writes the
+ *  duty cycle scaled by the power limit of the channel's cluster:
+ *   - temperature limit: 100% up to DERATE_START_C, falling linearly to DERATE_MIN_PCT at
+ *     DERATE_FULL_C (from the cluster temperature, L99DZ200G_GetThermalClusterTemp)
+ *   - thermal warning limit: lowered by DERATE_TW_STEP_PCT each step the cluster thermal
+ *     warning is set (L99DZ200G_GetThermalWarningStatus), raised again by
+ *     DERATE_RECOVER_PCT each step it is clear
+ *  The lower of the two limits is used, so the loads keep running at reduced power instead
+ *  of reaching thermal shutdown and waiting for recovery.
+ *
+ * SPECIAL CONSIDERATIONS:
+ *  The outputs of each thermal cluster are given in the L99DZ200G datasheet; the mapping of
+ *  PWM channels to clusters depends on which outputs the application drives with them.
+ *  Only mapped clusters are read, and duty cycles are only written when they change (all
+ *  changed channels in one L99DZ200G_SetPWMDutyCycles() call).
+ *
+ * AUTHOR:
+ *  D.L. Karmann
+ *
+ */
+#ifndef __DLK_THERMALDERATING_H__
+#define __DLK_THERMALDERATING_H__
+
+#include "Arduino.h"
+#include "DLK_L99DZ200G.h"
+
+#define DERATE_STEP_MS          250     // derating step interval (mS)
+#define DERATE_START_C          110.0F  // cluster temperature derating starts at (C)
+#define DERATE_FULL_C           140.0F  // cluster temperature derating reaches DERATE_MIN_PCT at (C)
+#define DERATE_MIN_PCT          20      // lowest power limit (%)
+#define DERATE_TW_STEP_PCT      10      // power limit decrease per step with thermal warning (%)
+#define DERATE_RECOVER_PCT      2       // power limit increase per step without thermal warning (%)
+#define DERATE_NO_CLUSTER       0xFF    // PWM channel not mapped to a thermal cluster
+
+/**
+ * DLK_ThermalDerating Arduino L99DZ200G thermal derating manager class.
+ */
+class DLK_ThermalDerating
+{
+    public:
+        // Constructor
+        /**
+         *  A constructor that sets up the thermal derating manager.
+         *
+         *  \param l99dz200g: the L99DZ200G driving the loads
+         *
+         *  \return None.
+         */
+        DLK_ThermalDerating(DLK_L99DZ200G & l99dz200g);
+
+        /**
+         * Map a PWM channel to the thermal cluster of the outputs it drives.
+         *
+         * \param pwm_chan: the PWM channel: (PWM_CHAN1 to PWM_CHAN7)
+         * \param therm_cluster: the Thermal Cluster:
+         *                       (TEMP_CL1, TEMP_CL2, TEMP_CL3, TEMP_CL4, TEMP_CL5, TEMP_CL6,
+         *                        DERATE_NO_CLUSTER)
+         *
+         *  \return None.
+         */
+        void Derate_MapChannel(uint8_t pwm_chan, uint8_t therm_cluster);
+
+        /**
+         * Set the nominal duty cycle of a PWM channel (written derated) - CR13 to CR16.
+         *
+         * \param pwm_chan: the PWM channel: (PWM_CHAN1 to PWM_CHAN7)
+         * \param duty: the nominal raw PWM duty cycle: (0 to PWM_DC_MAX)
+         *
+         *  \return None.
+         */
+        void Derate_SetDuty(uint8_t pwm_chan, uint16_t duty);
+
+        /**
+         * Run a derating step (call often from loop()). Does nothing until the next
+         * DERATE_STEP_MS step.
+         *
+         *  \return None.
+         */
+        void Derate_Tick(void);
+
+        /**
+         * Get the power limit of a thermal cluster.
+         *
+         * \param therm_cluster: the Thermal Cluster: (TEMP_CL1 to TEMP_CL6)
+         *
+         * \return   uint8_t = the power limit: (DERATE_MIN_PCT to 100%)
+         */
+        uint8_t Derate_Limit(uint8_t therm_cluster);
+
+        /**
+         * Get the last temperature read of a thermal cluster.
+         *
+         * \param therm_cluster: the Thermal Cluster: (TEMP_CL1 to TEMP_CL6)
+         *
+         * \return   float = the temperature (Celsius)
+         */
+        float Derate_Temp(uint8_t therm_cluster);
+
+        /**
+         * Check if any thermal cluster is derated.
+         *
+         * \return   true = a mapped cluster power limit is below 100%
+         * \return   false = no cluster is derated
+         */
+        bool Derate_Active(void);
+
+    private:
+        /// L99DZ200G driving the loads
+        DLK_L99DZ200G * L99;
+
+        /// thermal cluster of each PWM channel (DERATE_NO_CLUSTER = none)
+        uint8_t ChanCluster[PWM_CHAN7];
+
+        /// nominal duty cycle of each PWM channel
+        uint16_t Nominal[PWM_CHAN7];
+
+        /// duty cycle written to each PWM channel
+        uint16_t Written[PWM_CHAN7];
+
+        /// thermal warning power limit of each cluster (%)
+        uint8_t TwLimit[TEMP_CL6 + 1];
+
+        /// power limit of each cluster (%)
+        uint8_t Limit[TEMP_CL6 + 1];
+
+        /// last temperature read of each cluster (C)
+        float Temp[TEMP_CL6 + 1];
+
+        /// time (mS) of the last step
+        uint32_t LastStep;
+
+        /// Write the derated duty cycles that changed
+        void Derate_Update(void);
+};
+#endif  // __DLK_THERMALDERATING_H__
@@ -98,6 +98,22 @@
 #endif
 
 
+#if 1   // L99DZ200G Device Information Registers ROM Addresses
+#define ROM_ID_HEADER           0x00
+#define ROM_VERSION             0x01
+#define ROM_PRODUCT_CODE_1      0x02
+#define ROM_PRODUCT_CODE_2      0x03
+#define ROM_SILICON_VERSION     0x0A
+#define ROM_SPI_FRAME_ID        0x10
+#define ROM_WD_TYPE_1           0x11
+#define ROM_WD_TYPE_2           0x12
+#define ROM_WD_BIT_POS_1        0x13
+#define ROM_WD_BIT_POS_2        0x14
+
+#define ROM_SIZE                (ROM_WD_BIT_POS_2 + 1)  // cached ROM addresses 0x00 to 0x14
+#endif
+
+
 #if 1   // L99DZ200G Registers Defines
 #define FULL_REG_MASK           0xFFFFFF
 
@@ -741,6 +757,10 @@
 #define PWM_CHAN6               6
 #define PWM_CHAN7               7
 
+// PWM channel bit masks (bulk duty cycle update)
+#define PWM_CHAN_BIT(chan)      (1 << ((chan) - 1))
+#define PWM_CHAN_ALL            0x7F
+
 // -------- CR13 - CR16 ----------------------------------------------------------------------------
 
 // CR13 to CR16
@@ -750,6 +770,14 @@
 #define HI_PWM_DC_POS           12
 #define LO_PWM_DC_POS           0
 
+#define PWM_DC_MAX              1023        // 10 bit duty cycle (100%)
+
+// perceptual brightness dimming (L99DZ200G_SetPWMBrightness)
+#define PWM_LEVEL_MAX           255         // full brightness level
+#define PWM_MIN_ON_US           50          // shortest HS output on time kept linear (uS)
+// lowest duty cycle giving PWM_MIN_ON_US on time at a PWM frequency (Hz)
+#define PWM_MIN_ON_DUTY(freq_val)   ((((uint32_t)PWM_MIN_ON_US * (freq_val) * (PWM_DC_MAX + 1)) + 999999UL) / 1000000UL)
+
 // -------- CR17 - CR20 ----------------------------------------------------------------------------
 
 // CR17 to CR20